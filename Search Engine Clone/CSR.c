@@ -1,350 +1,1609 @@
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <math.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+#include "CSR.h"
+#include "Crawler.h"
 
 #define EPSILON_MIN 1e-5
+#define CSR_PARALLEL_MIN_BYTES (16 << 20)   // Link file bytes per extra build thread
+#define CSR_MAX_BUILD_THREADS 64
 
-// CSR structure definition
-typedef struct {
-    int32_t n;           // number of files (rows)
-    int32_t nnz;         // number of non-zero edges
-    int32_t *row_ptr;    // length n+1
-    int32_t *col_idx;    // length nnz
-    int32_t *outdeg;     // length n
-} CSR;
-
-// Helper function to count lines in a file
-static int32_t count_lines(const char *filepath) {
-    FILE *fp = fopen(filepath, "r");
-    if (!fp) return -1;
+// Does the file start with the binary edge list magic?
+static int is_edge_list(const char *filepath) {
+    FILE *fp = fopen(filepath, "rb");
+    if (!fp) return 0;
+    
+    uint32_t magic = 0;
+    size_t got = fread(&magic, sizeof(magic), 1, fp);
+    fclose(fp);
+    return got == 1 && magic == CSR_EDGES_MAGIC;
+}
+
+// Checksum of data[0..bytes), continuing from seed
+// Four independent multiply-rotate lanes over 8-byte words, so hashing runs
+// at memory speed; the tail is zero-padded into one last word.
+static uint64_t csr_checksum(uint64_t seed, const void *data, size_t bytes) {
+    const uint64_t mul = 0x9E3779B97F4A7C15ull;
+    const unsigned char *p = data;
+    uint64_t lane[4] = { seed, seed ^ 0x1111, seed ^ 0x2222, seed ^ 0x3333 };
+    size_t i = 0;
+    
+    for (; i + 32 <= bytes; i += 32) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t w;
+            memcpy(&w, p + i + 8 * l, sizeof(w));
+            uint64_t x = (lane[l] ^ w) * mul;
+            lane[l] = (x << 31) | (x >> 33);
+        }
+    }
+    for (int l = 0; i < bytes; l = (l + 1) & 3, i += 8) {
+        uint64_t w = 0;
+        memcpy(&w, p + i, bytes - i < 8 ? bytes - i : 8);
+        uint64_t x = (lane[l] ^ w) * mul;
+        lane[l] = (x << 31) | (x >> 33);
+    }
+    
+    uint64_t h = (uint64_t)bytes;
+    for (int l = 0; l < 4; l++) {
+        h = (h ^ lane[l]) * mul;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+// Checksum of the three sections of a v2 file, as stored in data_checksum
+static uint64_t csr_data_checksum(int64_t n, int64_t nnz, const int32_t *row_ptr,
+                                  const int32_t *col_idx, const int32_t *outdeg) {
+    uint64_t h = csr_checksum(CSR_FILE_MAGIC, row_ptr, (size_t)(n + 1) * sizeof(int32_t));
+    h = csr_checksum(h, col_idx, (size_t)nnz * sizeof(int32_t));
+    return csr_checksum(h, outdeg, (size_t)n * sizeof(int32_t));
+}
+
+static uint64_t csr_header_checksum(const CSRFileHeader *h) {
+    return csr_checksum(CSR_FILE_MAGIC, h, offsetof(CSRFileHeader, header_checksum));
+}
+
+static uint64_t adj_header_checksum(const CSRAdjFileHeader *h) {
+    return csr_checksum(CSR_ADJ_MAGIC, h, offsetof(CSRAdjFileHeader, header_checksum));
+}
+
+// Checksum of the index and stream of a compressed file
+static uint64_t adj_data_checksum(const CSRAdjBlock *index, int64_t blocks,
+                                  const uint8_t *adj, int64_t adj_bytes) {
+    uint64_t h = csr_checksum(CSR_ADJ_MAGIC, index, (size_t)(blocks + 1) * sizeof(CSRAdjBlock));
+    return csr_checksum(h, adj, (size_t)adj_bytes);
+}
+
+static int64_t align_up(int64_t x) {
+    return (x + CSR_FILE_ALIGN - 1) & ~(int64_t)(CSR_FILE_ALIGN - 1);
+}
+
+// Write data[0..bytes) and zero-pad to the next CSR_FILE_ALIGN boundary
+static void write_section(FILE *fp, const void *data, int64_t bytes) {
+    static const char zeros[CSR_FILE_ALIGN];
+    if (bytes > 0) fwrite(data, 1, (size_t)bytes, fp);
+    fwrite(zeros, 1, (size_t)(align_up(bytes) - bytes), fp);
+}
+
+// Write the CSR binary file (version 2, see CSRFileHeader)
+static int write_csr_file(const char *csr_out_path, int32_t n, int32_t nnz,
+                          const int32_t *row_ptr, const int32_t *col_idx,
+                          const int32_t *outdeg) {
+    FILE *csr_fp = fopen(csr_out_path, "wb");
+    if (!csr_fp) {
+        fprintf(stderr, "Error: Could not open CSR output file\n");
+        return -1;
+    }
+    
+    // Header page, then one aligned section per array
+    union {
+        CSRFileHeader h;
+        char page[CSR_FILE_ALIGN];
+    } head;
+    memset(&head, 0, sizeof(head));
+    head.h.magic = CSR_FILE_MAGIC;
+    head.h.version = CSR_FILE_VERSION;
+    head.h.endian_tag = CSR_FILE_ENDIAN_TAG;
+    head.h.index_bytes = sizeof(int32_t);
+    head.h.n = n;
+    head.h.nnz = nnz;
+    head.h.row_ptr_off = CSR_FILE_ALIGN;
+    head.h.col_idx_off = head.h.row_ptr_off + align_up(((int64_t)n + 1) * sizeof(int32_t));
+    head.h.outdeg_off = head.h.col_idx_off + align_up((int64_t)nnz * sizeof(int32_t));
+    head.h.file_bytes = head.h.outdeg_off + align_up((int64_t)n * sizeof(int32_t));
+    head.h.data_checksum = csr_data_checksum(n, nnz, row_ptr, col_idx, outdeg);
+    head.h.header_checksum = csr_header_checksum(&head.h);
+    fwrite(head.page, 1, sizeof(head.page), csr_fp);
+    
+    // Write arrays
+    write_section(csr_fp, row_ptr, ((int64_t)n + 1) * sizeof(int32_t));
+    write_section(csr_fp, col_idx, (int64_t)nnz * sizeof(int32_t));
+    write_section(csr_fp, outdeg, (int64_t)n * sizeof(int32_t));
+    
+    int failed = ferror(csr_fp);
+    if (fclose(csr_fp) != 0 || failed) {
+        fprintf(stderr, "Error: Could not write CSR output file\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Build CSR from the crawler's binary edge list, and write graph + nodes files
+// Rows are node indices already, so building is a counting sort of the edges
+// by source (stable, so each row keeps the crawler's ascending order).
+int csr_build_from_edges(const char *edges_path,
+                         const char *csr_out_path,
+                         const char *nodes_out_path) {
+    FILE *fp = fopen(edges_path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Error: Could not open edge list file\n");
+        return -1;
+    }
     
-    int32_t count = 0;
-    char buffer[4096];
-    while (fgets(buffer, sizeof(buffer), fp)) {
-        count++;
+    // Read header
+    uint32_t magic, version;
+    int32_t n, reserved;
+    int64_t strtab_bytes, edge_count;
+    if (fread(&magic, sizeof(magic), 1, fp) != 1 ||
+        fread(&version, sizeof(version), 1, fp) != 1 ||
+        fread(&n, sizeof(n), 1, fp) != 1 ||
+        fread(&reserved, sizeof(reserved), 1, fp) != 1 ||
+        fread(&strtab_bytes, sizeof(strtab_bytes), 1, fp) != 1 ||
+        fread(&edge_count, sizeof(edge_count), 1, fp) != 1 ||
+        magic != CSR_EDGES_MAGIC || version != CSR_EDGES_VERSION ||
+        n <= 0 || strtab_bytes < 0 || edge_count < 0 || edge_count > INT32_MAX) {
+        fprintf(stderr, "Error: Invalid edge list header\n");
+        fclose(fp);
+        return -1;
+    }
+    int32_t nnz = (int32_t)edge_count;
+    
+    // Read string table and edges in one go
+    char *strtab = malloc((size_t)strtab_bytes + 1);
+    int32_t *edges = malloc(((size_t)nnz * 2 + 1) * sizeof(int32_t));
+    int32_t *row_ptr = calloc((size_t)n + 1, sizeof(int32_t));
+    int32_t *col_idx = malloc(((size_t)nnz + 1) * sizeof(int32_t));
+    int32_t *outdeg = calloc((size_t)n, sizeof(int32_t));
+    if (!strtab || !edges || !row_ptr || !col_idx || !outdeg) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        goto fail;
+    }
+    if (fread(strtab, 1, (size_t)strtab_bytes, fp) != (size_t)strtab_bytes ||
+        fread(edges, sizeof(int32_t) * 2, (size_t)nnz, fp) != (size_t)nnz) {
+        fprintf(stderr, "Error: Edge list file is truncated\n");
+        goto fail;
+    }
+    strtab[strtab_bytes] = '\0';
+    
+    // Write nodes file (index to filename/filepath mapping)
+    FILE *nodes_fp = fopen(nodes_out_path, "w");
+    if (!nodes_fp) {
+        fprintf(stderr, "Error: Could not open nodes output file\n");
+        goto fail;
+    }
+    const char *s = strtab;
+    const char *strtab_end = strtab + strtab_bytes;
+    for (int32_t i = 0; i < n; i++) {
+        const char *path = s;
+        const char *name = (s < strtab_end) ? s + strlen(s) + 1 : strtab_end;
+        if (name >= strtab_end) {
+            fprintf(stderr, "Error: Edge list string table is truncated\n");
+            fclose(nodes_fp);
+            goto fail;
+        }
+        fprintf(nodes_fp, "%s|%s\n", path, name);
+        s = name + strlen(name) + 1;
+    }
+    fclose(nodes_fp);
+    
+    // Count edges per source row
+    for (int32_t e = 0; e < nnz; e++) {
+        int32_t src = edges[2 * e], dst = edges[2 * e + 1];
+        if (src < 0 || src >= n || dst < 0 || dst >= n) {
+            fprintf(stderr, "Error: Edge %d out of range\n", e);
+            goto fail;
+        }
+        outdeg[src]++;
+    }
+    
+    // Prefix sum into row_ptr, then place each edge in its row
+    // (outdeg is recounted as the fill cursor of each row)
+    for (int32_t i = 0; i < n; i++) {
+        row_ptr[i + 1] = row_ptr[i] + outdeg[i];
+        outdeg[i] = 0;
+    }
+    for (int32_t e = 0; e < nnz; e++) {
+        int32_t src = edges[2 * e], dst = edges[2 * e + 1];
+        col_idx[row_ptr[src] + outdeg[src]++] = dst;
+    }
+    
+    if (write_csr_file(csr_out_path, n, nnz, row_ptr, col_idx, outdeg) != 0) {
+        goto fail;
     }
+    
+    fclose(fp);
+    free(strtab);
+    free(edges);
+    free(row_ptr);
+    free(col_idx);
+    free(outdeg);
+    
+    printf("CSR built successfully: n=%d, nnz=%d\n", n, nnz);
+    return 0;
+
+fail:
     fclose(fp);
-    return count;
+    free(strtab);
+    free(edges);
+    free(row_ptr);
+    free(col_idx);
+    free(outdeg);
+    return -1;
 }
 
-// Helper function to parse a single line from struct file
-// Returns: 0 on success, -1 on failure
-static int parse_line(char *line, char *filepath, char *filename, 
-                     char **outlinks, int32_t *outlink_count) {
-    *outlink_count = 0;
+// Write a crawl_dir() graph as graph + nodes files
+// The graph is already in CSR form; only the out-degrees are derived.
+int csr_build_from_graph(const CrawlGraph *g,
+                         const char *csr_out_path,
+                         const char *nodes_out_path) {
+    if (g->n <= 0) {
+        fprintf(stderr, "Error: Crawled graph has no files\n");
+        return -1;
+    }
     
-    // Format: <file path>|<file name>|[<inlinks>]|[<outlinks>]
-    char *token = strtok(line, "|");
-    if (!token) return -1;
-    strcpy(filepath, token);
+    // Write nodes file (index to filename/filepath mapping)
+    FILE *nodes_fp = fopen(nodes_out_path, "w");
+    if (!nodes_fp) {
+        fprintf(stderr, "Error: Could not open nodes output file\n");
+        return -1;
+    }
+    for (int32_t i = 0; i < g->n; i++) {
+        fprintf(nodes_fp, "%s|%s\n", g->paths[i], g->names[i]);
+    }
+    if (fclose(nodes_fp) != 0) {
+        fprintf(stderr, "Error: Could not write nodes output file\n");
+        return -1;
+    }
     
-    token = strtok(NULL, "|");
-    if (!token) return -1;
-    strcpy(filename, token);
+    int32_t *outdeg = malloc((size_t)g->n * sizeof(int32_t));
+    if (!outdeg) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    for (int32_t i = 0; i < g->n; i++) {
+        outdeg[i] = g->row_ptr[i + 1] - g->row_ptr[i];
+    }
     
-    // Skip inlinks
-    token = strtok(NULL, "|");
-    if (!token) return -1;
+    int ret = write_csr_file(csr_out_path, g->n, g->nnz, g->row_ptr, g->col_idx, outdeg);
+    free(outdeg);
+    if (ret == 0) {
+        printf("CSR built successfully: n=%d, nnz=%d\n", g->n, g->nnz);
+    }
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+// Streaming text builder
+// ---------------------------------------------------------------------------
+// The link file is mapped and read once, front to back. Names are interned
+// as they are met (as a node or as an outlink), so col_idx first holds name
+// ids; once every node is known the ids are resolved to rows in one pass
+// over col_idx, dropping names that no node has. Strings stay in the
+// mapping: memory is the name table plus 4 bytes per edge and 20 per node,
+// with no limit on line length or outlinks per line.
+
+// NameEntry: One distinct name (points into the mapped file)
+typedef struct {
+    const char *name;           // Not NUL-terminated
+    uint32_t len;
+    uint32_t hash;
+    int32_t node;               // First row with this name, -1 if only an outlink
+} NameEntry;
+
+// NameTable: Open addressing over every distinct name, in order of appearance
+typedef struct {
+    NameEntry *entries;
+    int32_t count;
+    int32_t capacity;
+    int32_t *slots;             // Entry index, -1 = empty
+    uint32_t mask;              // slots has mask + 1 entries
+} NameTable;
+
+// NodeSpan: Path of one row and its name (entry index)
+typedef struct {
+    const char *path;
+    uint32_t path_len;
+    int32_t name;
+} NodeSpan;
+
+// LinkLine: Fields of one line (pointers into the mapped file)
+typedef struct {
+    const char *path;
+    const char *name;
+    uint32_t path_len;
+    uint32_t name_len;
+    const char *links;          // The '[' opening the outlinks, NULL if malformed
+} LinkLine;
+
+// Find the first of a, b or c in [p, end), or end if there is none
+static const char *find_delim(const char *p, const char *end, char a, char b, char c) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                                   _mm_cmpeq_epi8(v, vc));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != a && *p != b && *p != c) p++;
+    return p;
+}
+
+// Split the (non-blank) line at p into path, name and the outlink list
+// Line format: <file path>|<file name>|[<inlinks>]|[<outlinks>]
+// Returns where parsing stopped: the '[' of the outlinks, or for a malformed
+// line (line->links == NULL) the newline or end it ran into
+static const char *parse_line_fields(const char *p, const char *end, LinkLine *line) {
+    const char *field[3], *field_end[3];
+    const char *q = p;
+    int fields = 0;
+    while (fields < 3) {
+        const char *bar = find_delim(q, end, '|', '\n', '\n');
+        field[fields] = q;
+        field_end[fields++] = bar;
+        q = bar;
+        if (bar == end || *bar != '|') break;
+        q = bar + 1;
+    }
+    int malformed = (fields < 3 || q == field_end[2]);
+    for (int f = fields; f < 3; f++) {
+        field[f] = field_end[f] = q;
+    }
+    line->path = field[0];
+    line->path_len = (uint32_t)(field_end[0] - field[0]);
+    line->name = field[1];
+    line->name_len = (uint32_t)(field_end[1] - field[1]);
+    line->links = NULL;
+    if (!malformed) {
+        q = find_delim(q, end, '[', '\n', '\n');
+        if (q < end && *q == '[') line->links = q;
+    }
+    return q;
+}
+
+// Take the next name of the outlink list at *q (which starts at its '[' or
+// at the ',' / ']' the previous call stopped on)
+// Returns 1 with the name in tok[0..*len), 0 at the closing ']', or -1 if
+// the list never closes (*q is then the newline or end)
+static int next_outlink(const char **q, const char *end, const char **tok, uint32_t *len) {
+    while (**q != ']') {
+        const char *t = *q + 1;
+        *q = find_delim(t, end, ',', ']', '\n');
+        if (*q == end || **q == '\n') return -1;
+        while (t < *q && *t == ' ') t++;
+        if (t < *q) {
+            *tok = t;
+            *len = (uint32_t)(*q - t);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// End of the line whose parsing stopped at q
+static const char *next_line(const char *q, const char *end) {
+    const char *nl = (q < end && *q == '\n') ? q : memchr(q, '\n', (size_t)(end - q));
+    return nl ? nl + 1 : end;
+}
+
+// djb2, spread over the table bits
+static uint32_t name_hash(const char *name, uint32_t len) {
+    uint32_t hash = 5381;
+    for (uint32_t i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + (unsigned char)name[i];
+    }
+    return hash * 0x9E3779B1u;
+}
+
+// Grow an array of `size`-byte elements to hold at least `need` of them
+static int grow_array(void **array, int32_t *capacity, int64_t need, size_t size) {
+    if (need <= *capacity) return 0;
+    if (need > INT32_MAX) {
+        fprintf(stderr, "Error: Graph has more than %d nodes or edges\n", INT32_MAX);
+        return -1;
+    }
+    int64_t new_capacity = *capacity ? (int64_t)*capacity * 2 : 1024;
+    if (new_capacity < need) new_capacity = need;
+    if (new_capacity > INT32_MAX) new_capacity = INT32_MAX;
+    void *grown = realloc(*array, (size_t)new_capacity * size);
+    if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    *array = grown;
+    *capacity = (int32_t)new_capacity;
+    return 0;
+}
+
+// Double the slot array and re-insert every entry
+static int name_table_grow(NameTable *t) {
+    uint32_t slot_count = t->slots ? (t->mask + 1) * 2 : 4096;
+    int32_t *slots = malloc((size_t)slot_count * sizeof(int32_t));
+    if (!slots) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    memset(slots, 0xff, (size_t)slot_count * sizeof(int32_t));
+    for (int32_t e = 0; e < t->count; e++) {
+        uint32_t slot = t->entries[e].hash & (slot_count - 1);
+        while (slots[slot] != -1) slot = (slot + 1) & (slot_count - 1);
+        slots[slot] = e;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->mask = slot_count - 1;
+    return 0;
+}
+
+// Return the entry index of name[0..len), adding it if it is new (-1 on failure)
+static int32_t name_intern(NameTable *t, const char *name, uint32_t len) {
+    uint32_t hash = name_hash(name, len);
+    if (!t->slots || (uint32_t)t->count >= (t->mask + 1) / 2) {
+        if (name_table_grow(t) != 0) return -1;
+    }
+    uint32_t slot = hash & t->mask;
+    while (t->slots[slot] != -1) {
+        const NameEntry *e = &t->entries[t->slots[slot]];
+        if (e->hash == hash && e->len == len && memcmp(e->name, name, len) == 0) {
+            return t->slots[slot];
+        }
+        slot = (slot + 1) & t->mask;
+    }
+
+    if (grow_array((void **)&t->entries, &t->capacity, (int64_t)t->count + 1,
+                   sizeof(NameEntry)) != 0) {
+        return -1;
+    }
+    t->entries[t->count] = (NameEntry){ name, len, hash, -1 };
+    t->slots[slot] = t->count;
+    return t->count++;
+}
+
+// Map (or, if that fails, read) the whole file. *mapped says which
+// Returns 0 on success, -1 on failure (an empty file is a failure)
+static int load_text(const char *path, const char **data, size_t *size, int *mapped) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+        if (fd != -1) close(fd);
+        return -1;
+    }
+    *size = (size_t)st.st_size;
+    void *map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+        madvise(map, *size, MADV_SEQUENTIAL);
+        close(fd);
+        *data = map;
+        *mapped = 1;
+        return 0;
+    }
+
+    char *buf = malloc(*size);
+    size_t got = 0;
+    while (buf && got < *size) {
+        ssize_t r = read(fd, buf + got, *size - got);
+        if (r <= 0) break;
+        got += (size_t)r;
+    }
+    close(fd);
+    if (!buf || got != *size) {
+        free(buf);
+        return -1;
+    }
+    *data = buf;
+    *mapped = 0;
+    return 0;
+}
+
+// Sequential build of data[0..size) into graph + nodes files
+static int build_text_sequential(const char *data, size_t size,
+                                 const char *csr_out_path,
+                                 const char *nodes_out_path) {
+    NameTable names = {0};
+    NodeSpan *nodes = NULL;
+    int32_t *row_ptr = NULL, *col_idx = NULL, *outdeg = NULL;
+    int32_t node_cap = 0, row_cap = 0, col_cap = 0;
+    int32_t n = 0;
+    int64_t nnz = 0;
+    int ret = -1;
+    
+    // Single pass: one row per line, outlinks as name ids
+    if (grow_array((void **)&row_ptr, &row_cap, 1, sizeof(int32_t)) != 0) goto done;
+    row_ptr[0] = 0;
+    const char *end = data + size;
+    for (const char *p = data; p < end; ) {
+        if (*p == '\n') {
+            p++;
+            continue;
+        }
+        
+        LinkLine line;
+        const char *q = parse_line_fields(p, end, &line);
+        if (grow_array((void **)&nodes, &node_cap, (int64_t)n + 1, sizeof(NodeSpan)) != 0 ||
+            grow_array((void **)&row_ptr, &row_cap, (int64_t)n + 2, sizeof(int32_t)) != 0) {
+            goto done;
+        }
+        int32_t name = name_intern(&names, line.name, line.name_len);
+        if (name < 0) goto done;
+        if (names.entries[name].node == -1) {
+            names.entries[name].node = n;   // The first row with a name owns it
+        }
+        nodes[n] = (NodeSpan){ line.path, line.path_len, name };
+        
+        // Outlinks: comma-separated names between '[' and ']'
+        int more = line.links ? 1 : -1;
+        const char *tok;
+        uint32_t tok_len;
+        while (more == 1 && (more = next_outlink(&q, end, &tok, &tok_len)) == 1) {
+            if (grow_array((void **)&col_idx, &col_cap, nnz + 1, sizeof(int32_t)) != 0) {
+                goto done;
+            }
+            int32_t id = name_intern(&names, tok, tok_len);
+            if (id < 0) goto done;
+            col_idx[nnz++] = id;
+        }
+        if (more == -1) {
+            fprintf(stderr, "Error parsing line %d\n", n);
+            nnz = row_ptr[n];       // Keep the row, without outlinks
+        }
+        row_ptr[++n] = (int32_t)nnz;
+        p = next_line(q, end);
+    }
+    if (n <= 0) {
+        fprintf(stderr, "Error: Could not read struct file\n");
+        goto done;
+    }
     
-    // Parse outlinks
-    token = strtok(NULL, "|");
-    if (!token) return -1;
+    // Write nodes file (index to filename/filepath mapping)
+    FILE *nodes_fp = fopen(nodes_out_path, "w");
+    if (!nodes_fp) {
+        fprintf(stderr, "Error: Could not open nodes output file\n");
+        goto done;
+    }
+    for (int32_t i = 0; i < n; i++) {
+        const NameEntry *e = &names.entries[nodes[i].name];
+        fprintf(nodes_fp, "%.*s|%.*s\n", (int)nodes[i].path_len, nodes[i].path,
+                (int)e->len, e->name);
+    }
+    fclose(nodes_fp);
+    
+    // Resolve name ids to rows in place, keeping only names that are rows
+    outdeg = malloc((size_t)n * sizeof(int32_t));
+    if (!outdeg) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        goto done;
+    }
+    int32_t kept = 0;
+    for (int32_t i = 0; i < n; i++) {
+        int32_t row_start = kept;
+        for (int32_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            int32_t dest_idx = names.entries[col_idx[k]].node;
+            if (dest_idx >= 0) col_idx[kept++] = dest_idx;
+        }
+        row_ptr[i] = row_start;
+        outdeg[i] = kept - row_start;
+    }
+    row_ptr[n] = kept;
+    
+    // Write CSR to binary file
+    if (write_csr_file(csr_out_path, n, kept, row_ptr, col_idx, outdeg) != 0) {
+        goto done;
+    }
+    printf("CSR built successfully: n=%d, nnz=%d\n", n, kept);
+    ret = 0;
+    
+done:
+    free(names.entries);
+    free(names.slots);
+    free(nodes);
+    free(row_ptr);
+    free(col_idx);
+    free(outdeg);
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+// Parallel text builder
+// ---------------------------------------------------------------------------
+// The file is cut into one chunk of whole lines per thread; a chunk's rows
+// are consecutive, so its edges are one consecutive slice of col_idx too.
+// Each phase runs on every chunk at once; the serial steps in between only
+// touch one entry per chunk:
+//   1. Split each chunk's lines into rows (path, name, outlink list).
+//   -  Number the rows: exclusive scan of the per-chunk row counts.
+//   2. Copy the rows into one array and insert their names into a shared
+//      index with CAS; the lowest row keeps a name, as in the sequential build.
+//   3. Resolve each chunk's outlinks against the (now read-only) index into
+//      a private buffer, with local row offsets and out-degrees.
+//   -  Place the edges: exclusive scan of the per-chunk edge counts.
+//   4. Add each chunk's edge offset to its row_ptr entries and copy its
+//      edges into col_idx.
+// Output is byte-identical to build_text_sequential().
+
+// RowSpan: One row found in phase 1
+typedef struct {
+    LinkLine line;
+    uint32_t hash;              // name_hash() of the name
+} RowSpan;
+
+struct BuildChunk;
+
+// BuildShared: State every build thread sees
+typedef struct {
+    void (*phase)(struct BuildChunk *);  // Phase being run
+    int failed;                 // Set (atomically) by any chunk that failed
+    const char *data_end;       // End of the whole file
+    RowSpan *rows;              // [n] every row, in file order
+    int32_t n;
+    int32_t *slots;             // Name index: row, -1 = empty
+    uint32_t mask;              // slots has mask + 1 entries
+    int32_t *row_ptr;           // [n + 1]
+    int32_t *col_idx;           // [nnz]
+    int32_t *outdeg;            // [n]
+    int32_t nnz;
+} BuildShared;
+
+// BuildChunk: One thread's lines and results
+typedef struct BuildChunk {
+    BuildShared *shared;
+    const char *begin;          // First line of the chunk
+    const char *end;            // One past the start of its last line
+    RowSpan *rows;              // Phase 1 rows (freed once copied)
+    int32_t row_count;
+    int32_t row_cap;
+    int32_t first_row;          // Global index of rows[0]
+    int32_t *edges;             // Phase 3 resolved outlinks (freed once copied)
+    int32_t edge_count;
+    int32_t edge_cap;
+    int32_t first_edge;         // Offset of edges[0] in col_idx
+    int threaded;               // The current phase runs on its own thread
+} BuildChunk;
+
+// Report a failure to the other chunks
+static void build_fail(BuildShared *b) {
+    __atomic_store_n(&b->failed, 1, __ATOMIC_RELAXED);
+}
+
+static int build_failed(BuildShared *b) {
+    return __atomic_load_n(&b->failed, __ATOMIC_RELAXED);
+}
+
+static int same_name(const RowSpan *row, const char *name, uint32_t len, uint32_t hash) {
+    return row->hash == hash && row->line.name_len == len &&
+           memcmp(row->line.name, name, len) == 0;
+}
+
+// Insert row r into the shared name index (the lowest row keeps a name)
+static void index_insert(BuildShared *b, int32_t r) {
+    const RowSpan *row = &b->rows[r];
+    uint32_t slot = row->hash & b->mask;
+    int32_t cur = __atomic_load_n(&b->slots[slot], __ATOMIC_ACQUIRE);
+    for (;;) {
+        if (cur != -1 && !same_name(&b->rows[cur], row->line.name, row->line.name_len, row->hash)) {
+            slot = (slot + 1) & b->mask;
+            cur = __atomic_load_n(&b->slots[slot], __ATOMIC_ACQUIRE);
+            continue;
+        }
+        if (cur != -1 && cur < r) return;
+        if (__atomic_compare_exchange_n(&b->slots[slot], &cur, r, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+        // Lost the race: cur is now the row that took the slot
+    }
+}
+
+// Row named name[0..len), or -1 (only once phase 2 is complete)
+static int32_t index_find(const BuildShared *b, const char *name, uint32_t len) {
+    uint32_t hash = name_hash(name, len);
+    uint32_t slot = hash & b->mask;
+    while (b->slots[slot] != -1) {
+        if (same_name(&b->rows[b->slots[slot]], name, len, hash)) return b->slots[slot];
+        slot = (slot + 1) & b->mask;
+    }
+    return -1;
+}
+
+// Phase 1: split the chunk into rows
+static void build_split_rows(BuildChunk *c) {
+    BuildShared *b = c->shared;
+    for (const char *p = c->begin; p < c->end && !build_failed(b); ) {
+        if (*p == '\n') {
+            p++;
+            continue;
+        }
+        if (grow_array((void **)&c->rows, &c->row_cap, (int64_t)c->row_count + 1,
+                       sizeof(RowSpan)) != 0) {
+            build_fail(b);
+            return;
+        }
+        RowSpan *row = &c->rows[c->row_count++];
+        p = next_line(parse_line_fields(p, b->data_end, &row->line), b->data_end);
+        row->hash = name_hash(row->line.name, row->line.name_len);
+    }
+}
+
+// Phase 2: publish the chunk's rows and index their names
+static void build_index_rows(BuildChunk *c) {
+    BuildShared *b = c->shared;
+    if (c->row_count > 0) {
+        memcpy(b->rows + c->first_row, c->rows, (size_t)c->row_count * sizeof(RowSpan));
+    }
+    for (int32_t i = 0; i < c->row_count; i++) {
+        index_insert(b, c->first_row + i);
+    }
+    free(c->rows);
+    c->rows = NULL;
+}
+
+// Phase 3: resolve the chunk's outlinks into its private edge buffer
+static void build_resolve_links(BuildChunk *c) {
+    BuildShared *b = c->shared;
+    for (int32_t i = 0; i < c->row_count && !build_failed(b); i++) {
+        int32_t r = c->first_row + i;
+        const char *q = b->rows[r].line.links;
+        int32_t row_start = c->edge_count;
+        int more = q ? 1 : -1;
+        const char *tok;
+        uint32_t tok_len;
+        while (more == 1 && (more = next_outlink(&q, b->data_end, &tok, &tok_len)) == 1) {
+            int32_t dest_idx = index_find(b, tok, tok_len);
+            if (dest_idx < 0) continue;
+            if (grow_array((void **)&c->edges, &c->edge_cap, (int64_t)c->edge_count + 1,
+                           sizeof(int32_t)) != 0) {
+                build_fail(b);
+                return;
+            }
+            c->edges[c->edge_count++] = dest_idx;
+        }
+        if (more == -1) {
+            fprintf(stderr, "Error parsing line %d\n", r);
+            c->edge_count = row_start;  // Keep the row, without outlinks
+        }
+        b->row_ptr[r] = row_start;      // Chunk-local until phase 4
+        b->outdeg[r] = c->edge_count - row_start;
+    }
+}
+
+// Phase 4: make the row offsets global and copy the edges into col_idx
+static void build_place_edges(BuildChunk *c) {
+    BuildShared *b = c->shared;
+    for (int32_t i = 0; i < c->row_count; i++) {
+        b->row_ptr[c->first_row + i] += c->first_edge;
+    }
+    if (c->edge_count > 0) {
+        memcpy(b->col_idx + c->first_edge, c->edges, (size_t)c->edge_count * sizeof(int32_t));
+    }
+    free(c->edges);
+    c->edges = NULL;
+}
+
+static void *build_phase_thread(void *arg) {
+    BuildChunk *c = (BuildChunk *)arg;
+    c->shared->phase(c);
+    return NULL;
+}
+
+// Run `phase` on every chunk in parallel and wait for all of them
+// Chunk 0 runs on the calling thread, as does any chunk whose thread could
+// not be started, so a phase always completes.
+static void run_build_phase(BuildShared *b, BuildChunk *chunks, int num_chunks,
+                            pthread_t *threads, void (*phase)(BuildChunk *)) {
+    b->phase = phase;
+    for (int t = 1; t < num_chunks; t++) {
+        chunks[t].threaded =
+            (pthread_create(&threads[t], NULL, build_phase_thread, &chunks[t]) == 0);
+    }
+    phase(&chunks[0]);
+    for (int t = 1; t < num_chunks; t++) {
+        if (chunks[t].threaded) {
+            pthread_join(threads[t], NULL);
+        } else {
+            phase(&chunks[t]);
+        }
+    }
+}
+
+// Parallel build of data[0..size) with num_threads threads (see above)
+static int build_text_parallel(const char *data, size_t size, int num_threads,
+                               const char *csr_out_path,
+                               const char *nodes_out_path) {
+    BuildShared b;
+    memset(&b, 0, sizeof(b));
+    b.data_end = data + size;
+    BuildChunk *chunks = calloc((size_t)num_threads, sizeof(BuildChunk));
+    pthread_t *threads = malloc((size_t)num_threads * sizeof(pthread_t));
+    int ret = -1;
+    if (!chunks || !threads) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        goto done;
+    }
+    
+    // Chunk t holds the lines starting in [size * t / T, size * (t + 1) / T)
+    for (int t = 0; t < num_threads; t++) {
+        const char *begin = data + (size_t)((unsigned __int128)size * t / num_threads);
+        if (t > 0 && begin[-1] != '\n') begin = next_line(begin, b.data_end);
+        chunks[t].shared = &b;
+        chunks[t].begin = begin;
+        if (t > 0) chunks[t - 1].end = begin;
+    }
+    chunks[num_threads - 1].end = b.data_end;
+    
+    run_build_phase(&b, chunks, num_threads, threads, build_split_rows);
+    if (build_failed(&b)) goto done;
+    
+    // Number the rows and size the shared arrays
+    int64_t n = 0;
+    for (int t = 0; t < num_threads; t++) {
+        chunks[t].first_row = (int32_t)n;
+        n += chunks[t].row_count;
+    }
+    uint64_t slot_count = 4096;
+    while (slot_count < 2 * (uint64_t)n) slot_count *= 2;
+    if (n == 0) {
+        fprintf(stderr, "Error: Could not read struct file\n");
+        goto done;
+    }
+    if (n > INT32_MAX || slot_count > UINT32_MAX) {
+        fprintf(stderr, "Error: Graph has more than %d nodes or edges\n", INT32_MAX);
+        goto done;
+    }
+    b.n = (int32_t)n;
+    b.mask = (uint32_t)(slot_count - 1);
+    b.rows = malloc((size_t)n * sizeof(RowSpan));
+    b.slots = malloc((size_t)slot_count * sizeof(int32_t));
+    b.row_ptr = malloc(((size_t)n + 1) * sizeof(int32_t));
+    b.outdeg = malloc((size_t)n * sizeof(int32_t));
+    if (!b.rows || !b.slots || !b.row_ptr || !b.outdeg) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        goto done;
+    }
+    memset(b.slots, 0xff, (size_t)slot_count * sizeof(int32_t));
+    
+    run_build_phase(&b, chunks, num_threads, threads, build_index_rows);
+    run_build_phase(&b, chunks, num_threads, threads, build_resolve_links);
+    if (build_failed(&b)) goto done;
+    
+    // Place each chunk's edges
+    int64_t nnz = 0;
+    for (int t = 0; t < num_threads; t++) {
+        chunks[t].first_edge = (int32_t)nnz;
+        nnz += chunks[t].edge_count;
+        if (nnz > INT32_MAX) {
+            fprintf(stderr, "Error: Graph has more than %d nodes or edges\n", INT32_MAX);
+            goto done;
+        }
+    }
+    b.nnz = (int32_t)nnz;
+    b.row_ptr[b.n] = b.nnz;
+    b.col_idx = malloc(((size_t)nnz + 1) * sizeof(int32_t));
+    if (!b.col_idx) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        goto done;
+    }
+    run_build_phase(&b, chunks, num_threads, threads, build_place_edges);
+    
+    // Write nodes file (index to filename/filepath mapping)
+    FILE *nodes_fp = fopen(nodes_out_path, "w");
+    if (!nodes_fp) {
+        fprintf(stderr, "Error: Could not open nodes output file\n");
+        goto done;
+    }
+    for (int32_t i = 0; i < b.n; i++) {
+        const LinkLine *line = &b.rows[i].line;
+        fprintf(nodes_fp, "%.*s|%.*s\n", (int)line->path_len, line->path,
+                (int)line->name_len, line->name);
+    }
+    fclose(nodes_fp);
+    
+    // Write CSR to binary file
+    if (write_csr_file(csr_out_path, b.n, b.nnz, b.row_ptr, b.col_idx, b.outdeg) != 0) {
+        goto done;
+    }
+    printf("CSR built successfully: n=%d, nnz=%d (%d threads)\n", b.n, b.nnz, num_threads);
+    ret = 0;
+    
+done:
+    for (int t = 0; chunks && t < num_threads; t++) {
+        free(chunks[t].rows);
+        free(chunks[t].edges);
+    }
+    free(chunks);
+    free(threads);
+    free(b.rows);
+    free(b.slots);
+    free(b.row_ptr);
+    free(b.col_idx);
+    free(b.outdeg);
+    return ret;
+}
+
+// Build CSR from Part 1 output with num_threads threads, and write graph +
+// nodes files (num_threads <= 1: the sequential streaming build)
+int csr_build_from_struct_threads(const char *struct_path,
+                                  const char *csr_out_path,
+                                  const char *nodes_out_path,
+                                  int num_threads) {
+    // Binary edge list from `multithreaded --binary`: no text to parse
+    if (is_edge_list(struct_path)) {
+        return csr_build_from_edges(struct_path, csr_out_path, nodes_out_path);
+    }
+    
+    const char *data;
+    size_t size;
+    int mapped;
+    if (load_text(struct_path, &data, &size, &mapped) != 0) {
+        fprintf(stderr, "Error: Could not read struct file\n");
+        return -1;
+    }
+    
+    if (num_threads > CSR_MAX_BUILD_THREADS) num_threads = CSR_MAX_BUILD_THREADS;
+    int ret = (num_threads > 1)
+        ? build_text_parallel(data, size, num_threads, csr_out_path, nodes_out_path)
+        : build_text_sequential(data, size, csr_out_path, nodes_out_path);
+    
+    if (mapped) {
+        munmap((void *)data, size);
+    } else {
+        free((void *)data);
+    }
+    return ret;
+}
+
+// Build CSR from Part 1 output, and write graph + nodes files
+// Large files are split over the online CPUs (CSR_PARALLEL_MIN_BYTES each)
+int csr_build_from_struct(const char *struct_path,
+                         const char *csr_out_path,
+                         const char *nodes_out_path) {
+    struct stat st;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_threads = 1;
+    if (stat(struct_path, &st) == 0 && cpus > 1) {
+        int64_t by_size = (int64_t)st.st_size / CSR_PARALLEL_MIN_BYTES;
+        num_threads = (int)(by_size < cpus ? by_size : cpus);
+    }
+    return csr_build_from_struct_threads(struct_path, csr_out_path, nodes_out_path,
+                                         num_threads);
+}
+
+// ---------------------------------------------------------------------------
+// Compressed adjacency
+// ---------------------------------------------------------------------------
+// WebGraph-style coding of the neighbor lists (format: CSRAdjFileHeader).
+// Sorted neighbors of a crawl sit close together, so most gaps take one or
+// two bytes, and with the degree in the stream there is no row_ptr or
+// outdeg array: the kernels stream the adjacency bytes and nothing else.
+// Sorting a row leaves P * pi bit-identical, as every target of a row
+// receives the same mass.
+
+// Bytes used by the group with tag byte t (tag included)
+static uint8_t adj_group_bytes[256];
+#if defined(__SSSE3__)
+// pshufb masks that spread a group's value bytes over four uint32 lanes
+static uint8_t adj_shuffle[256][16];
+#endif
+static pthread_once_t adj_tables_once = PTHREAD_ONCE_INIT;
+
+static void adj_build_tables(void) {
+    for (int t = 0; t < 256; t++) {
+        int at = 0;
+        for (int i = 0; i < 4; i++) {
+            int len = ((t >> (2 * i)) & 3) + 1;
+#if defined(__SSSE3__)
+            for (int b = 0; b < 4; b++) {
+                adj_shuffle[t][4 * i + b] = (uint8_t)(b < len ? at + b : 0x80);
+            }
+#endif
+            at += len;
+        }
+        adj_group_bytes[t] = (uint8_t)(1 + at);
+    }
+}
+
+// AdjDecoder: Reads a stream value by value, decoding a group at a time
+typedef struct {
+    const uint8_t *p;    // tag byte of the next group
+    uint32_t v[4];       // values of the current group
+    int k;               // next value in v (4: decode a group first)
+} AdjDecoder;
+
+static void adj_decoder_init(AdjDecoder *d, const uint8_t *p) {
+    pthread_once(&adj_tables_once, adj_build_tables);
+    d->p = p;
+    d->k = 4;
+}
+
+// Decode the group at p into v; returns the next group
+// May load up to 16 bytes past the tag (the stream is padded for this).
+static inline const uint8_t *adj_decode_group(const uint8_t *p, uint32_t v[4]) {
+    uint8_t tag = p[0];
+#if defined(__SSSE3__)
+    __m128i bytes = _mm_loadu_si128((const __m128i *)(p + 1));
+    __m128i mask = _mm_loadu_si128((const __m128i *)adj_shuffle[tag]);
+    _mm_storeu_si128((__m128i *)v, _mm_shuffle_epi8(bytes, mask));
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Load 4 bytes per value and mask off the next value's bytes
+    static const uint32_t keep[4] = { 0xFFu, 0xFFFFu, 0xFFFFFFu, 0xFFFFFFFFu };
+    const uint8_t *q = p + 1;
+    for (int i = 0; i < 4; i++) {
+        int code = (tag >> (2 * i)) & 3;
+        uint32_t x;
+        memcpy(&x, q, sizeof(x));
+        v[i] = x & keep[code];
+        q += code + 1;
+    }
+#else
+    const uint8_t *q = p + 1;
+    for (int i = 0; i < 4; i++) {
+        int len = ((tag >> (2 * i)) & 3) + 1;
+        uint32_t x = 0;
+        for (int b = 0; b < len; b++) x |= (uint32_t)q[b] << (8 * b);
+        v[i] = x;
+        q += len;
+    }
+#endif
+    return p + adj_group_bytes[tag];
+}
+
+static inline uint32_t adj_next(AdjDecoder *d) {
+    if (d->k == 4) {
+        d->p = adj_decode_group(d->p, d->v);
+        d->k = 0;
+    }
+    return d->v[d->k++];
+}
+
+// Drop the padding of the current group (at the start of every block)
+static inline void adj_end_block(AdjDecoder *d) {
+    d->k = 4;
+}
+
+static inline uint32_t zigzag(int64_t x) {
+    return (uint32_t)(((uint64_t)x << 1) ^ (uint64_t)(x >> 63));
+}
+
+static inline int64_t unzigzag(uint32_t z) {
+    return (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+}
+
+// Edges of all rows before row (decodes the rows of row's block before it)
+static int64_t adj_edges_before(const uint8_t *adj, const CSRAdjBlock *index, int32_t row) {
+    int32_t b = row / CSR_ADJ_BLOCK_ROWS;
+    int64_t edges = index[b].edge_off;
+    AdjDecoder d;
+    adj_decoder_init(&d, adj + index[b].byte_off);
+    for (int32_t i = b * CSR_ADJ_BLOCK_ROWS; i < row; i++) {
+        uint32_t deg = adj_next(&d);
+        for (uint32_t e = 0; e < deg; e++) adj_next(&d);
+        edges += deg;
+    }
+    return edges;
+}
+
+// AdjWriter: Growing group-varint stream
+typedef struct {
+    uint8_t *buf;
+    size_t len, cap;
+    uint32_t pend[4];    // values of the unfinished group
+    int k;
+} AdjWriter;
+
+// Write out the pending values as one group (zero padded)
+static int adj_flush_group(AdjWriter *w) {
+    if (w->k == 0) return 0;
+    if (w->cap - w->len < 17) {
+        size_t cap = w->cap ? w->cap * 2 : (size_t)1 << 16;
+        uint8_t *buf = realloc(w->buf, cap);
+        if (!buf) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return -1;
+        }
+        w->buf = buf;
+        w->cap = cap;
+    }
+    
+    uint8_t *tag = w->buf + w->len, *q = tag + 1;
+    *tag = 0;
+    for (int i = 0; i < 4; i++) {
+        uint32_t x = i < w->k ? w->pend[i] : 0;
+        int len = x < (1u << 8) ? 1 : x < (1u << 16) ? 2 : x < (1u << 24) ? 3 : 4;
+        *tag |= (uint8_t)((len - 1) << (2 * i));
+        for (int b = 0; b < len; b++) *q++ = (uint8_t)(x >> (8 * b));
+    }
+    w->len = (size_t)(q - w->buf);
+    w->k = 0;
+    return 0;
+}
+
+static int adj_put(AdjWriter *w, uint32_t x) {
+    w->pend[w->k++] = x;
+    return w->k == 4 ? adj_flush_group(w) : 0;
+}
+
+static int cmp_int32(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a, y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Encode the rows of a plain CSR into index + stream (adj_bytes + 16 zero bytes)
+static int adj_encode(const CSR *g, CSRAdjBlock *index, AdjWriter *w) {
+    int32_t max_deg = 1;
+    for (int32_t i = 0; i < g->n; i++) {
+        int32_t deg = g->row_ptr[i + 1] - g->row_ptr[i];
+        if (deg > max_deg) max_deg = deg;
+    }
+    int32_t *row = malloc((size_t)max_deg * sizeof(int32_t));
+    if (!row) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    
+    int ok = 1;
+    for (int32_t i = 0; ok && i < g->n; i++) {
+        if (i % CSR_ADJ_BLOCK_ROWS == 0) {
+            ok = (adj_flush_group(w) == 0);
+            index[i / CSR_ADJ_BLOCK_ROWS].byte_off = (int64_t)w->len;
+            index[i / CSR_ADJ_BLOCK_ROWS].edge_off = g->row_ptr[i];
+        }
+        
+        int32_t deg = g->row_ptr[i + 1] - g->row_ptr[i];
+        memcpy(row, g->col_idx + g->row_ptr[i], (size_t)deg * sizeof(int32_t));
+        qsort(row, (size_t)deg, sizeof(int32_t), cmp_int32);
+        
+        ok = ok && adj_put(w, (uint32_t)deg) == 0;
+        if (ok && deg > 0) ok = (adj_put(w, zigzag((int64_t)row[0] - i)) == 0);
+        for (int32_t e = 1; ok && e < deg; e++) {
+            ok = (adj_put(w, (uint32_t)(row[e] - row[e - 1])) == 0);
+        }
+    }
+    free(row);
+    
+    // Close the last block, then leave room for the decoder's 16-byte loads
+    ok = ok && adj_flush_group(w) == 0;
+    if (ok) {
+        int64_t blocks = ((int64_t)g->n + CSR_ADJ_BLOCK_ROWS - 1) / CSR_ADJ_BLOCK_ROWS;
+        index[blocks].byte_off = (int64_t)w->len;
+        index[blocks].edge_off = g->nnz;
+        
+        uint8_t *buf = realloc(w->buf, w->len + 16);
+        if (!buf) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return -1;
+        }
+        memset(buf + w->len, 0, 16);
+        w->buf = buf;
+        w->cap = w->len + 16;
+    }
+    return ok ? 0 : -1;
+}
+
+// Write a compressed CSR file
+static int write_adj_file(const char *out_path, int32_t n, int32_t nnz,
+                          const CSRAdjBlock *index, const AdjWriter *w) {
+    FILE *fp = fopen(out_path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Error: Could not open CSR output file\n");
+        return -1;
+    }
     
-    // Remove brackets and parse comma-separated values
-    char *start = strchr(token, '[');
-    char *end = strchr(token, ']');
-    if (!start || !end) return -1;
+    int64_t blocks = ((int64_t)n + CSR_ADJ_BLOCK_ROWS - 1) / CSR_ADJ_BLOCK_ROWS;
+    int64_t index_bytes = (blocks + 1) * (int64_t)sizeof(CSRAdjBlock);
+    union {
+        CSRAdjFileHeader h;
+        char page[CSR_FILE_ALIGN];
+    } head;
+    memset(&head, 0, sizeof(head));
+    head.h.magic = CSR_ADJ_MAGIC;
+    head.h.version = CSR_ADJ_VERSION;
+    head.h.endian_tag = CSR_FILE_ENDIAN_TAG;
+    head.h.block_rows = CSR_ADJ_BLOCK_ROWS;
+    head.h.n = n;
+    head.h.nnz = nnz;
+    head.h.index_off = CSR_FILE_ALIGN;
+    head.h.adj_off = head.h.index_off + align_up(index_bytes);
+    head.h.adj_bytes = (int64_t)w->len;
+    head.h.file_bytes = head.h.adj_off + align_up((int64_t)w->len + 16);
+    head.h.data_checksum = adj_data_checksum(index, blocks, w->buf, (int64_t)w->len);
+    head.h.header_checksum = adj_header_checksum(&head.h);
+    fwrite(head.page, 1, sizeof(head.page), fp);
     
-    start++; // Skip opening bracket
-    *end = '\0'; // Remove closing bracket
+    write_section(fp, index, index_bytes);
+    write_section(fp, w->buf, (int64_t)w->len + 16);
     
-    if (start < end && *start != '\0') {
-        char *outlink = strtok(start, ",");
-        while (outlink && *outlink_count < 1000) { // Max 1000 outlinks
-            // Trim whitespace
-            while (*outlink == ' ') outlink++;
-            outlinks[*outlink_count] = strdup(outlink);
-            (*outlink_count)++;
-            outlink = strtok(NULL, ",");
-        }
+    int failed = ferror(fp);
+    if (fclose(fp) != 0 || failed) {
+        fprintf(stderr, "Error: Could not write CSR output file\n");
+        return -1;
     }
-    
     return 0;
 }
 
-// Build CSR from Part 1 output, and write graph + nodes files
-int csr_build_from_struct(const char *struct_path,
-                         const char *csr_out_path,
-                         const char *nodes_out_path) {
-    // Count total number of files
-    int32_t n = count_lines(struct_path);
-    if (n <= 0) {
-        fprintf(stderr, "Error: Could not read struct file\n");
+// Write a compressed copy of a CSR file (through a temporary file, so the
+// input may be the output)
+int csr_compress_file(const char *csr_path, const char *out_path) {
+    CSR g;
+    if (load_full(csr_path, &g) != 0) return -1;
+    if (g.adj) {
+        fprintf(stderr, "Error: CSR file is already compressed\n");
+        csr_free(&g);
         return -1;
     }
     
-    // Allocate temporary storage
-    char **filenames = malloc(n * sizeof(char*));
-    if (!filenames) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path) >= (int)sizeof(tmp_path)) {
+        fprintf(stderr, "Error: CSR output path too long\n");
+        csr_free(&g);
         return -1;
     }
     
-    char **filepaths = malloc(n * sizeof(char*));
-    if (!filepaths) {
+    int64_t blocks = ((int64_t)g.n + CSR_ADJ_BLOCK_ROWS - 1) / CSR_ADJ_BLOCK_ROWS;
+    CSRAdjBlock *index = malloc((size_t)(blocks + 1) * sizeof(CSRAdjBlock));
+    AdjWriter w;
+    memset(&w, 0, sizeof(w));
+    
+    int ret = -1;
+    if (!index) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        free(filenames);
-        return -1;
+    } else if (adj_encode(&g, index, &w) == 0 &&
+               write_adj_file(tmp_path, g.n, g.nnz, index, &w) == 0) {
+        if (rename(tmp_path, out_path) == 0) {
+            ret = 0;
+        } else {
+            fprintf(stderr, "Error: Could not replace CSR output file\n");
+            remove(tmp_path);
+        }
     }
     
-    char ***outlinks_array = malloc(n * sizeof(char**));
-    if (!outlinks_array) {
+    free(index);
+    free(w.buf);
+    csr_free(&g);
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+// Vertex reordering
+// ---------------------------------------------------------------------------
+// Node ids come in discovery order, so the kernels' pi_out[j] += mass lands
+// on an unrelated cache line edge after edge. A renumbering that gives
+// nearby ids to nodes hit together keeps those lines in cache:
+//   - degree: hubs (most in-links, so most writes) packed at the front
+//   - RCM: breadth-first from a low-degree node, neighbors by rising degree,
+//     then reversed; linked nodes get close ids (small bandwidth)
+// Orders are new_of_old[old id] = new id.
+
+// Hub sorting: counting sort by in-degree, descending (ties keep their order)
+static int order_by_degree(const CSR *g, int32_t *new_of_old) {
+    int32_t *indeg = calloc((size_t)g->n + 1, sizeof(int32_t));
+    int32_t *start = calloc((size_t)g->nnz + 2, sizeof(int32_t));
+    if (!indeg || !start) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        free(filenames);
-        free(filepaths);
+        free(indeg);
+        free(start);
         return -1;
     }
     
-    int32_t *outlink_counts = calloc(n, sizeof(int32_t));
-    if (!outlink_counts) {
+    for (int32_t k = 0; k < g->nnz; k++) indeg[g->col_idx[k]]++;
+    
+    // start[d] = first new id of in-degree d (highest degrees first)
+    for (int32_t i = 0; i < g->n; i++) start[g->nnz - indeg[i] + 1]++;
+    for (int32_t d = 1; d <= g->nnz + 1; d++) start[d] += start[d - 1];
+    for (int32_t i = 0; i < g->n; i++) new_of_old[i] = start[g->nnz - indeg[i]]++;
+    
+    free(indeg);
+    free(start);
+    return 0;
+}
+
+// Reverse Cuthill-McKee over out-links and in-links together
+static int order_rcm(const CSR *g, int32_t *new_of_old) {
+    int32_t n = g->n;
+    int64_t *ptr = calloc((size_t)n + 1, sizeof(int64_t));
+    int64_t *fill = malloc(((size_t)n + 1) * sizeof(int64_t));
+    int32_t *nbr = malloc(((size_t)g->nnz * 2 + 1) * sizeof(int32_t));
+    int32_t *by_degree = malloc(((size_t)g->nnz * 2 + 1) * sizeof(int32_t));
+    int32_t *nodes = malloc(((size_t)n + 1) * sizeof(int32_t));
+    int32_t *queue = malloc(((size_t)n + 1) * sizeof(int32_t));
+    int64_t *count = calloc((size_t)g->nnz * 2 + 2, sizeof(int64_t));
+    int ret = -1;
+    if (!ptr || !fill || !nbr || !by_degree || !nodes || !queue || !count) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        free(filenames);
-        free(filepaths);
-        free(outlinks_array);
-        return -1;
+        goto cleanup;
     }
     
-    for (int i = 0; i < n; i++) {
-        filenames[i] = malloc(256);
-        if (!filenames[i]) {
-            fprintf(stderr, "Error: Memory allocation failed\n");
-            for (int j = 0; j < i; j++) {
-                free(filenames[j]);
-                free(filepaths[j]);
-                free(outlinks_array[j]);
-            }
-            free(filenames);
-            free(filepaths);
-            free(outlinks_array);
-            free(outlink_counts);
-            return -1;
-        }
-        
-        filepaths[i] = malloc(512);
-        if (!filepaths[i]) {
-            fprintf(stderr, "Error: Memory allocation failed\n");
-            free(filenames[i]);
-            for (int j = 0; j < i; j++) {
-                free(filenames[j]);
-                free(filepaths[j]);
-                free(outlinks_array[j]);
-            }
-            free(filenames);
-            free(filepaths);
-            free(outlinks_array);
-            free(outlink_counts);
-            return -1;
-        }
-        
-        outlinks_array[i] = malloc(1000 * sizeof(char*));
-        if (!outlinks_array[i]) {
-            fprintf(stderr, "Error: Memory allocation failed\n");
-            free(filenames[i]);
-            free(filepaths[i]);
-            for (int j = 0; j < i; j++) {
-                free(filenames[j]);
-                free(filepaths[j]);
-                free(outlinks_array[j]);
-            }
-            free(filenames);
-            free(filepaths);
-            free(outlinks_array);
-            free(outlink_counts);
-            return -1;
+    // Undirected neighbor lists: i -> j gives j to i's list and i to j's
+    for (int32_t i = 0; i < n; i++) {
+        ptr[i + 1] += g->row_ptr[i + 1] - g->row_ptr[i];
+        for (int32_t k = g->row_ptr[i]; k < g->row_ptr[i + 1]; k++) ptr[g->col_idx[k] + 1]++;
+    }
+    for (int32_t i = 0; i < n; i++) ptr[i + 1] += ptr[i];
+    memcpy(fill, ptr, ((size_t)n + 1) * sizeof(int64_t));
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t k = g->row_ptr[i]; k < g->row_ptr[i + 1]; k++) {
+            nbr[fill[i]++] = g->col_idx[k];
+            nbr[fill[g->col_idx[k]]++] = i;
         }
     }
     
-    // Read the struct file
-    FILE *fp = fopen(struct_path, "r");
-    if (!fp) {
-        fprintf(stderr, "Error: Could not open struct file\n");
-        return -1;
+    // Nodes by rising degree (counting sort), then every list in that order:
+    // appending v to its neighbors' lists in this order sorts them all
+    for (int32_t i = 0; i < n; i++) count[ptr[i + 1] - ptr[i] + 1]++;
+    for (int64_t d = 1; d <= g->nnz * 2 + 1; d++) count[d] += count[d - 1];
+    for (int32_t i = 0; i < n; i++) nodes[count[ptr[i + 1] - ptr[i]]++] = i;
+    memcpy(fill, ptr, ((size_t)n + 1) * sizeof(int64_t));
+    for (int32_t r = 0; r < n; r++) {
+        int32_t v = nodes[r];
+        for (int64_t k = ptr[v]; k < ptr[v + 1]; k++) by_degree[fill[nbr[k]]++] = v;
     }
     
-    char line[8192];
-    int32_t idx = 0;
-    while (fgets(line, sizeof(line), fp) && idx < n) {
-        // Remove newline
-        line[strcspn(line, "\n")] = 0;
-        
-        if (parse_line(line, filepaths[idx], filenames[idx], 
-                      outlinks_array[idx], &outlink_counts[idx]) != 0) {
-            fprintf(stderr, "Error parsing line %d\n", idx);
+    // Breadth-first from the lowest-degree unvisited node of each component
+    for (int32_t i = 0; i < n; i++) new_of_old[i] = -1;
+    int32_t head = 0, tail = 0;
+    for (int32_t r = 0; r < n; r++) {
+        if (new_of_old[nodes[r]] >= 0) continue;
+        new_of_old[nodes[r]] = 0;
+        queue[tail++] = nodes[r];
+        while (head < tail) {
+            int32_t u = queue[head++];
+            for (int64_t k = ptr[u]; k < ptr[u + 1]; k++) {
+                int32_t v = by_degree[k];
+                if (new_of_old[v] < 0) {
+                    new_of_old[v] = 0;
+                    queue[tail++] = v;
+                }
+            }
         }
-        idx++;
     }
-    fclose(fp);
+    for (int32_t k = 0; k < n; k++) new_of_old[queue[k]] = n - 1 - k;
+    ret = 0;
     
-    // Write nodes file (index to filename/filepath mapping)
-    FILE *nodes_fp = fopen(nodes_out_path, "w");
-    if (!nodes_fp) {
-        fprintf(stderr, "Error: Could not open nodes output file\n");
+cleanup:
+    free(ptr);
+    free(fill);
+    free(nbr);
+    free(by_degree);
+    free(nodes);
+    free(queue);
+    free(count);
+    return ret;
+}
+
+// Read a permutation file
+int csr_load_perm(const char *perm_path, int32_t *n_out, int32_t **perm_out) {
+    FILE *fp = fopen(perm_path, "rb");
+    if (!fp) return -1;
+    
+    uint32_t magic = 0;
+    int32_t n = -1;
+    int32_t *perm = NULL;
+    int ok = fread(&magic, sizeof(magic), 1, fp) == 1 && magic == CSR_PERM_MAGIC &&
+             fread(&n, sizeof(n), 1, fp) == 1 && n >= 0;
+    if (ok) {
+        perm = malloc(((size_t)n + 1) * sizeof(int32_t));
+        ok = perm && fread(perm, sizeof(int32_t), (size_t)n, fp) == (size_t)n;
+    }
+    fclose(fp);
+    if (!ok) {
+        fprintf(stderr, "Error: Invalid permutation file '%s'\n", perm_path);
+        free(perm);
         return -1;
     }
-    for (int i = 0; i < n; i++) {
-        fprintf(nodes_fp, "%s|%s\n", filepaths[i], filenames[i]);
+    
+    *n_out = n;
+    *perm_out = perm;
+    return 0;
+}
+
+static int write_perm_file(const char *path, int32_t n, const int32_t *perm) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Error: Could not open permutation output file\n");
+        return -1;
     }
-    fclose(nodes_fp);
+    uint32_t magic = CSR_PERM_MAGIC;
+    fwrite(&magic, sizeof(magic), 1, fp);
+    fwrite(&n, sizeof(n), 1, fp);
+    if (n > 0) fwrite(perm, sizeof(int32_t), (size_t)n, fp);
     
-    // Build filename to index mapping
-    // Using a hash table reduces complexity from O(n^2 * avg_outdeg) to O(n + nnz)
-    int32_t table_size = n * 2; // 2x for good load factor
-    typedef struct {
-        char *key;
-        int32_t value;
-    } HashEntry;
-    HashEntry *hash_table = calloc(table_size, sizeof(HashEntry));
-    if (!hash_table) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
+    int failed = ferror(fp);
+    if (fclose(fp) != 0 || failed) {
+        fprintf(stderr, "Error: Could not write permutation output file\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Write the n lines of the nodes file in the new order (line i -> new_of_old[i])
+static int write_nodes_reordered(const char *nodes_path, const char *out_path,
+                                 int32_t n, const int32_t *old_of_new) {
+    const char *data;
+    size_t size;
+    int mapped;
+    if (n == 0) {
+        data = "";
+        size = 0;
+        mapped = -1;
+    } else if (load_text(nodes_path, &data, &size, &mapped) != 0) {
+        fprintf(stderr, "Error: Could not read nodes file\n");
         return -1;
     }
     
-    // Insert all filenames into hash table
-    for (int i = 0; i < n; i++) {
-        // Simple hash function (djb2)
-        unsigned long hash = 5381;
-        const char *str = filenames[i];
-        int c;
-        while ((c = *str++))
-            hash = ((hash << 5) + hash) + c;
-        hash = hash % table_size;
-        
-        // Linear probing
-        while (hash_table[hash].key != NULL) {
-            hash = (hash + 1) % table_size;
+    // Start of every line (line n starts at the end)
+    size_t *line = malloc(((size_t)n + 1) * sizeof(size_t));
+    int32_t lines = 0;
+    if (line) {
+        for (size_t at = 0; at < size && lines <= n; ) {
+            const char *nl = memchr(data + at, '\n', size - at);
+            line[lines++] = at;
+            at = nl ? (size_t)(nl - data) + 1 : size;
         }
-        hash_table[hash].key = filenames[i];
-        hash_table[hash].value = i;
     }
     
-    // Build CSR structure (transpose: P^T where we store outlinks as rows)
-    // Count total non-zero entries
-    int32_t nnz = 0;
-    for (int i = 0; i < n; i++) {
-        nnz += outlink_counts[i];
+    int ret = -1;
+    FILE *fp = NULL;
+    if (!line) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    } else if (lines != n) {
+        fprintf(stderr, "Error: Nodes file has %d lines, CSR has %d rows\n", (int)lines, (int)n);
+    } else if (!(fp = fopen(out_path, "w"))) {
+        fprintf(stderr, "Error: Could not open nodes output file\n");
+    } else {
+        line[n] = size;
+        for (int32_t r = 0; r < n; r++) {
+            int32_t i = old_of_new[r];
+            size_t len = line[i + 1] - line[i];
+            fwrite(data + line[i], 1, len, fp);
+            if (len == 0 || data[line[i] + len - 1] != '\n') fputc('\n', fp);
+        }
+        int failed = ferror(fp);
+        if (fclose(fp) != 0 || failed) {
+            fprintf(stderr, "Error: Could not write nodes output file\n");
+        } else {
+            ret = 0;
+        }
     }
     
-    // Allocate CSR arrays
-    int32_t *row_ptr = malloc((n + 1) * sizeof(int32_t));
-    if (!row_ptr) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        free(hash_table);
+    free(line);
+    if (mapped == 1) munmap((void *)data, size);
+    else if (mapped == 0) free((void *)data);
+    return ret;
+}
+
+// Renumber a CSR file (and its nodes file) for locality
+int csr_reorder(const char *csr_path, const char *nodes_path,
+                const char *perm_path, int order) {
+    if (order != CSR_ORDER_DEGREE && order != CSR_ORDER_RCM) {
+        fprintf(stderr, "Error: Unknown vertex order %d\n", order);
         return -1;
     }
     
-    int32_t *col_idx = malloc(nnz * sizeof(int32_t));
-    if (!col_idx) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        free(row_ptr);
-        free(hash_table);
+    CSR g;
+    if (load_full(csr_path, &g) != 0) return -1;
+    if (g.adj) {
+        fprintf(stderr, "Error: Reorder the CSR before compressing it\n");
+        csr_free(&g);
         return -1;
     }
     
-    int32_t *outdeg = malloc(n * sizeof(int32_t));
-    if (!outdeg) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        free(row_ptr);
-        free(col_idx);
-        free(hash_table);
+    char csr_tmp[PATH_MAX], nodes_tmp[PATH_MAX], perm_tmp[PATH_MAX];
+    if (snprintf(csr_tmp, sizeof(csr_tmp), "%s.tmp", csr_path) >= (int)sizeof(csr_tmp) ||
+        snprintf(nodes_tmp, sizeof(nodes_tmp), "%s.tmp", nodes_path) >= (int)sizeof(nodes_tmp) ||
+        snprintf(perm_tmp, sizeof(perm_tmp), "%s.tmp", perm_path) >= (int)sizeof(perm_tmp)) {
+        fprintf(stderr, "Error: CSR output path too long\n");
+        csr_free(&g);
         return -1;
     }
     
-    // Build row_ptr and col_idx using hash table lookup
-    row_ptr[0] = 0;
-    int32_t current_pos = 0;
-    
-    for (int i = 0; i < n; i++) {
-        int32_t resolved_count = 0;
-        
-        // For each outlink, find its index using hash table
-        for (int j = 0; j < outlink_counts[i]; j++) {
-            // Hash lookup
-            unsigned long hash = 5381;
-            const char *str = outlinks_array[i][j];
-            int c;
-            while ((c = *str++))
-                hash = ((hash << 5) + hash) + c;
-            hash = hash % table_size;
-            
-            // Linear probing to find the key
-            int32_t dest_idx = -1;
-            while (hash_table[hash].key != NULL) {
-                if (strcmp(hash_table[hash].key, outlinks_array[i][j]) == 0) {
-                    dest_idx = hash_table[hash].value;
-                    break;
-                }
-                hash = (hash + 1) % table_size;
-            }
-            
-            if (dest_idx >= 0) {
-                col_idx[current_pos++] = dest_idx;
-                resolved_count++;
-            }
-        }
-        
-        // Store only resolved link count
-        outdeg[i] = resolved_count;
-        row_ptr[i + 1] = current_pos;
+    int32_t n = g.n;
+    int32_t *new_of_old = malloc(((size_t)n + 1) * sizeof(int32_t));
+    int32_t *old_of_new = malloc(((size_t)n + 1) * sizeof(int32_t));
+    int32_t *row_ptr = malloc(((size_t)n + 1) * sizeof(int32_t));
+    int32_t *col_idx = malloc(((size_t)g.nnz + 1) * sizeof(int32_t));
+    int32_t *outdeg = malloc(((size_t)n + 1) * sizeof(int32_t));
+    int32_t *prev = NULL;
+    int ret = -1;
+    if (!new_of_old || !old_of_new || !row_ptr || !col_idx || !outdeg) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        goto cleanup;
     }
     
-    // Update nnz to actual number of edges stored (excluding unresolved links)
-    nnz = current_pos;
-    
-    free(hash_table);
+    if ((order == CSR_ORDER_DEGREE ? order_by_degree(&g, new_of_old)
+                                   : order_rcm(&g, new_of_old)) != 0) goto cleanup;
+    for (int32_t i = 0; i < n; i++) old_of_new[new_of_old[i]] = i;
     
-    // Write CSR to binary file
-    FILE *csr_fp = fopen(csr_out_path, "wb");
-    if (!csr_fp) {
-        fprintf(stderr, "Error: Could not open CSR output file\n");
-        return -1;
+    // Row r is old row old_of_new[r], its targets renumbered and sorted
+    row_ptr[0] = 0;
+    for (int32_t r = 0; r < n; r++) {
+        int32_t i = old_of_new[r];
+        int32_t *row = col_idx + row_ptr[r];
+        int32_t deg = g.row_ptr[i + 1] - g.row_ptr[i];
+        for (int32_t e = 0; e < deg; e++) row[e] = new_of_old[g.col_idx[g.row_ptr[i] + e]];
+        qsort(row, (size_t)deg, sizeof(int32_t), cmp_int32);
+        row_ptr[r + 1] = row_ptr[r] + deg;
+        outdeg[r] = g.outdeg[i];
     }
     
-    // Write header
-    fwrite(&n, sizeof(int32_t), 1, csr_fp);
-    fwrite(&nnz, sizeof(int32_t), 1, csr_fp);
-    
-    // Write arrays
-    fwrite(row_ptr, sizeof(int32_t), n + 1, csr_fp);
-    fwrite(col_idx, sizeof(int32_t), nnz, csr_fp);
-    fwrite(outdeg, sizeof(int32_t), n, csr_fp);
+    // Compose with an earlier reorder, so perm maps from the built ids
+    int32_t prev_n;
+    if (access(perm_path, F_OK) == 0 && csr_load_perm(perm_path, &prev_n, &prev) == 0 &&
+        prev_n == n) {
+        for (int32_t i = 0; i < n; i++) prev[i] = new_of_old[prev[i]];
+    } else {
+        free(prev);
+        prev = NULL;
+    }
     
-    fclose(csr_fp);
+    // Write everything next to the originals, then swap them in
+    if (write_csr_file(csr_tmp, n, g.nnz, row_ptr, col_idx, outdeg) != 0 ||
+        write_nodes_reordered(nodes_path, nodes_tmp, n, old_of_new) != 0 ||
+        write_perm_file(perm_tmp, n, prev ? prev : new_of_old) != 0) goto cleanup;
+    if (rename(csr_tmp, csr_path) != 0 || rename(nodes_tmp, nodes_path) != 0 ||
+        rename(perm_tmp, perm_path) != 0) {
+        fprintf(stderr, "Error: Could not replace CSR, nodes or permutation file\n");
+        goto cleanup;
+    }
+    ret = 0;
     
-    // Cleanup
-    for (int i = 0; i < n; i++) {
-        free(filenames[i]);
-        free(filepaths[i]);
-        for (int j = 0; j < outlink_counts[i]; j++) {
-            free(outlinks_array[i][j]);
-        }
-        free(outlinks_array[i]);
+cleanup:
+    if (ret != 0) {
+        remove(csr_tmp);
+        remove(nodes_tmp);
+        remove(perm_tmp);
     }
-    free(filenames);
-    free(filepaths);
-    free(outlinks_array);
-    free(outlink_counts);
+    free(new_of_old);
+    free(old_of_new);
     free(row_ptr);
     free(col_idx);
     free(outdeg);
-    
-    printf("CSR built successfully: n=%d, nnz=%d\n", n, nnz);
-    return 0;
+    free(prev);
+    csr_free(&g);
+    return ret;
 }
 
-// Load the entire CSR from file into memory
-int load_full(const char *csr_path, CSR *g_out) {
+// ---------------------------------------------------------------------------
+// Loading
+// ---------------------------------------------------------------------------
+// A version 2 file is mapped read-only and the arrays point into the
+// mapping: loading costs one mmap whatever the graph size, pages are read on
+// first touch, and every process that maps the file shares the same page
+// cache copy. Only the header is checked per load; csr_verify() checks data.
+// Version 1 files are read into heap arrays as before.
+
+// Load a whole version 1 file (no header) into heap arrays
+static int load_full_v1(const char *csr_path, CSR *g_out) {
+    g_out->map = NULL;
+    g_out->map_bytes = 0;
+    g_out->adj = NULL;
+    g_out->adj_skip = 0;
+    
     FILE *fp = fopen(csr_path, "rb");
     if (!fp) {
         fprintf(stderr, "Error: Could not open CSR file\n");
@@ -388,11 +1647,16 @@ int load_full(const char *csr_path, CSR *g_out) {
     return 0;
 }
 
-// Load partial CSR for rows [start_row, end_row)
-int load_rows(const char *csr_path,
-             int32_t start_row,
-             int32_t end_row,
-             CSR *g_partial_out) {
+// Load rows [start_row, end_row) of a version 1 file into heap arrays
+static int load_rows_v1(const char *csr_path,
+                        int32_t start_row,
+                        int32_t end_row,
+                        CSR *g_partial_out) {
+    g_partial_out->map = NULL;
+    g_partial_out->map_bytes = 0;
+    g_partial_out->adj = NULL;
+    g_partial_out->adj_skip = 0;
+    
     FILE *fp = fopen(csr_path, "rb");
     if (!fp) {
         fprintf(stderr, "Error: Could not open CSR file\n");
@@ -477,20 +1741,437 @@ int load_rows(const char *csr_path,
     return 0;
 }
 
-// Free CSR heap allocations
+// Is the header self-consistent and inside a file_bytes-byte file?
+static int check_header(const CSRFileHeader *h, int64_t file_bytes) {
+    if (h->version != CSR_FILE_VERSION) {
+        fprintf(stderr, "Error: Unsupported CSR file version %u\n", h->version);
+        return -1;
+    }
+    if (h->endian_tag != CSR_FILE_ENDIAN_TAG) {
+        fprintf(stderr, "Error: CSR file was written with a different byte order\n");
+        return -1;
+    }
+    if (h->index_bytes != sizeof(int32_t)) {
+        fprintf(stderr, "Error: Unsupported CSR index width (%u bytes)\n", h->index_bytes);
+        return -1;
+    }
+    if (h->header_checksum != csr_header_checksum(h)) {
+        fprintf(stderr, "Error: CSR file header is corrupt\n");
+        return -1;
+    }
+    
+    int64_t row_bytes = (h->n + 1) * (int64_t)sizeof(int32_t);
+    int64_t col_bytes = h->nnz * (int64_t)sizeof(int32_t);
+    int64_t deg_bytes = h->n * (int64_t)sizeof(int32_t);
+    if (h->n < 0 || h->n >= INT32_MAX || h->nnz < 0 || h->nnz > INT32_MAX ||
+        h->row_ptr_off % CSR_FILE_ALIGN != 0 || h->col_idx_off % CSR_FILE_ALIGN != 0 ||
+        h->outdeg_off % CSR_FILE_ALIGN != 0 ||
+        h->row_ptr_off < (int64_t)sizeof(CSRFileHeader) ||
+        h->col_idx_off < h->row_ptr_off + row_bytes ||
+        h->outdeg_off < h->col_idx_off + col_bytes ||
+        h->file_bytes < h->outdeg_off + deg_bytes ||
+        h->file_bytes != file_bytes) {
+        fprintf(stderr, "Error: CSR file sections are out of bounds (truncated file?)\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Is the compressed file header self-consistent and inside the file?
+static int check_adj_header(const CSRAdjFileHeader *h, int64_t file_bytes) {
+    if (h->version != CSR_ADJ_VERSION) {
+        fprintf(stderr, "Error: Unsupported compressed CSR file version %u\n", h->version);
+        return -1;
+    }
+    if (h->endian_tag != CSR_FILE_ENDIAN_TAG) {
+        fprintf(stderr, "Error: CSR file was written with a different byte order\n");
+        return -1;
+    }
+    if (h->block_rows != CSR_ADJ_BLOCK_ROWS) {
+        fprintf(stderr, "Error: Unsupported CSR block size (%u rows)\n", h->block_rows);
+        return -1;
+    }
+    if (h->header_checksum != adj_header_checksum(h)) {
+        fprintf(stderr, "Error: CSR file header is corrupt\n");
+        return -1;
+    }
+    
+    int64_t blocks = (h->n + CSR_ADJ_BLOCK_ROWS - 1) / CSR_ADJ_BLOCK_ROWS;
+    if (h->n < 0 || h->n >= INT32_MAX || h->nnz < 0 || h->nnz > INT32_MAX ||
+        h->index_off % CSR_FILE_ALIGN != 0 || h->adj_off % CSR_FILE_ALIGN != 0 ||
+        h->index_off < (int64_t)sizeof(CSRAdjFileHeader) ||
+        h->adj_off < h->index_off + (blocks + 1) * (int64_t)sizeof(CSRAdjBlock) ||
+        h->adj_bytes < 0 ||
+        h->file_bytes < h->adj_off + h->adj_bytes + 16 ||
+        h->file_bytes != file_bytes) {
+        fprintf(stderr, "Error: CSR file sections are out of bounds (truncated file?)\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Map a version 2 or compressed file read-only
+// Returns 1 with the mapping in *map / *map_bytes, 0 if the file has
+// neither magic (a version 1 file), -1 on failure
+static int map_csr_file(const char *csr_path, void **map, size_t *map_bytes) {
+    int fd = open(csr_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open CSR file\n");
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "Error: Could not stat CSR file\n");
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(CSRFileHeader)) {
+        close(fd);
+        return 0;
+    }
+    
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map CSR file\n");
+        return -1;
+    }
+    
+    uint32_t magic = *(const uint32_t *)m;
+    int bad;
+    if (magic == CSR_FILE_MAGIC) {
+        bad = check_header(m, (int64_t)st.st_size);
+    } else if (magic == CSR_ADJ_MAGIC) {
+        bad = check_adj_header(m, (int64_t)st.st_size);
+    } else {
+        munmap(m, (size_t)st.st_size);
+        return 0;
+    }
+    if (bad) {
+        munmap(m, (size_t)st.st_size);
+        return -1;
+    }
+    
+    *map = m;
+    *map_bytes = (size_t)st.st_size;
+    return 1;
+}
+
+// Point g's arrays (or adj) at the sections of a mapped file (all rows)
+static void point_into_map(CSR *g, void *map, size_t map_bytes) {
+    g->adj = NULL;
+    g->adj_skip = 0;
+    if (*(const uint32_t *)map == CSR_ADJ_MAGIC) {
+        const CSRAdjFileHeader *h = map;
+        g->n = (int32_t)h->n;
+        g->nnz = (int32_t)h->nnz;
+        g->row_ptr = NULL;
+        g->col_idx = NULL;
+        g->outdeg = NULL;
+        g->adj = (const uint8_t *)map + h->adj_off;
+        g->map = map;
+        g->map_bytes = map_bytes;
+        return;
+    }
+    
+    const CSRFileHeader *h = map;
+    g->n = (int32_t)h->n;
+    g->nnz = (int32_t)h->nnz;
+    g->row_ptr = (int32_t *)((char *)map + h->row_ptr_off);
+    g->col_idx = (int32_t *)((char *)map + h->col_idx_off);
+    g->outdeg = (int32_t *)((char *)map + h->outdeg_off);
+    g->map = map;
+    g->map_bytes = map_bytes;
+}
+
+// madvise() the pages covering data[0..bytes)
+static void advise_range(const void *data, size_t bytes, int advice) {
+    if (bytes == 0) return;
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)data & ~(page - 1);
+    uintptr_t end = (uintptr_t)data + bytes;
+    madvise((void *)start, end - start, advice);
+}
+
+// Read n and nnz from a CSR file header
+int csr_file_info(const char *csr_path, int32_t *n_out, int32_t *nnz_out) {
+    void *map;
+    size_t map_bytes;
+    int mapped = map_csr_file(csr_path, &map, &map_bytes);
+    if (mapped < 0) return -1;
+    
+    int32_t n, nnz;
+    if (mapped) {
+        CSR g;
+        point_into_map(&g, map, map_bytes);
+        n = g.n;
+        nnz = g.nnz;
+        munmap(map, map_bytes);
+    } else {
+        FILE *fp = fopen(csr_path, "rb");
+        if (!fp) {
+            fprintf(stderr, "Error: Could not open CSR file\n");
+            return -1;
+        }
+        int ok = fread(&n, sizeof(int32_t), 1, fp) == 1 &&
+                 fread(&nnz, sizeof(int32_t), 1, fp) == 1;
+        fclose(fp);
+        if (!ok || n < 0 || nnz < 0) {
+            fprintf(stderr, "Error: Could not read CSR header\n");
+            return -1;
+        }
+    }
+    
+    *n_out = n;
+    if (nnz_out) *nnz_out = nnz;
+    return 0;
+}
+
+// Decode a compressed file's rows with bounds checks: block index entries,
+// neighbor ranges and the edge count must all agree
+static int verify_adj(const CSR *g) {
+    const CSRAdjFileHeader *h = g->map;
+    const CSRAdjBlock *index = (const CSRAdjBlock *)((const char *)g->map + h->index_off);
+    int64_t blocks = (h->n + CSR_ADJ_BLOCK_ROWS - 1) / CSR_ADJ_BLOCK_ROWS;
+    const uint8_t *end = g->adj + h->adj_bytes;
+    
+    advise_range(g->adj, (size_t)h->adj_bytes, MADV_SEQUENTIAL);
+    if (adj_data_checksum(index, blocks, g->adj, h->adj_bytes) != h->data_checksum) {
+        fprintf(stderr, "Error: CSR file checksum mismatch\n");
+        return -1;
+    }
+    
+    AdjDecoder d;
+    adj_decoder_init(&d, g->adj);
+    int64_t edges = 0;
+    int ok = 1;
+    for (int32_t i = 0; ok && i < g->n; i++) {
+        if (i % CSR_ADJ_BLOCK_ROWS == 0) {
+            adj_end_block(&d);
+            const CSRAdjBlock *b = &index[i / CSR_ADJ_BLOCK_ROWS];
+            ok = (d.p == g->adj + b->byte_off && edges == b->edge_off);
+        }
+        
+        // A group may only start inside the stream (it may end in the padding)
+        int64_t j = i;
+        uint32_t deg = 0;
+        for (int64_t e = -1; ok && e < (int64_t)deg; e++) {
+            if (d.k == 4 && d.p >= end) {
+                ok = 0;
+                break;
+            }
+            uint32_t v = adj_next(&d);
+            if (e < 0) deg = v;
+            else j = (e == 0) ? i + unzigzag(v) : j + v;
+            if (e >= 0 && (j < 0 || j >= g->n)) ok = 0;
+        }
+        edges += deg;
+    }
+    adj_end_block(&d);
+    
+    ok = ok && edges == g->nnz && d.p == end &&
+         index[blocks].byte_off == h->adj_bytes && index[blocks].edge_off == g->nnz;
+    if (!ok) fprintf(stderr, "Error: CSR file is inconsistent\n");
+    return ok ? 0 : -1;
+}
+
+// Check a CSR file end to end (checksum for version 2 and compressed files,
+// then the structure)
+int csr_verify(const char *csr_path) {
+    CSR g;
+    if (load_full(csr_path, &g) != 0) return -1;
+    if (g.adj) {
+        int ret = verify_adj(&g);
+        csr_free(&g);
+        return ret;
+    }
+    
+    int ok = 1;
+    if (g.map) {
+        const CSRFileHeader *h = g.map;
+        advise_range(g.map, g.map_bytes, MADV_SEQUENTIAL);
+        if (csr_data_checksum(g.n, g.nnz, g.row_ptr, g.col_idx, g.outdeg) != h->data_checksum) {
+            fprintf(stderr, "Error: CSR file checksum mismatch\n");
+            ok = 0;
+        }
+    }
+    
+    // row_ptr must run from 0 to nnz, col_idx must be rows, outdeg row lengths
+    if (ok && (g.row_ptr[0] != 0 || g.row_ptr[g.n] != g.nnz)) ok = 0;
+    for (int32_t i = 0; ok && i < g.n; i++) {
+        if (g.row_ptr[i + 1] < g.row_ptr[i] ||
+            g.outdeg[i] != g.row_ptr[i + 1] - g.row_ptr[i]) ok = 0;
+    }
+    for (int32_t k = 0; ok && k < g.nnz; k++) {
+        if (g.col_idx[k] < 0 || g.col_idx[k] >= g.n) ok = 0;
+    }
+    if (!ok) fprintf(stderr, "Error: CSR file is inconsistent\n");
+    
+    csr_free(&g);
+    return ok ? 0 : -1;
+}
+
+// Load the entire CSR: map a version 2 file, read a version 1 file
+int load_full(const char *csr_path, CSR *g_out) {
+    void *map;
+    size_t map_bytes;
+    int mapped = map_csr_file(csr_path, &map, &map_bytes);
+    if (mapped < 0) return -1;
+    if (!mapped) return load_full_v1(csr_path, g_out);
+    
+    point_into_map(g_out, map, map_bytes);
+    advise_range(map, map_bytes, MADV_WILLNEED);
+    return 0;
+}
+
+// Load partial CSR for rows [start_row, end_row)
+// col_idx and outdeg are the slices of the mapping; row_ptr is rebased into
+// a small heap copy unless the slice already starts at edge 0.
+int load_rows(const char *csr_path,
+             int32_t start_row,
+             int32_t end_row,
+             CSR *g_partial_out) {
+    void *map;
+    size_t map_bytes;
+    int mapped = map_csr_file(csr_path, &map, &map_bytes);
+    if (mapped < 0) return -1;
+    if (!mapped) return load_rows_v1(csr_path, start_row, end_row, g_partial_out);
+    
+    CSR full;
+    point_into_map(&full, map, map_bytes);
+    if (start_row < 0 || end_row > full.n || start_row >= end_row) {
+        fprintf(stderr, "Error: Invalid row range\n");
+        munmap(map, map_bytes);
+        return -1;
+    }
+    
+    int32_t partial_n = end_row - start_row;
+    if (full.adj) {
+        // Compressed: start at the block holding start_row
+        const CSRAdjFileHeader *h = map;
+        const CSRAdjBlock *index = (const CSRAdjBlock *)((char *)map + h->index_off);
+        const CSRAdjBlock *first = &index[start_row / CSR_ADJ_BLOCK_ROWS];
+        const CSRAdjBlock *last = &index[(end_row - 1) / CSR_ADJ_BLOCK_ROWS + 1];
+        
+        *g_partial_out = full;
+        g_partial_out->n = partial_n;
+        g_partial_out->nnz = (int32_t)(adj_edges_before(full.adj, index, end_row) -
+                                       adj_edges_before(full.adj, index, start_row));
+        g_partial_out->adj = full.adj + first->byte_off;
+        g_partial_out->adj_skip = start_row % CSR_ADJ_BLOCK_ROWS;
+        advise_range(g_partial_out->adj, (size_t)(last->byte_off - first->byte_off),
+                     MADV_WILLNEED);
+        return 0;
+    }
+    
+    int32_t start_nnz = full.row_ptr[start_row];
+    int32_t end_nnz = full.row_ptr[end_row];
+    if (start_nnz < 0 || end_nnz < start_nnz || end_nnz > full.nnz) {
+        fprintf(stderr, "Error: CSR file is inconsistent\n");
+        munmap(map, map_bytes);
+        return -1;
+    }
+    
+    int32_t *row_ptr = full.row_ptr + start_row;
+    if (start_nnz != 0) {
+        row_ptr = malloc(((size_t)partial_n + 1) * sizeof(int32_t));
+        if (!row_ptr) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            munmap(map, map_bytes);
+            return -1;
+        }
+        for (int32_t i = 0; i <= partial_n; i++) {
+            row_ptr[i] = full.row_ptr[start_row + i] - start_nnz;
+        }
+    }
+    
+    g_partial_out->n = partial_n;
+    g_partial_out->nnz = end_nnz - start_nnz;
+    g_partial_out->row_ptr = row_ptr;
+    g_partial_out->col_idx = full.col_idx + start_nnz;
+    g_partial_out->outdeg = full.outdeg + start_row;
+    g_partial_out->adj = NULL;
+    g_partial_out->adj_skip = 0;
+    g_partial_out->map = map;
+    g_partial_out->map_bytes = map_bytes;
+    
+    // The kernel streams both slices once
+    advise_range(g_partial_out->col_idx, (size_t)g_partial_out->nnz * sizeof(int32_t),
+                 MADV_WILLNEED);
+    advise_range(g_partial_out->outdeg, (size_t)partial_n * sizeof(int32_t), MADV_WILLNEED);
+    return 0;
+}
+
+// Free CSR heap allocations (and the mapping of a mapped load)
 void csr_free(CSR *g) {
     if (g) {
-        free(g->row_ptr);
-        free(g->col_idx);
-        free(g->outdeg);
+        if (g->map) {
+            // Only a rebased row_ptr lives outside the mapping
+            char *lo = g->map, *hi = lo + g->map_bytes;
+            if ((char *)g->row_ptr < lo || (char *)g->row_ptr >= hi) free(g->row_ptr);
+            munmap(g->map, g->map_bytes);
+        } else {
+            free(g->row_ptr);
+            free(g->col_idx);
+            free(g->outdeg);
+        }
         g->row_ptr = NULL;
         g->col_idx = NULL;
         g->outdeg = NULL;
+        g->map = NULL;
+        g->map_bytes = 0;
+        g->adj = NULL;
+        g->adj_skip = 0;
         g->n = 0;
         g->nnz = 0;
     }
 }
 
+// ---------------------------------------------------------------------------
+// P * pi kernels
+// ---------------------------------------------------------------------------
+
+// P * pi for rows [start_row, end_row) of a compressed CSR (ADDITIVE)
+static void ppi_step_adj(const CSR *g,
+                         const double *pi_in,
+                         int32_t start_row,
+                         int32_t end_row,
+                         double *pi_out,
+                         double *dangling_out) {
+    AdjDecoder d;
+    adj_decoder_init(&d, g->adj);
+    double dangling = 0.0;
+    
+    // g->adj starts at a block boundary; rows before start_row are skipped
+    for (int32_t i = start_row - g->adj_skip; i < end_row; i++) {
+        if (i % CSR_ADJ_BLOCK_ROWS == 0) adj_end_block(&d);
+        
+        uint32_t deg = adj_next(&d);
+        if (i < start_row) {
+            for (uint32_t e = 0; e < deg; e++) adj_next(&d);
+            continue;
+        }
+        if (deg == 0) {
+            // Dangling node: accumulate its mass
+            dangling += pi_in[i];
+            continue;
+        }
+        
+        double mass = pi_in[i] / (double)deg;
+        int64_t j = i + unzigzag(adj_next(&d));
+        pi_out[j] += mass;
+        for (uint32_t e = 1; e < deg; e++) {
+            j += adj_next(&d);
+            pi_out[j] += mass;
+        }
+    }
+    
+    if (dangling_out) {
+        *dangling_out = dangling;
+    }
+}
+
 // Full P * pi (all rows), also returns dangling mass
 void ppi_step_full(const CSR *g,
                   const double *pi_in,
@@ -501,6 +2182,11 @@ void ppi_step_full(const CSR *g,
         pi_out[i] = 0.0;
     }
     
+    if (g->adj) {
+        ppi_step_adj(g, pi_in, 0, g->n, pi_out, dangling_out);
+        return;
+    }
+    
     double dangling = 0.0;
     
     // For each source row i
@@ -532,6 +2218,11 @@ void ppi_step_partial(const CSR *g,
                      int32_t end_row,
                      double *pi_out,
                      double *dangling_out) {
+    if (g->adj) {
+        ppi_step_adj(g, pi_in, start_row, end_row, pi_out, dangling_out);
+        return;
+    }
+    
     double local_dangling = 0.0;
     
     // Note: g is a partial CSR with adjusted indices
@@ -1,8 +1,11 @@
 #ifndef CSR_H
 #define CSR_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+struct CrawlGraph;      // Crawler.h
+
 // Compressed Sparse Row (CSR) matrix structure
 // Stores only non-zero elements for efficient sparse matrix operations
 typedef struct {
@@ -11,12 +14,93 @@ typedef struct {
     int32_t *row_ptr;    // length n+1, stores row start indices in col_idx
     int32_t *col_idx;    // length nnz, stores column indices of non-zero elements
     int32_t *outdeg;     // length n, stores outdegree for each node
+    void *map;           // mapping of a v2 file the arrays point into, or NULL (heap arrays)
+    size_t map_bytes;    // length of map
+    const uint8_t *adj;  // compressed file: neighbor lists from the block holding row 0
+                         // (row_ptr, col_idx and outdeg are then NULL), else NULL
+    int32_t adj_skip;    // rows of that block before row 0
 } CSR;
 
+// Binary CSR file (P_CSR.bin), version 2. Every section starts on a
+// CSR_FILE_ALIGN boundary so the arrays can be used straight from an mmap:
+//   header (CSRFileHeader, zero-padded to CSR_FILE_ALIGN bytes),
+//   int32 row_ptr[n+1] at row_ptr_off, int32 col_idx[nnz] at col_idx_off,
+//   int32 outdeg[n] at outdeg_off, each section zero-padded to CSR_FILE_ALIGN.
+// Integers are in the writer's byte order; endian_tag tells a reader which.
+// Version 1 files (int32 n, int32 nnz, row_ptr, col_idx, outdeg, packed)
+// are still read.
+#define CSR_FILE_MAGIC 0x32525343u    // "CSR2"
+#define CSR_FILE_VERSION 2
+#define CSR_FILE_ENDIAN_TAG 0x01020304u
+#define CSR_FILE_ALIGN 4096
+
+typedef struct {
+    uint32_t magic;           // CSR_FILE_MAGIC
+    uint32_t version;         // CSR_FILE_VERSION
+    uint32_t endian_tag;      // CSR_FILE_ENDIAN_TAG as written by the writer
+    uint32_t index_bytes;     // bytes per row_ptr / col_idx / outdeg entry (4)
+    int64_t n;                // number of rows
+    int64_t nnz;              // number of edges
+    int64_t row_ptr_off;      // file offsets of the sections (CSR_FILE_ALIGN multiples)
+    int64_t col_idx_off;
+    int64_t outdeg_off;
+    int64_t file_bytes;       // total file size
+    uint64_t data_checksum;   // csr_verify() checksum of the three sections
+    uint64_t header_checksum; // checksum of the header bytes before this field
+} CSRFileHeader;
+
+// Compressed CSR file (csr_compress_file()), same layout rules as version 2.
+// Rows are cut into blocks of CSR_ADJ_BLOCK_ROWS; the adjacency stream holds
+// the blocks back to back. Per row it holds the out-degree, then the sorted
+// neighbors: the first as zigzag(col - row), the rest as gaps. The values
+// are group-varint coded (one tag byte with four 2-bit byte counts, then
+// four little-endian values of 1..4 bytes); each block ends on a group
+// boundary (zero padded), and the stream is followed by 16 zero bytes so
+// a decoder may always load 16 bytes past a tag.
+//   header (CSRAdjFileHeader, zero-padded to CSR_FILE_ALIGN bytes),
+//   CSRAdjBlock index[blocks + 1] at index_off (the last entry is the end),
+//   adjacency stream of adj_bytes bytes at adj_off.
+#define CSR_ADJ_MAGIC 0x5A525343u     // "CSRZ"
+#define CSR_ADJ_VERSION 1
+#define CSR_ADJ_BLOCK_ROWS 64
+
+typedef struct {
+    int64_t byte_off;         // offset of the block in the adjacency stream
+    int64_t edge_off;         // edges of all earlier rows
+} CSRAdjBlock;
+
+typedef struct {
+    uint32_t magic;           // CSR_ADJ_MAGIC
+    uint32_t version;         // CSR_ADJ_VERSION
+    uint32_t endian_tag;      // CSR_FILE_ENDIAN_TAG as written by the writer
+    uint32_t block_rows;      // CSR_ADJ_BLOCK_ROWS
+    int64_t n;                // number of rows
+    int64_t nnz;              // number of edges
+    int64_t index_off;        // file offsets of the sections (CSR_FILE_ALIGN multiples)
+    int64_t adj_off;
+    int64_t adj_bytes;        // adjacency stream length (without the 16 zero bytes)
+    int64_t file_bytes;       // total file size
+    uint64_t data_checksum;   // csr_verify() checksum of the index and stream
+    uint64_t header_checksum; // checksum of the header bytes before this field
+} CSRAdjFileHeader;
+
+// Binary edge list written by `multithreaded <N> <STRUCT> --binary`
+// (STRUCT_N_file_links.bin), all fields little-endian:
+//   uint32 magic (CSR_EDGES_MAGIC), uint32 version (CSR_EDGES_VERSION),
+//   int32 n, int32 reserved (0), int64 strtab_bytes, int64 edge_count,
+//   strtab_bytes of strings: "path\0name\0" for node 0, 1, ..., n-1,
+//   edge_count packed (int32 src, int32 dst) pairs of node indices
+#define CSR_EDGES_MAGIC 0x424B4E4Cu   // "LNKB"
+#define CSR_EDGES_VERSION 1
+
 /**
  * Build CSR matrix from Part 1 output file and write to binary files.
+ * A binary edge list (CSR_EDGES_MAGIC) is detected and handed to
+ * csr_build_from_edges(). Large text files are parsed in parallel
+ * (csr_build_from_struct_threads() with one thread per 16 MiB, up to the
+ * online CPUs).
  * 
- * @param struct_path Path to the STRUCT_N_file_links.txt file from Part 1
+ * @param struct_path Path to the STRUCT_N_file_links.txt (or .bin) file from Part 1
  * @param csr_out_path Path where binary CSR matrix will be written (e.g., "data/P_CSR.bin")
  * @param nodes_out_path Path where nodes mapping file will be written (e.g., "data/nodes.txt")
  * @return 0 on success, -1 on failure
@@ -25,8 +109,121 @@ int csr_build_from_struct(const char *struct_path,
                          const char *csr_out_path,
                          const char *nodes_out_path);
 
+/**
+ * csr_build_from_struct() with an explicit number of build threads.
+ * The text is split at line boundaries over num_threads threads; the files
+ * written are byte-identical to a single-threaded build.
+ * 
+ * @param struct_path Path to the STRUCT_N_file_links.txt (or .bin) file from Part 1
+ * @param csr_out_path Path where binary CSR matrix will be written (e.g., "data/P_CSR.bin")
+ * @param nodes_out_path Path where nodes mapping file will be written (e.g., "data/nodes.txt")
+ * @param num_threads Build threads (<= 1: sequential streaming build)
+ * @return 0 on success, -1 on failure
+ */
+int csr_build_from_struct_threads(const char *struct_path,
+                                  const char *csr_out_path,
+                                  const char *nodes_out_path,
+                                  int num_threads);
+
+/**
+ * Build CSR matrix from a binary edge list and write to binary files.
+ * Node i of the edge list becomes row i; no text parsing or name lookup.
+ * 
+ * @param edges_path Path to the STRUCT_N_file_links.bin file from Part 1
+ * @param csr_out_path Path where binary CSR matrix will be written (e.g., "data/P_CSR.bin")
+ * @param nodes_out_path Path where nodes mapping file will be written (e.g., "data/nodes.txt")
+ * @return 0 on success, -1 on failure
+ */
+int csr_build_from_edges(const char *edges_path,
+                         const char *csr_out_path,
+                         const char *nodes_out_path);
+
+/**
+ * Write an in-memory crawl graph (from crawl_dir()) as the binary CSR and
+ * nodes files. Node i of the graph becomes row i; nothing is parsed.
+ * 
+ * @param g Graph returned by crawl_dir()
+ * @param csr_out_path Path where binary CSR matrix will be written (e.g., "data/P_CSR.bin")
+ * @param nodes_out_path Path where nodes mapping file will be written (e.g., "data/nodes.txt")
+ * @return 0 on success, -1 on failure
+ */
+int csr_build_from_graph(const struct CrawlGraph *g,
+                         const char *csr_out_path,
+                         const char *nodes_out_path);
+
+/**
+ * Write a compressed copy of a binary CSR file (see CSRAdjFileHeader).
+ * The loaders and P * pi kernels accept it in place of the plain file and
+ * give bit-identical results; csr_path and out_path may be the same file.
+ * 
+ * @param csr_path Path to the binary CSR file (e.g., "data/P_CSR.bin")
+ * @param out_path Path where the compressed file will be written
+ * @return 0 on success, -1 on failure
+ */
+int csr_compress_file(const char *csr_path, const char *out_path);
+
+// Vertex orders for csr_reorder()
+#define CSR_ORDER_DEGREE 1            // hub sorting: by in-degree, descending
+#define CSR_ORDER_RCM 2               // reverse Cuthill-McKee on the symmetrized graph
+
+// Permutation file written by csr_reorder() (e.g., "data/perm.bin"):
+//   uint32 magic (CSR_PERM_MAGIC), int32 n, int32 perm[n], where perm[i] is
+//   the current row (and nodes.txt line) of the node built as row i
+#define CSR_PERM_MAGIC 0x4D524550u    // "PERM"
+
+/**
+ * Renumber the nodes of a CSR file for cache locality of the P * pi
+ * kernels. The CSR and nodes files are rewritten in place with the same
+ * permutation (row i and nodes line i still describe the same file), so
+ * ranks come out per file as before. The permutation from the ids the
+ * CSR was built with is written to perm_path; if perm_path already holds
+ * one for the same n (an earlier reorder), the two are composed.
+ * Reorder before csr_compress_file(): compressed files are refused.
+ * 
+ * @param csr_path Path to the binary CSR file (e.g., "data/P_CSR.bin")
+ * @param nodes_path Path to the nodes mapping file (e.g., "data/nodes.txt")
+ * @param perm_path Path of the permutation file (e.g., "data/perm.bin")
+ * @param order CSR_ORDER_DEGREE or CSR_ORDER_RCM
+ * @return 0 on success, -1 on failure
+ */
+int csr_reorder(const char *csr_path, const char *nodes_path,
+                const char *perm_path, int order);
+
+/**
+ * Read a permutation file written by csr_reorder().
+ * 
+ * @param perm_path Path of the permutation file (e.g., "data/perm.bin")
+ * @param n_out Pointer to store the number of nodes
+ * @param perm_out Pointer to store perm (allocated; caller frees)
+ * @return 0 on success, -1 on failure
+ */
+int csr_load_perm(const char *perm_path, int32_t *n_out, int32_t **perm_out);
+
+/**
+ * Read n and nnz from the header of a binary CSR file (any version).
+ * 
+ * @param csr_path Path to the binary CSR file (e.g., "data/P_CSR.bin")
+ * @param n_out Pointer to store the number of rows
+ * @param nnz_out Pointer to store the number of edges (can be NULL)
+ * @return 0 on success, -1 on failure
+ */
+int csr_file_info(const char *csr_path, int32_t *n_out, int32_t *nnz_out);
+
+/**
+ * Check a binary CSR file end to end: header, section bounds, the data
+ * checksum and row_ptr / col_idx ranges. Loaders only check the header, so
+ * run this once before handing a file to many readers.
+ * 
+ * @param csr_path Path to the binary CSR file (e.g., "data/P_CSR.bin")
+ * @return 0 if the file is intact, -1 otherwise
+ */
+int csr_verify(const char *csr_path);
+
 /**
  * Load the entire CSR matrix from binary file into memory.
+ * A v2 file is mapped read-only and the arrays point into the mapping (no
+ * copy; pages are shared through the page cache); a v1 file is read into
+ * heap arrays. A compressed file is mapped too, and only adj is set.
  * 
  * @param csr_path Path to the binary CSR file (e.g., "data/P_CSR.bin")
  * @param g_out Pointer to CSR structure to populate (will allocate memory)
@@ -37,6 +234,9 @@ int load_full(const char *csr_path, CSR *g_out);
 /**
  * Load a partial range of rows from CSR binary file into memory.
  * Creates a self-contained CSR structure for the specified row range.
+ * For a v2 file col_idx and outdeg point into a mapping of the file; only
+ * row_ptr (rebased) is copied, and not even that when start_row is 0.
+ * For a compressed file only adj / adj_skip are set (nothing is copied).
  * 
  * @param csr_path Path to the binary CSR file (e.g., "data/P_CSR.bin")
  * @param start_row Starting row index (inclusive)
@@ -52,7 +252,8 @@ int load_rows(const char *csr_path,
              CSR *g_partial_out);
 
 /**
- * Free all dynamically allocated memory in a CSR structure.
+ * Free all dynamically allocated memory in a CSR structure (and unmap the
+ * file, for a mapped load).
  * 
  * @param g Pointer to CSR structure to free
  */
@@ -61,6 +262,8 @@ void csr_free(CSR *g);
 /**
  * Compute P * pi for all rows using the full CSR matrix.
  * This performs sparse matrix-vector multiplication.
+ * A compressed CSR is decoded on the fly (SSSE3 group-varint decoding when
+ * built with -mssse3 or -march=native).
  * 
  * @param g Pointer to full CSR matrix
  * @param pi_in Input PageRank vector (length g->n)
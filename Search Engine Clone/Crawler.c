@@ -0,0 +1,5288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <signal.h>
+
+#include "CSR.h"    // Binary edge list layout (CSR_EDGES_*)
+#include "Crawler.h"
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1     // Otherwise the read ring is never set up (blocking reads only)
+#endif
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ============================================================================
+// CS 140 PROJECT 2 - PART 1: MULTITHREADED GREP
+// ============================================================================
+// OPTIMIZATIONS IMPLEMENTED:
+//   1. Dynamic work queue (better load balancing than static partitioning)
+//   2. Batched file writes (reduces lock contention by 10x)
+//   3. Chunk-based processing (better cache locality)
+//   4. Removed unnecessary sleep(2) (proper synchronization suffices)
+//   5. In-process Aho-Corasick matcher (each file read once, no grep forks)
+//   6. mmap'd scanning with a SIMD prefilter (skips bytes that start no name)
+//   7. Growable node table with arena-allocated int32 edge vectors (no caps)
+//   8. Sharded filename index: O(1) de-duplication without a global lock
+//   9. Work-stealing directory deques (no shared queue lock, no capacity cap)
+//  10. getdents64 batches + d_type: no per-entry stat() or path re-copying
+//  11. Inlinks by transposing the outlinks (no second n-wide pass per file)
+//  12. --incremental: manifest of size/mtime/XXH64 so only changed files rescan
+//  13. --binary: packed edge list + string table for direct CSR ingestion
+//  14. Per-event lines compiled out by LOG(); --trace keeps lock-free binary
+//      per-thread event buffers instead (decode with trace_decode.py)
+//  15. Cost-aware scan scheduling: largest files first, guided chunk sizes
+//  16. Async output writer: workers hand 1 MiB blocks to one writer thread
+//      through a lock-free queue; one long-lived fd, coalesced writev()s
+//  17. io_uring read ring: --queue-depth open/read/close chains in flight per
+//      thread, scanned as they complete (blocking mmap reads as the fallback)
+//  18. Prefetcher thread: WILLNEED readahead for files as Task Queue 0 finds
+//      them, so the device works during discovery (--prefetch-mb budget)
+//  19. Content dedup: byte-identical files (same size, same XXH64) are
+//      scanned once and the outlink set is copied to the others
+//  20. --shards K: discovery and scanning split over K processes, merged by
+//      a coordinator into one link file / edge list
+//  21. --mem-mb MB: edges beyond the budget are spilled as sorted runs and
+//      k-way merged into the same output
+//  22. --watch: inotify keeps the graph current after the crawl; changed
+//      files are rescanned and +E/-E edge events streamed per batch
+//  23. Library build: crawl_dir() returns the graph in memory (no link file),
+//      multithreaded.c is only the command line front end (crawler_main)
+// ============================================================================
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+#define MAX_FILENAME 256                // Maximum length of a filename
+#ifndef PATH_MAX
+#define PATH_MAX 4096                   // Maximum path length
+#endif
+#define CHUNK_SIZE 10                   // Process files in chunks for better cache locality
+#define SCAN_FILE_COST 4096             // Fixed cost of scanning any file (open/mmap), in bytes
+#define SCAN_CHUNK_MAX 256              // Most files handed out per scan chunk
+#define SCAN_GUIDE_FACTOR 2             // Scan chunk = remaining cost / (factor * threads)
+#define SCAN_COST_CLASSES 64            // Power-of-two cost classes used to order the scan
+#define OUTPUT_BLOCK_SIZE (1 << 20)     // Output bytes a worker collects before handing them off
+#define OUTPUT_POOL_BLOCKS 3            // Output blocks per worker (one filling, two with the writer)
+#define WRITER_MAX_IOV 64               // Output blocks coalesced into one writev()
+#define DEFAULT_QUEUE_DEPTH 32          // Files each thread keeps in flight in its read ring
+#define MAX_QUEUE_DEPTH 1024            // Largest accepted --queue-depth
+#define READ_RING_MAX_FILE (256 * 1024) // Larger files are scanned by scan_file_contents instead
+#define DEFAULT_PREFETCH_MB 256         // Bytes of file contents prefetched during discovery
+#define PREFETCH_QUEUE_SIZE 65536       // Files waiting for the prefetcher (more are dropped)
+#define PREFETCH_BATCH 256              // Files handed over / prefetched per lock acquisition
+#define MAX_SHARDS 256                  // Largest accepted --shards
+#define SHARD_SPLIT_DIRS 32             // Directories per shard wanted at the split depth
+#define SHARD_EDGES_MAGIC 0x53444853u   // "SHDS": partial edge list of one shard
+#define SHARD_EDGES_VERSION 1
+#define SPILL_MIN_KEYS (64 * 1024)      // Smallest per-thread edge buffer under --mem-mb
+#define SPILL_THREAD_OVERHEAD (1 << 20) // Stack, io_uring rings and malloc arena of a thread
+#define SPILL_READ_MIN 256              // Keys a merge reads ahead per run, at least ...
+#define SPILL_READ_MAX 65536            // ... and at most
+#define SPILL_CHUNKS_PER_THREAD 16      // Node ranges per thread in the spilled merge
+#define WATCH_SETTLE_MS 100             // Quiet time that closes a batch of watch events
+#define WATCH_MAX_DELAY_MS 1000         // Longest a change waits while events keep coming
+#define WATCH_EVENT_BUF 65536           // Bytes of inotify events read per read()
+#define TRANSPOSE_CHUNK_SIZE 256        // Files per chunk in the cheap inlink transpose phases
+#define NODE_BLOCK_SHIFT 12             // Node table grows in blocks of 2^12 FileLinks
+#define NODE_BLOCK_SIZE (1 << NODE_BLOCK_SHIFT)
+#define NODE_MAX_BLOCKS 65536           // Block directory size (65536 * 4096 = 268M files)
+#define ARENA_BLOCK_SIZE (1 << 20)      // Bytes per arena block (bigger requests get their own)
+#define NAME_SHARDS 64                  // Independently locked slices of the filename index
+#define SCAN_BUFFER_SIZE (64 * 1024)    // Bytes read per read() call when a file cannot be mmap'd
+#define MATCHER_SIMD_MAX_BYTES 8        // Max distinct first bytes screened with SIMD compares
+#define DIRENT_BUF_SIZE (256 * 1024)    // Bytes of directory entries fetched per getdents64 call
+#define MANIFEST_VERSION 1              // Incremental crawl manifest format
+#define TRACE_BUFFER_RECORDS 4096       // Trace events buffered per thread between writes
+#define TRACE_MAGIC 0x43525443u         // "CTRC": trace file magic
+#define TRACE_VERSION 1
+
+// Log levels: LOG(level, ...) only exists in the binary when level <= LOG_LEVEL
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_EVENT 2               // One line per directory, file and link
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG(level, ...) \
+    do { if ((level) <= LOG_LEVEL) printf(__VA_ARGS__); } while (0)
+
+// Sharded crawl roles (see SHARDED CRAWL)
+#define SHARD_NONE 0                    // Ordinary single-process crawl
+#define SHARD_DISCOVER 1                // Child: record the files in this shard's directories
+#define SHARD_SCAN 2                    // Child: scan this shard's files, write its edges
+#define SHARD_MERGE 3                   // Coordinator: merge the edges and write the output
+
+// DedupSlot states
+#define DEDUP_PENDING 0                 // Owner still scanning
+#define DEDUP_DONE 1                    // Owner's outlinks are the content's matches
+#define DEDUP_DONE_SELF 2               // ... plus the owner itself (it names itself)
+
+// Trace events (see trace_event); a and b are event specific
+enum {
+    TRACE_DIR_BEGIN = 1,    // a = 1 if the directory was stolen
+    TRACE_DIR_END,          // a = files recorded, b = subdirectories pushed
+    TRACE_FILE,             // a = node index, b = 1 if newly inserted
+    TRACE_SCAN_BEGIN,       // a = node index
+    TRACE_SCAN_END,         // a = node index, b = outlink count
+    TRACE_PHASE,            // a = Task Queue 1 phase finished by this thread
+    TRACE_INLINK,           // a = node index, b = node index linking to it
+    TRACE_WRITE             // a = bytes handed to the output writer
+};
+#ifdef TRACE_DISABLED
+#define TRACE(tid, type, a, b) do { (void)(tid); (void)(a); (void)(b); } while (0)
+#else
+#define TRACE(tid, type, a, b) \
+    do { if (trace_fd != -1) trace_event((tid), (type), (a), (b)); } while (0)
+#endif
+
+// ============================================================================
+// GLOBAL VARIABLES
+// ============================================================================
+
+static int NUM_THREADS;            // Number of worker threads (from command line)
+static char DIR_STRUCTURE[50];     // Directory structure type (connected, forest, full, random)
+static int DEBUG = 0;              // Debug mode flag (TRUE/FALSE)
+static int INCREMENTAL = 0;        // --incremental: reuse the previous crawl's manifest
+static int BINARY_OUTPUT = 0;      // --binary: write the packed edge list instead of text
+static int QUEUE_DEPTH = DEFAULT_QUEUE_DEPTH;  // --queue-depth: io_uring reads in flight per thread (0 = off)
+static int64_t PREFETCH_BUDGET = (int64_t)DEFAULT_PREFETCH_MB << 20;  // --prefetch-mb, in bytes (0 = off)
+static int DEDUP = 1;              // --no-dedup: scan byte-identical files separately
+static int SHARD_COUNT = 0;        // --shards K: crawl with K processes (0 = single process)
+static int SHARD_INDEX = -1;       // Shard handled by this process (-1 = coordinator)
+static int SHARD_ROLE = 0;         // SHARD_* step this process performs
+static int SHARD_SPLIT_DEPTH = 1;  // Depth whose subtrees are dealt out to discovery shards
+static int64_t MEMORY_BUDGET = 0;  // --mem-mb: bytes the crawl may keep resident (0 = no limit)
+static int WATCH = 0;              // --watch: keep following files/ after the crawl
+static char CRAWL_ROOT[PATH_MAX] = "files/";  // Directory crawled, with a trailing slash
+static int QUIET = 0;              // crawl_dir(): no progress banners on stdout
+
+// ============================================================================
+// DATA STRUCTURES
+// ============================================================================
+
+// FileLink Struct: Storing information about a single file and its connections
+// SPEC Section 3.1.2 -- Store path, name, inlinks, outlinks
+// Links are node indices (see file_link()), so an entry costs 64 bytes plus
+// 4 bytes per edge instead of fixed-size filename arrays.
+typedef struct {
+    const char *path;       // Full path: "files/subdir/A.txt" (interned by intern_file)
+    const char *name;       // Filename: "A.txt" (points at the tail of path)
+    int32_t *inlinks;       // Ascending indices of files mentioning THIS file
+    int32_t inlink_count;   // Number of inlinks found
+    int32_t *outlinks;      // Ascending indices of files THIS file mentions
+    int32_t outlink_count;  // Number of outlinks found
+    int64_t size;           // File size when discovered (drives scan scheduling)
+    int64_t mtime_ns;       // Modification time in ns when discovered
+    uint64_t hash;          // XXH64 of the contents (incremental crawl only)
+} FileLink;
+
+// ArenaBlock/Arena: Bump allocator for strings and edge vectors
+// Nothing is freed individually; arena_free() releases every block at once.
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;    // Previously allocated block
+    size_t used;                // Bytes handed out from data[]
+    size_t size;                // Capacity of data[]
+    char data[];                // Payload (8-byte aligned)
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;           // Block currently being filled
+} Arena;
+
+// NameSlot/NameShard: One lock-protected slice of the filename index
+// A name lives in shard (hash % NAME_SHARDS); its slot records the node index.
+typedef struct {
+    uint64_t hash;              // Full hash of the filename
+    int32_t id;                 // Node index, -1 = empty slot
+} NameSlot;
+
+typedef struct {
+    pthread_mutex_t lock;       // Protects everything below
+    NameSlot *slots;            // Open-addressing table (linear probing)
+    size_t capacity;            // Slots allocated (power of two, kept <= 50% full)
+    size_t count;               // Slots in use
+    Arena arena;                // Interned paths for names in this shard
+} NameShard;
+
+// IdVector: Growable scratch list of node indices (one per worker thread)
+typedef struct {
+    int32_t *ids;               // Storage
+    int32_t count;              // Entries in use
+    int32_t capacity;           // Entries allocated
+} IdVector;
+
+// OutBuf: Growable byte buffer for batched output lines
+typedef struct {
+    char *data;                 // Storage
+    size_t len;                 // Bytes in use
+    size_t cap;                 // Bytes allocated
+} OutBuf;
+
+// OutBlock: Output lines travelling from a T-1 worker to the writer thread
+// and back again once written (see ASYNC OUTPUT WRITER)
+typedef struct OutBlock {
+    struct OutBlock *next;      // Next block in the writer queue or a free list
+    OutBuf buf;                 // Complete output lines
+    int owner;                  // Worker whose free list the block returns to
+} OutBlock;
+
+// ReadSlot/ReadRing: A thread's io_uring instance and the files it is reading
+// Slot i uses fixed-file index i, so open -> read -> close chain without the
+// fd ever returning to user space (see IO_URING READ ENGINE).
+typedef struct {
+    int file_idx;               // File being read, -1 = free
+    unsigned char *buf;         // Receives the contents
+    size_t cap;                 // Bytes allocated in buf
+    size_t want;                // Bytes requested (discovered size + 1)
+    int pending;                // Completions still expected (open, read, close)
+    int32_t open_res;           // Result of the open (< 0 = -errno)
+    int32_t read_res;           // Bytes read (< 0 = -errno)
+} ReadSlot;
+
+typedef struct {
+    int ring_fd;                // -1 = no ring (blocking reads)
+    int depth;                  // Number of slots
+    ReadSlot *slots;            // [depth]
+    int *ready;                 // [depth] slots whose chain has fully completed
+    int ready_count;            // Entries in ready
+    int in_flight;              // Slots in use
+    unsigned to_submit;         // SQEs queued but not yet passed to the kernel
+    void *sq_ring, *cq_ring;    // Shared ring mappings (may be the same mapping)
+    size_t sq_ring_len, cq_ring_len;
+    struct io_uring_sqe *sqes;  // Submission entries
+    size_t sqes_len;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;  // Completion entries
+} ReadRing;
+
+// DedupSlot: One distinct file content in the dedup table (see scan_buffer_dedup)
+typedef struct {
+    uint64_t key;               // XXH64 of the contents seeded with their size, 0 = empty
+    int32_t owner;              // File that scans this content
+    int32_t state;              // DEDUP_PENDING until the owner's outlinks are final
+} DedupSlot;
+
+// SpillBuffer: A Task Queue 1 thread's edges under --mem-mb (see SPILLED ADJACENCY)
+typedef struct {
+    uint64_t *keys;             // (src << 32 | dst) per edge (anonymous mapping)
+    size_t mapped;              // Bytes mapped at keys
+    int64_t count;              // Keys in use (at most spill_cap)
+    int out_fd;                 // Runs sorted by source, -1 until the first spill
+    int in_fd;                  // The same runs sorted by target
+    int64_t written;            // Keys written to each file so far
+} SpillBuffer;
+
+// SpillRun: One sorted run, stored once in each order (see spill_flush)
+typedef struct {
+    int out_fd;                 // Run sorted by (src, dst)
+    int in_fd;                  // Run sorted by (dst, src)
+    int64_t first;              // Offset of its first key in both files (in keys)
+    int64_t count;              // Keys in the run
+} SpillRun;
+
+// SpillCursor/SpillMerge: k-way merge over every run in one order
+typedef struct {
+    int fd;                     // File holding the run
+    int64_t first;              // First key of the run (in keys)
+    int64_t next;               // Next key to read ahead
+    int64_t end;                // One past the run's last key
+    uint64_t *buf;              // Keys read ahead
+    int pos;                    // Next key of buf to merge
+    int len;                    // Keys in buf
+} SpillCursor;
+
+typedef struct {
+    SpillCursor *cursors;       // One per run
+    int count;                  // Number of runs
+    int *heap;                  // Cursors with keys left, min-heap on their next key
+    int heap_count;             // Entries in heap
+    int buf_keys;               // Keys each cursor reads ahead
+} SpillMerge;
+
+// PathList: Paths touched since the last watch batch (may repeat)
+typedef struct {
+    char **paths;               // Heap copies
+    int count;                  // Entries in use
+    int cap;                    // Entries allocated
+} PathList;
+
+// WatchJob: One file a watch batch scans, and what the scan found
+typedef struct {
+    int32_t idx;                // File to scan
+    int delta;                  // 1 = unchanged file, only look for the batch's new names
+    int32_t *found;             // Ascending matches (malloc'd)
+    int32_t found_count;        // Entries in found
+    int failed;                 // Could not be read: its outlinks are left alone
+} WatchJob;
+
+// PrefetchQueue: Files found by Task Queue 0, waiting for the prefetcher
+typedef struct {
+    pthread_mutex_t lock;       // Protects everything below
+    pthread_cond_t nonempty;    // Signalled on push and on stop
+    int32_t ids[PREFETCH_QUEUE_SIZE]; // Ring of node indices
+    size_t head;                // Next index to prefetch
+    size_t tail;                // One past the newest index
+    int stop;                   // Set by main once Task Queue 1 takes over
+} PrefetchQueue;
+
+// Xxh64State: Streaming XXH64 content hash
+typedef struct {
+    uint64_t v[4];              // Lane accumulators
+    uint64_t seed;              // Hash seed
+    uint64_t total_len;         // Bytes hashed so far
+    unsigned char buf[32];      // Partial stripe carried between updates
+    uint32_t buffered;          // Bytes in buf
+} Xxh64State;
+
+// ManifestEntry/Manifest: The previous crawl, as loaded for --incremental
+typedef struct {
+    const char *path;           // Path as discovered ("files/sub/A.txt")
+    int64_t size;               // File size when it was crawled
+    int64_t mtime_ns;           // Modification time when it was crawled
+    uint64_t hash;              // XXH64 of the contents
+    int32_t out_count;          // Number of outlinks
+    size_t out_first;           // First outlink in Manifest.names
+} ManifestEntry;
+
+typedef struct {
+    char *data;                 // File contents (all strings point in here)
+    ManifestEntry *entries;     // One per file
+    int count;                  // Number of entries
+    const char **names;         // Outlink names of all entries, back to back
+    int32_t *slots;             // Path -> entry index (open addressing, -1 = empty)
+    size_t slot_mask;           // slots has slot_mask + 1 entries
+} Manifest;
+
+// TraceRecord/TraceBuffer: One binary trace event and a thread's pending events
+// The {tid, count} prefix doubles as the block header in the trace file.
+typedef struct {
+    uint64_t ns;                // CLOCK_MONOTONIC timestamp
+    uint32_t type;              // TRACE_* event
+    int32_t a;                  // Event argument
+    int32_t b;                  // Event argument
+    int32_t reserved;           // Keeps records 8-byte aligned
+} TraceRecord;
+
+typedef struct {
+    int32_t tid;                // Owning thread
+    uint32_t count;             // Records in use
+    TraceRecord records[TRACE_BUFFER_RECORDS];
+} TraceBuffer;
+
+typedef struct {
+    uint32_t magic;             // TRACE_MAGIC
+    uint32_t version;           // TRACE_VERSION
+    uint32_t record_size;       // sizeof(TraceRecord)
+    uint32_t reserved;
+} TraceFileHeader;
+
+// WorkDeque: Per-thread deque of directory paths for Task Queue 0
+// SPEC Section 3.1.3 - Producer/Consumer pattern for directory traversal
+// The owner works at the bottom; other threads steal from the top.
+typedef struct{
+    pthread_mutex_t lock;   // Protects this deque only (contended only by thieves)
+    char **items;           // Ring buffer of heap-allocated paths
+    size_t capacity;        // Ring size (power of two, grows on demand)
+    size_t top;             // Index of the oldest item (steal end)
+    size_t bottom;          // Index one past the newest item (owner end)
+} WorkDeque;
+
+// linux_dirent64: Record layout returned by the getdents64 syscall
+// (glibc only wraps it in newer versions, so it is declared here)
+struct linux_dirent64 {
+    uint64_t d_ino;         // Inode number
+    int64_t d_off;          // Offset of the next record
+    unsigned short d_reclen;// Size of this record
+    unsigned char d_type;   // DT_DIR, DT_REG, ... or DT_UNKNOWN
+    char d_name[];          // Null-terminated filename
+};
+
+// ThreadArgs: Arguments passed to each worker thread
+typedef struct{
+    int thread_id;   // Thread ID (0 to NUM_THREADS-1)
+} ThreadArgs;
+
+// WorkQueue: Dynamic work distribution for Task Queue 1
+//  Better load balancing than static (file_idx % NUM_THREADS)
+typedef struct {
+    int next_scan_idx;      // Next position in scan_order to be scanned (phase 1)
+    int64_t scan_cost_left; // Estimated cost of the files not yet handed out (phase 1)
+    int next_reserve_idx;   // Next file whose inlink vector is allocated (phase 2)
+    int next_scatter_idx;   // Next file whose outlinks are transposed (phase 3)
+    int next_file_idx;      // Next file index to be processed (phase 4)
+} WorkQueue;
+
+// LinkMatcher: Aho-Corasick automaton over every discovered filename
+// Built once after Task Queue 0; read-only (shared by all threads) afterwards.
+// Each state's goto edges are stored contiguously and sorted by byte, so a
+// lookup is a binary search over a handful of edges. The root keeps a dense
+// 256-entry row since nearly every byte of a file is read from the root.
+typedef struct {
+    int state_count;        // Number of trie states (state 0 is the root)
+    int *root_next;         // [256] goto from root (0 = stay at root)
+    int *edge_start;        // [state_count + 1] first edge of each state
+    unsigned char *edge_byte; // [edges] byte labelling each edge (sorted per state)
+    int *edge_target;       // [edges] state reached through each edge
+    int *fail;              // [state_count] longest proper suffix that is also a trie path
+    int *output;            // [state_count] node index of the name ending here, or -1
+    int *dict;              // [state_count] nearest suffix state with an output, or 0
+    // Prefilter (see matcher_skip)
+    unsigned char first_bytes[MATCHER_SIMD_MAX_BYTES]; // Distinct first bytes of all names
+    int first_byte_count;   // Number of distinct first bytes (> MAX means scalar screening)
+    uint8_t *pair_bits;     // [65536 bits] valid (first byte, second byte) pairs
+} LinkMatcher;
+
+// ============================================================================
+// GLOBAL SHARED DATA
+// ============================================================================
+
+// Node table: every file found, addressed through file_link(idx)
+// Blocks are allocated on demand and never move, so pointers stay valid.
+static FileLink *node_blocks[NODE_MAX_BLOCKS]; // Block directory (NULL = not yet allocated)
+static int file_link_count = 0;                // Number of files currently in the table
+
+static NameShard name_shards[NAME_SHARDS];    // Filename -> node index (see intern_file)
+static Arena *edge_arenas = NULL;      // Edge vectors, one arena per Task Queue 1 thread
+
+// Work queue for dynamic load balancing in Task Queue 1
+static WorkQueue work_queue = {0};
+static int32_t *scan_order = NULL;     // Phase 1 order: node indices, most expensive first
+static int scan_order_count = 0;       // Files in scan_order
+static int scan_first = 0;             // Files [scan_first, scan_end) are scanned by this process
+static int scan_end = -1;              // (-1 = every file)
+
+// Directory deques for Task Queue 0, one per thread
+static WorkDeque *dir_deques = NULL;
+
+// --trace: output file and one event buffer per thread (see trace_event)
+static int trace_fd = -1;
+static TraceBuffer *trace_buffers = NULL;
+
+// Filename matcher shared by all Task Queue 1 threads
+static LinkMatcher link_matcher = {0};
+
+// Async output writer (see writer_worker)
+static OutBlock *writer_queue = NULL;      // Submitted blocks, newest first (lock-free stack)
+static OutBlock **free_blocks = NULL;      // Written blocks, one lock-free stack per worker
+static sem_t *blocks_returned = NULL;      // Per worker, posted when the writer returns a block
+static OutBlock *block_pool = NULL;        // [NUM_THREADS * OUTPUT_POOL_BLOCKS], allocated by writer_start
+static sem_t writer_sem;                   // Posted per submitted block and at shutdown
+static pthread_t writer_thread;
+static int writer_fd = -1;                 // Link file, open for the whole of Task Queue 1
+static int writer_done = 0;                // Set once every worker has submitted its last block
+static int writer_failed = 0;              // A write failed (reported by writer_finish)
+
+// Content dedup (see scan_buffer_dedup)
+static DedupSlot *dedup_slots = NULL;      // Open addressing over possible duplicates
+static size_t dedup_mask = 0;              // dedup_slots has dedup_mask + 1 entries
+static unsigned char *dedup_twin = NULL;   // [file_link_count] 1 = another file has the same size
+static int files_deduped = 0;              // Files whose outlinks were copied
+static int64_t dedup_bytes_saved = 0;      // Bytes those files would have been scanned for
+
+// Memory-budget crawl (see SPILLED ADJACENCY)
+static SpillBuffer *spill_buffers = NULL;  // One per Task Queue 1 thread (NULL = no budget)
+static int64_t spill_cap = 0;              // Keys a buffer holds before it is spilled
+static SpillRun *spill_runs = NULL;        // Every run written so far
+static int spill_run_count = 0;
+static int spill_run_cap = 0;
+static int spill_active = 0;               // A buffer overflowed: the output comes from the runs
+static int64_t spilled_keys = 0;           // Edges written to runs
+
+// Watch mode (see run_watch)
+static volatile sig_atomic_t watch_stop = 0;  // Set by SIGINT/SIGTERM
+static int watch_fd = -1;                  // inotify instance
+static char **watch_dirs = NULL;           // Watch descriptor -> directory path ("files/sub/")
+static int watch_dir_cap = 0;              // Entries allocated in watch_dirs
+static unsigned char *node_dead = NULL;    // [node_flag_cap] file removed since the crawl
+static unsigned char *node_owned = NULL;   // [node_flag_cap] outlinks malloc'd by a watch batch
+static int node_flag_cap = 0;
+static Arena watch_paths = {0};            // New paths of names that came back elsewhere
+static WatchJob *watch_jobs = NULL;        // Scans of the current batch
+static int watch_job_count = 0;
+static int watch_next_job = 0;             // Next job a batch thread takes
+static FILE *watch_out = NULL;             // Edge event stream (STRUCT_N_events.txt)
+
+// Prefetcher (see prefetch_worker)
+static PrefetchQueue prefetch_queue = {
+    .lock = PTHREAD_MUTEX_INITIALIZER, .nonempty = PTHREAD_COND_INITIALIZER
+};
+static pthread_t prefetch_thread;
+static int prefetch_running = 0;           // Started by this process and not yet stopped
+static int64_t prefetched_bytes = 0;       // Written by the prefetcher only
+static int prefetched_files = 0;
+
+// Incremental crawl state (see recrawl_file)
+static Manifest manifest = {0};            // Previous crawl
+static LinkMatcher delta_matcher = {0};    // Names added since the previous crawl
+static int new_name_count = 0;             // Number of names in delta_matcher
+static int files_reused = 0;               // Same size and mtime
+static int files_touched = 0;              // New mtime but same contents
+static int files_rescanned = 0;            // New or changed
+
+// ============================================================================
+// SYNCHRONIZATION PRIMITIVES
+// ============================================================================
+// SPEC Section 3.1.3 - Using MUTEXES for thread-safe operations
+static pthread_mutex_t work_mutex = PTHREAD_MUTEX_INITIALIZER;         //  Protects work queue
+static pthread_barrier_t phase_barrier;                                // Separates the Task Queue 1 phases
+static pthread_mutex_t spill_mutex = PTHREAD_MUTEX_INITIALIZER;        // Protects the spill run list
+
+// ============================================================================
+// CONTROL FLAGS
+// ============================================================================
+// Directories pushed but not yet finished; Task Queue 0 is done when it hits 0
+static int pending_dirs = 0;
+
+// ============================================================================
+// WORK-STEALING DEQUES FOR TASK QUEUE 0
+// ============================================================================
+// SPEC Section 3.1.3 - Producer/consumer directory queue, one deque per thread.
+// Each thread pushes the subdirectories it finds onto its own deque and pops
+// them back (LIFO); an idle thread steals the oldest entry from another deque
+// (FIFO), which tends to hand over a large unexplored subtree. Deques grow on
+// demand, so there is no capacity ceiling.
+
+// SPEC Section 3.1.3 - Initialize an empty directory deque
+static void init_deque(WorkDeque *d){
+    pthread_mutex_init(&d->lock, NULL);
+    d->items = NULL;
+    d->capacity = 0;
+    d->top = 0;
+    d->bottom = 0;
+}
+
+// Release a deque (and any paths still in it)
+static void free_deque(WorkDeque *d){
+    for (size_t i = d->top; i < d->bottom; i++) {
+        free(d->items[i & (d->capacity - 1)]);
+    }
+    free(d->items);
+    pthread_mutex_destroy(&d->lock);
+}
+
+// Push a directory path onto the bottom of deque `owner`
+// Counts it as pending until finish_dir() is called for it
+// SPEC: Producer operation in producer/consumer pattern
+static int push_dir(int owner, const char *path){
+    WorkDeque *d = &dir_deques[owner];
+    char *copy = strdup(path);
+    if (!copy) {
+        fprintf(stderr, "ERROR: Out of memory queueing %s\n", path);
+        return -1;  // Failure
+    }
+
+    __atomic_fetch_add(&pending_dirs, 1, __ATOMIC_ACQ_REL);
+    pthread_mutex_lock(&d->lock);
+    // -------------------------------
+    if (d->bottom - d->top == d->capacity) {
+        // Full (or never allocated): double the ring, keeping order
+        size_t capacity = d->capacity ? d->capacity * 2 : 64;
+        char **items = malloc(capacity * sizeof(char *));
+        if (!items) {
+            pthread_mutex_unlock(&d->lock);
+            __atomic_fetch_sub(&pending_dirs, 1, __ATOMIC_ACQ_REL);
+            free(copy);
+            fprintf(stderr, "ERROR: Out of memory growing directory deque\n");
+            return -1;
+        }
+        size_t count = d->bottom - d->top;
+        for (size_t i = 0; i < count; i++) {
+            items[i] = d->items[(d->top + i) & (d->capacity - 1)];
+        }
+        free(d->items);
+        d->items = items;
+        d->capacity = capacity;
+        d->top = 0;
+        d->bottom = count;
+    }
+    d->items[d->bottom & (d->capacity - 1)] = copy;
+    d->bottom++;
+    // -------------------------------
+    pthread_mutex_unlock(&d->lock);
+    return 0;       // Success
+}
+
+// Take the newest path from our own deque, or NULL if it is empty
+// SPEC: Consumer operation in producer/consumer pattern
+static char *pop_dir(int owner){
+    WorkDeque *d = &dir_deques[owner];
+    char *path = NULL;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) {
+        d->bottom--;
+        path = d->items[d->bottom & (d->capacity - 1)];
+    }
+    pthread_mutex_unlock(&d->lock);
+    return path;
+}
+
+// Take the oldest path from some other thread's deque, or NULL if all are empty
+static char *steal_dir(int thief){
+    for (int k = 1; k < NUM_THREADS; k++) {
+        WorkDeque *d = &dir_deques[(thief + k) % NUM_THREADS];
+        char *path = NULL;
+        pthread_mutex_lock(&d->lock);
+        if (d->bottom > d->top) {
+            path = d->items[d->top & (d->capacity - 1)];
+            d->top++;
+        }
+        pthread_mutex_unlock(&d->lock);
+        if (path) return path;
+    }
+    return NULL;
+}
+
+// Mark one popped/stolen directory as fully processed
+// Its subdirectories were pushed (and counted) before this call, so
+// pending_dirs only reaches 0 once the whole tree has been walked.
+static void finish_dir(char *path){
+    free(path);
+    __atomic_fetch_sub(&pending_dirs, 1, __ATOMIC_ACQ_REL);
+}
+
+// ============================================================================
+//  DYNAMIC WORK DISTRIBUTION
+// ============================================================================
+// Get next chunk of work for Task Queue 1
+// BENEFIT: Better load balancing than static partitioning
+// Each thread grabs chunks dynamically, so fast threads don't idle
+// `cursor` selects the phase (one of the work_queue.next_*_idx fields)
+static int get_next_work_chunk(int *cursor, int *start_idx, int chunk_size) {
+    pthread_mutex_lock(&work_mutex);
+    // -------------------------------
+    if (*cursor >= file_link_count) {
+        pthread_mutex_unlock(&work_mutex);
+        return -1;  // No more work available
+    }
+    
+    *start_idx = *cursor;                           // Give thread this starting index
+    *cursor += chunk_size;                          // Reserve next chunk
+    // -------------------------------
+    pthread_mutex_unlock(&work_mutex);
+    return 0;  // Success - thread got work
+}
+
+// ============================================================================
+// ARENA AND NODE TABLE
+// ============================================================================
+
+// Allocate `bytes` (8-byte aligned) from the arena. Returns NULL on failure
+static void *arena_alloc(Arena *a, size_t bytes) {
+    bytes = (bytes + 7) & ~(size_t)7;
+    ArenaBlock *b = a->head;
+    if (b && b->size - b->used >= bytes) {
+        void *p = b->data + b->used;
+        b->used += bytes;
+        return p;
+    }
+
+    size_t size = (bytes > ARENA_BLOCK_SIZE) ? bytes : ARENA_BLOCK_SIZE;
+    ArenaBlock *nb = malloc(sizeof(ArenaBlock) + size);
+    if (!nb) return NULL;
+    nb->size = size;
+    nb->used = bytes;
+
+    if (b && size > ARENA_BLOCK_SIZE) {
+        // Oversized request: park it behind the current block, keep filling that
+        nb->next = b->next;
+        b->next = nb;
+    } else {
+        nb->next = b;
+        a->head = nb;
+    }
+    return nb->data;
+}
+
+// Copy len bytes into the arena as a NUL-terminated string
+static char *arena_strndup(Arena *a, const char *s, size_t len) {
+    char *copy = arena_alloc(a, len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// Release every block owned by the arena
+static void arena_free(Arena *a) {
+    ArenaBlock *b = a->head;
+    while (b) {
+        ArenaBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    a->head = NULL;
+}
+
+// Node table lookup (idx must be < file_link_count)
+// The block pointer is loaded atomically: Task Queue 0 looks nodes up while
+// other threads are still installing blocks (a plain mov on x86 either way).
+static inline FileLink *file_link(int idx) {
+    FileLink *block = __atomic_load_n(&node_blocks[idx >> NODE_BLOCK_SHIFT], __ATOMIC_RELAXED);
+    return &block[idx & (NODE_BLOCK_SIZE - 1)];
+}
+
+// Make sure the block holding idx exists (safe to call from any thread)
+// Returns 0 on success, -1 on failure
+static int node_table_reserve(int idx) {
+    int block = idx >> NODE_BLOCK_SHIFT;
+    if (block >= NODE_MAX_BLOCKS) {
+        fprintf(stderr, "ERROR: NODE TABLE FULL (MAX %lld FILES)\n",
+                (long long)NODE_MAX_BLOCKS * NODE_BLOCK_SIZE);
+        return -1;
+    }
+    if (__atomic_load_n(&node_blocks[block], __ATOMIC_ACQUIRE)) return 0;
+
+    FileLink *fresh = calloc(NODE_BLOCK_SIZE, sizeof(FileLink));
+    if (!fresh) {
+        fprintf(stderr, "ERROR: Out of memory growing node table\n");
+        return -1;
+    }
+    FileLink *expected = NULL;
+    if (!__atomic_compare_exchange_n(&node_blocks[block], &expected, fresh, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(fresh);    // Another thread installed the block first
+    }
+    return 0;
+}
+
+// Release the node table and the interning index
+static void free_node_table(void) {
+    for (int b = 0; b < NODE_MAX_BLOCKS && node_blocks[b]; b++) {
+        free(node_blocks[b]);
+        node_blocks[b] = NULL;
+    }
+    file_link_count = 0;
+    for (int s = 0; s < NAME_SHARDS; s++) {
+        free(name_shards[s].slots);
+        name_shards[s].slots = NULL;
+        name_shards[s].capacity = 0;
+        name_shards[s].count = 0;
+        arena_free(&name_shards[s].arena);
+    }
+}
+
+// ============================================================================
+// LOGGING AND TRACING
+// ============================================================================
+// Per-event lines (one per directory, file and link) go through LOG() at
+// LOG_LEVEL_EVENT, so the default build compiles them away instead of
+// serializing every thread on the stdout lock. Build with -DLOG_LEVEL=2 to
+// get them back.
+//
+// --trace FILE records the same events as fixed-size binary records in a
+// per-thread buffer (no locks, no formatting). A full buffer is written out
+// with a single O_APPEND write(), which the kernel keeps whole, so threads
+// never coordinate. main appends the node paths at the end so
+// trace_decode.py can print names. Build with -DTRACE_DISABLED to remove
+// even the "is tracing on" check.
+//
+// Trace file: TraceFileHeader, then blocks of {int32 tid, uint32 count}
+// followed by `count` TraceRecords; the final block has tid -1 and is
+// followed by `count` null-terminated node paths (index order).
+
+// Write out and empty one thread's trace buffer
+static void trace_flush(int tid) {
+    TraceBuffer *t = &trace_buffers[tid];
+    if (t->count == 0) return;
+    size_t bytes = offsetof(TraceBuffer, records) + t->count * sizeof(TraceRecord);
+    if (write(trace_fd, t, bytes) != (ssize_t)bytes) {
+        perror("write trace");
+    }
+    t->count = 0;
+}
+
+// Append one event to the calling thread's trace buffer
+static inline void trace_event(int tid, uint32_t type, int32_t a, int32_t b) {
+    TraceBuffer *t = &trace_buffers[tid];
+    if (t->count == TRACE_BUFFER_RECORDS) {
+        trace_flush(tid);
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    TraceRecord *r = &t->records[t->count++];
+    r->ns = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    r->type = type;
+    r->a = a;
+    r->b = b;
+    r->reserved = 0;
+}
+
+// Open the trace file and give every thread an empty buffer
+// Returns 0 on success, -1 on failure
+static int trace_open(const char *filename) {
+    trace_buffers = calloc(NUM_THREADS, sizeof(TraceBuffer));
+    if (!trace_buffers) {
+        fprintf(stderr, "ERROR: Out of memory for trace buffers\n");
+        return -1;
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        trace_buffers[i].tid = i;
+    }
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror("open trace");
+        free(trace_buffers);
+        trace_buffers = NULL;
+        return -1;
+    }
+    TraceFileHeader header = {TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), 0};
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        perror("write trace");
+        close(fd);
+        free(trace_buffers);
+        trace_buffers = NULL;
+        return -1;
+    }
+    trace_fd = fd;
+    return 0;
+}
+
+// Flush what is left, append the node paths and close the trace file
+static void trace_close(void) {
+    if (trace_fd == -1) return;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        trace_flush(i);
+    }
+
+    FILE *fp = fdopen(trace_fd, "a");
+    if (fp) {
+        int32_t names_block[2] = {-1, file_link_count};
+        fwrite(names_block, sizeof(names_block), 1, fp);
+        for (int i = 0; i < file_link_count; i++) {
+            fwrite(file_link(i)->path, 1, strlen(file_link(i)->path) + 1, fp);
+        }
+        fclose(fp);
+    } else {
+        close(trace_fd);
+    }
+    trace_fd = -1;
+    free(trace_buffers);
+    trace_buffers = NULL;
+}
+
+// ============================================================================
+// FILENAME INTERNING
+// ============================================================================
+// Every filename maps to one stable node index. Names are spread over
+// NAME_SHARDS independently locked hash tables, so discovery threads only
+// contend when they hit the same shard at the same moment, and a lookup is
+// O(1) instead of a scan over the whole node table.
+
+// FNV-1a over the filename
+static inline uint64_t hash_name(const char *name, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Find name in a shard (caller holds its lock). Returns the slot index: either
+// the slot holding the name or the empty slot where it belongs
+static size_t shard_probe(const NameShard *sh, uint64_t hash, const char *name, size_t len) {
+    size_t mask = sh->capacity - 1;
+    size_t i = (size_t)(hash >> 6) & mask;     // Low bits already picked the shard
+    while (sh->slots[i].id >= 0) {
+        if (sh->slots[i].hash == hash) {
+            const char *other = file_link(sh->slots[i].id)->name;
+            if (strncmp(other, name, len) == 0 && other[len] == '\0') break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// Double a shard's table (caller holds its lock). Returns 0 on success, -1 on failure
+static int shard_grow(NameShard *sh) {
+    size_t capacity = sh->capacity ? sh->capacity * 2 : 256;
+    NameSlot *slots = malloc(capacity * sizeof(NameSlot));
+    if (!slots) return -1;
+    for (size_t i = 0; i < capacity; i++) slots[i].id = -1;
+
+    for (size_t i = 0; i < sh->capacity; i++) {
+        if (sh->slots[i].id < 0) continue;
+        size_t j = (size_t)(sh->slots[i].hash >> 6) & (capacity - 1);
+        while (slots[j].id >= 0) j = (j + 1) & (capacity - 1);
+        slots[j] = sh->slots[i];
+    }
+    free(sh->slots);
+    sh->slots = slots;
+    sh->capacity = capacity;
+    return 0;
+}
+
+// Initialize the shard locks (call once before discovery starts)
+static void init_name_index(void) {
+    for (int s = 0; s < NAME_SHARDS; s++) {
+        pthread_mutex_init(&name_shards[s].lock, NULL);
+    }
+}
+
+// Look a filename up without inserting. Returns its node index, or -1
+static int find_file(const char *name) {
+    size_t len = strlen(name);
+    uint64_t hash = hash_name(name, len);
+    NameShard *sh = &name_shards[hash & (NAME_SHARDS - 1)];
+
+    pthread_mutex_lock(&sh->lock);
+    int id = -1;
+    if (sh->capacity > 0) {
+        id = sh->slots[shard_probe(sh, hash, name, len)].id;
+    }
+    pthread_mutex_unlock(&sh->lock);
+    return id;
+}
+
+// Intern the file at `path`, whose last `name_len` bytes are its filename
+// The first path seen for a name wins; later duplicates return the same index.
+// Sets *inserted to 1 if a new node was created, 0 if the name was known
+// Returns the node index, or -1 on failure
+static int intern_file(const char *path, size_t name_len, int *inserted) {
+    size_t path_len = strlen(path);
+    const char *name = path + (path_len - name_len);
+    uint64_t hash = hash_name(name, name_len);
+    NameShard *sh = &name_shards[hash & (NAME_SHARDS - 1)];
+    *inserted = 0;
+
+    pthread_mutex_lock(&sh->lock);
+    // ----------------------------------
+    if (sh->count * 2 >= sh->capacity && shard_grow(sh) != 0) {
+        pthread_mutex_unlock(&sh->lock);
+        fprintf(stderr, "ERROR: Out of memory growing name index\n");
+        return -1;
+    }
+
+    size_t slot = shard_probe(sh, hash, name, name_len);
+    if (sh->slots[slot].id >= 0) {
+        int id = sh->slots[slot].id;
+        pthread_mutex_unlock(&sh->lock);
+        return id;
+    }
+
+    // New name: claim the next node index and fill it in
+    int id = __atomic_fetch_add(&file_link_count, 1, __ATOMIC_RELAXED);
+    char *interned = (node_table_reserve(id) == 0)
+                   ? arena_strndup(&sh->arena, path, path_len) : NULL;
+    if (!interned) {
+        pthread_mutex_unlock(&sh->lock);
+        fprintf(stderr, "ERROR: Out of memory interning %s\n", path);
+        return -1;
+    }
+
+    FileLink *fl = file_link(id);
+    fl->path = interned;
+    fl->name = interned + (path_len - name_len);
+    fl->inlinks = NULL;
+    fl->inlink_count = 0;
+    fl->outlinks = NULL;
+    fl->outlink_count = 0;
+
+    sh->slots[slot].hash = hash;
+    sh->slots[slot].id = id;
+    sh->count++;
+    // ----------------------------------
+    pthread_mutex_unlock(&sh->lock);
+
+    *inserted = 1;
+    return id;
+}
+
+// ============================================================================
+// SCRATCH VECTORS AND OUTPUT BUFFERS
+// ============================================================================
+
+// Append one index to a scratch vector. Returns 0 on success, -1 on failure
+static int idvec_push(IdVector *v, int32_t id) {
+    if (v->count == v->capacity) {
+        int32_t capacity = v->capacity ? v->capacity * 2 : 64;
+        int32_t *grown = realloc(v->ids, (size_t)capacity * sizeof(int32_t));
+        if (!grown) return -1;
+        v->ids = grown;
+        v->capacity = capacity;
+    }
+    v->ids[v->count++] = id;
+    return 0;
+}
+
+// Copy a scratch vector into the arena as a compact edge vector
+// Returns 0 on success, -1 on failure
+static int idvec_commit(const IdVector *v, Arena *a, int32_t **out, int32_t *out_count) {
+    *out = NULL;
+    *out_count = v->count;
+    if (v->count == 0) return 0;
+    *out = arena_alloc(a, (size_t)v->count * sizeof(int32_t));
+    if (!*out) return -1;
+    memcpy(*out, v->ids, (size_t)v->count * sizeof(int32_t));
+    return 0;
+}
+
+// Append len bytes to an output buffer. Returns 0 on success, -1 on failure
+static int outbuf_append(OutBuf *b, const char *s, size_t len) {
+    if (b->len + len > b->cap) {
+        size_t cap = b->cap ? b->cap : 64 * 1024;
+        while (cap < b->len + len) cap *= 2;
+        char *grown = realloc(b->data, cap);
+        if (!grown) return -1;
+        b->data = grown;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, len);
+    b->len += len;
+    return 0;
+}
+
+// Append a comma-separated list of node names
+static int outbuf_append_names(OutBuf *b, const int32_t *ids, int32_t count) {
+    for (int32_t j = 0; j < count; j++) {
+        const char *name = file_link(ids[j])->name;
+        if (j > 0 && outbuf_append(b, ",", 1) != 0) return -1;
+        if (outbuf_append(b, name, strlen(name)) != 0) return -1;
+    }
+    return 0;
+}
+
+// Bytes outbuf_append_names() appends for the same list
+static size_t names_length(const int32_t *ids, int32_t count) {
+    size_t len = count > 0 ? (size_t)count - 1 : 0;   // Commas
+    for (int32_t j = 0; j < count; j++) {
+        len += strlen(file_link(ids[j])->name);
+    }
+    return len;
+}
+
+// ============================================================================
+// HELPER FUNCTIONS
+// ============================================================================
+
+
+// Safely append a directory entry name to a path buffer that already holds
+// the directory ("files/sub/") in its first dir_len bytes. With add_slash the
+// result is itself a directory prefix ("files/sub/name/").
+// Returns the new length, or -1 if it would not fit (prevents buffer overflow)
+static int path_append(char *dest, size_t dest_size, size_t dir_len,
+                       const char *name, size_t name_len, int add_slash) {
+    // Need space for dir + name + optional '/' + '\0'
+    if (dir_len + name_len + (add_slash ? 1 : 0) + 1 > dest_size) {
+        fprintf(stderr, "ERROR: Path too long: %.*s%s\n", (int)dir_len, dest, name);
+        return -1;  // Failure
+    }
+
+    memcpy(dest + dir_len, name, name_len);
+    size_t len = dir_len + name_len;
+    if (add_slash) dest[len++] = '/';
+    dest[len] = '\0';
+    return (int)len;
+}
+
+// ============================================================================
+// CONTENT HASH: XXH64
+// ============================================================================
+// Streaming XXH64, used to tell touched-but-identical files from changed ones.
+#define XXH_P1 11400714785074694791ULL
+#define XXH_P2 14029467366897019727ULL
+#define XXH_P3 1609587929392839161ULL
+#define XXH_P4 9650029242287828579ULL
+#define XXH_P5 2870177450012600261ULL
+
+static inline uint64_t xxh_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));      // Little-endian hosts only (x86, arm64)
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_P2;
+    acc = xxh_rotl(acc, 31);
+    return acc * XXH_P1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t v) {
+    acc ^= xxh_round(0, v);
+    return acc * XXH_P1 + XXH_P4;
+}
+
+static void xxh64_init(Xxh64State *st, uint64_t seed) {
+    memset(st, 0, sizeof(*st));
+    st->v[0] = seed + XXH_P1 + XXH_P2;
+    st->v[1] = seed + XXH_P2;
+    st->v[2] = seed;
+    st->v[3] = seed - XXH_P1;
+    st->seed = seed;
+}
+
+static void xxh64_update(Xxh64State *st, const void *data, size_t len) {
+    const unsigned char *p = data;
+    const unsigned char *end = p + len;
+    st->total_len += len;
+
+    // Top up a partial stripe left by the previous call
+    if (st->buffered + len < 32) {
+        memcpy(st->buf + st->buffered, p, len);
+        st->buffered += (uint32_t)len;
+        return;
+    }
+    if (st->buffered) {
+        size_t fill = 32 - st->buffered;
+        memcpy(st->buf + st->buffered, p, fill);
+        for (int i = 0; i < 4; i++) {
+            st->v[i] = xxh_round(st->v[i], xxh_read64(st->buf + 8 * i));
+        }
+        p += fill;
+        st->buffered = 0;
+    }
+
+    // Whole 32-byte stripes straight from the input
+    uint64_t v0 = st->v[0], v1 = st->v[1], v2 = st->v[2], v3 = st->v[3];
+    for (; p + 32 <= end; p += 32) {
+        v0 = xxh_round(v0, xxh_read64(p));
+        v1 = xxh_round(v1, xxh_read64(p + 8));
+        v2 = xxh_round(v2, xxh_read64(p + 16));
+        v3 = xxh_round(v3, xxh_read64(p + 24));
+    }
+    st->v[0] = v0; st->v[1] = v1; st->v[2] = v2; st->v[3] = v3;
+
+    if (p < end) {
+        memcpy(st->buf, p, (size_t)(end - p));
+        st->buffered = (uint32_t)(end - p);
+    }
+}
+
+static uint64_t xxh64_digest(const Xxh64State *st) {
+    uint64_t h;
+    if (st->total_len >= 32) {
+        h = xxh_rotl(st->v[0], 1) + xxh_rotl(st->v[1], 7) +
+            xxh_rotl(st->v[2], 12) + xxh_rotl(st->v[3], 18);
+        for (int i = 0; i < 4; i++) h = xxh_merge(h, st->v[i]);
+    } else {
+        h = st->seed + XXH_P5;
+    }
+    h += st->total_len;
+
+    const unsigned char *p = st->buf;
+    const unsigned char *end = p + st->buffered;
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh_round(0, xxh_read64(p));
+        h = xxh_rotl(h, 27) * XXH_P1 + XXH_P4;
+    }
+    if (p + 4 <= end) {
+        uint32_t k;
+        memcpy(&k, p, sizeof(k));
+        h ^= (uint64_t)k * XXH_P1;
+        h = xxh_rotl(h, 23) * XXH_P2 + XXH_P3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (uint64_t)(*p) * XXH_P5;
+        h = xxh_rotl(h, 11) * XXH_P1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_P2;
+    h ^= h >> 29;
+    h *= XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// ============================================================================
+// LINK MATCHER: AHO-CORASICK OVER ALL FILENAMES
+// ============================================================================
+// Replaces the per-pair `grep -q -F` subprocesses. The automaton is built once
+// over every discovered filename, then each file is read exactly once and every
+// filename occurring in it (as a substring, same as grep -F) is reported.
+
+// qsort comparator: order node indices by filename
+static int compare_name_idx(const void *a, const void *b) {
+    return strcmp(file_link(*(const int *)a)->name, file_link(*(const int *)b)->name);
+}
+
+// qsort comparator: ascending int32 node indices
+static int compare_id(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Follow the goto edge of state s labelled c (binary search), -1 if none
+static inline int matcher_goto(const LinkMatcher *m, int s, unsigned char c) {
+    int lo = m->edge_start[s];
+    int hi = m->edge_start[s + 1] - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) >> 1;
+        if (m->edge_byte[mid] == c) return m->edge_target[mid];
+        if (m->edge_byte[mid] < c) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+// One automaton transition: goto if possible, otherwise follow failure links
+static inline int matcher_step(const LinkMatcher *m, int s, unsigned char c) {
+    while (s != 0) {
+        int t = matcher_goto(m, s, c);
+        if (t >= 0) return t;
+        s = m->fail[s];
+    }
+    return m->root_next[c];
+}
+
+// Build the automaton over the n node indices in `order` (takes ownership)
+// Returns 0 on success, -1 on allocation failure
+static int build_matcher_over(LinkMatcher *m, int *order, int n) {
+    // = Sort names so shared prefixes are inserted back to back =
+    size_t max_states = 1;
+    for (int i = 0; i < n; i++) {
+        max_states += strlen(file_link(order[i])->name);
+    }
+    qsort(order, n, sizeof(int), compare_name_idx);
+
+    int *parent = malloc(max_states * sizeof(int));
+    unsigned char *label = malloc(max_states);
+    m->output = malloc(max_states * sizeof(int));
+    if (!parent || !label || !m->output) {
+        free(order); free(parent); free(label);
+        return -1;
+    }
+
+    // = Build the trie =
+    // Sorted insertion: the new name shares its first `lcp` states with the
+    // previous one, so path[] (states along the previous name) is reused.
+    int path[MAX_FILENAME + 1];
+    const char *prev = "";
+    int state_count = 1;
+    path[0] = 0;
+    m->output[0] = -1;
+    for (int k = 0; k < n; k++) {
+        const char *name = file_link(order[k])->name;
+        int lcp = 0;
+        while (name[lcp] && name[lcp] == prev[lcp]) lcp++;
+
+        int d = lcp;
+        for (; name[d]; d++) {
+            int s = state_count++;
+            parent[s] = path[d];
+            label[s] = (unsigned char)name[d];
+            m->output[s] = -1;
+            path[d + 1] = s;
+        }
+        m->output[path[d]] = order[k];
+        prev = name;
+    }
+    free(order);
+    m->state_count = state_count;
+
+    // = Lay out goto edges contiguously per state (counting sort by parent) =
+    // States were created in sorted-name order, so each state's children are
+    // already in ascending byte order.
+    m->edge_start = calloc(state_count + 1, sizeof(int));
+    m->edge_byte = malloc(state_count);
+    m->edge_target = malloc(state_count * sizeof(int));
+    m->root_next = calloc(256, sizeof(int));
+    m->fail = calloc(state_count, sizeof(int));
+    m->dict = calloc(state_count, sizeof(int));
+    int *fill = malloc((state_count + 1) * sizeof(int));
+    if (!m->edge_start || !m->edge_byte || !m->edge_target || !m->root_next ||
+        !m->fail || !m->dict || !fill) {
+        free(parent); free(label); free(fill);
+        return -1;
+    }
+
+    for (int s = 1; s < state_count; s++) m->edge_start[parent[s] + 1]++;
+    for (int s = 0; s < state_count; s++) m->edge_start[s + 1] += m->edge_start[s];
+    memcpy(fill, m->edge_start, (state_count + 1) * sizeof(int));
+    for (int s = 1; s < state_count; s++) {
+        int e = fill[parent[s]]++;
+        m->edge_byte[e] = label[s];
+        m->edge_target[e] = s;
+        if (parent[s] == 0) m->root_next[label[s]] = s;
+    }
+    free(parent);
+    free(label);
+
+    // = Prefilter tables =
+    m->pair_bits = calloc(65536 / 8, 1);
+    if (!m->pair_bits) {
+        free(fill);
+        return -1;
+    }
+    m->first_byte_count = 0;
+    for (int e = m->edge_start[0]; e < m->edge_start[1]; e++) {
+        unsigned char a = m->edge_byte[e];
+        int s1 = m->edge_target[e];
+        if (m->first_byte_count < MATCHER_SIMD_MAX_BYTES) {
+            m->first_bytes[m->first_byte_count] = a;
+        }
+        m->first_byte_count++;
+
+        for (int b = 0; b < 256; b++) {
+            // A one-byte name matches whatever follows it
+            if (m->output[s1] >= 0 || matcher_goto(m, s1, (unsigned char)b) >= 0) {
+                unsigned idx = ((unsigned)a << 8) | (unsigned)b;
+                m->pair_bits[idx >> 3] |= (uint8_t)(1u << (idx & 7));
+            }
+        }
+    }
+
+    // = Failure and dictionary links (BFS from the root) =
+    int *bfs = fill;    // Reuse as the BFS queue
+    int head = 0, tail = 0;
+    for (int e = m->edge_start[0]; e < m->edge_start[1]; e++) {
+        bfs[tail++] = m->edge_target[e];    // Depth-1 states fail to the root
+    }
+    while (head < tail) {
+        int u = bfs[head++];
+        for (int e = m->edge_start[u]; e < m->edge_start[u + 1]; e++) {
+            int v = m->edge_target[e];
+            int f = matcher_step(m, m->fail[u], m->edge_byte[e]);
+            m->fail[v] = f;
+            m->dict[v] = (m->output[f] >= 0) ? f : m->dict[f];
+            bfs[tail++] = v;
+        }
+    }
+    free(fill);
+    return 0;
+}
+
+// Build the automaton over node indices [0, file_link_count)
+// Returns 0 on success, -1 on allocation failure
+static int build_link_matcher(LinkMatcher *m) {
+    int n = file_link_count;
+    int *order = malloc((n > 0 ? n : 1) * sizeof(int));
+    if (!order) return -1;
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    return build_matcher_over(m, order, n);
+}
+
+// Release everything owned by the automaton
+static void free_link_matcher(LinkMatcher *m) {
+    free(m->root_next);
+    free(m->edge_start);
+    free(m->edge_byte);
+    free(m->edge_target);
+    free(m->fail);
+    free(m->output);
+    free(m->dict);
+    free(m->pair_bits);
+    memset(m, 0, sizeof(*m));
+}
+
+// = Prefilter: skip bytes that cannot start any filename =
+// Only valid while the automaton sits at the root: a byte that is not the
+// first byte of a name, or whose following byte does not continue one, leaves
+// the root untouched, so the scan can jump straight to the next candidate.
+
+// Is (a, b) the first two bytes of some name (or is a a whole name)?
+static inline int matcher_pair_ok(const LinkMatcher *m, unsigned char a, unsigned char b) {
+    unsigned idx = ((unsigned)a << 8) | b;
+    return (m->pair_bits[idx >> 3] >> (idx & 7)) & 1;
+}
+
+// Can a name start at data[p]? The last byte is accepted on its first byte
+// alone (conservative: it may be continued in the next read() block).
+static inline int matcher_candidate(const LinkMatcher *m, const unsigned char *data,
+                                    size_t p, size_t len) {
+    if (p + 1 < len) return matcher_pair_ok(m, data[p], data[p + 1]);
+    return m->root_next[data[p]] != 0;
+}
+
+// Return the first candidate position >= i, or len if there is none
+static size_t matcher_skip(const LinkMatcher *m, const unsigned char *data, size_t i, size_t len) {
+#if defined(__AVX2__)
+    if (m->first_byte_count <= MATCHER_SIMD_MAX_BYTES) {
+        __m256i needle[MATCHER_SIMD_MAX_BYTES];
+        for (int k = 0; k < m->first_byte_count; k++) {
+            needle[k] = _mm256_set1_epi8((char)m->first_bytes[k]);
+        }
+        for (; i + 32 <= len; i += 32) {
+            __m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+            __m256i hit = _mm256_cmpeq_epi8(block, needle[0]);
+            for (int k = 1; k < m->first_byte_count; k++) {
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(block, needle[k]));
+            }
+            unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+            while (mask) {
+                size_t p = i + (size_t)__builtin_ctz(mask);
+                if (matcher_candidate(m, data, p, len)) return p;
+                mask &= mask - 1;
+            }
+        }
+    }
+#elif defined(__SSE2__)
+    if (m->first_byte_count <= MATCHER_SIMD_MAX_BYTES) {
+        __m128i needle[MATCHER_SIMD_MAX_BYTES];
+        for (int k = 0; k < m->first_byte_count; k++) {
+            needle[k] = _mm_set1_epi8((char)m->first_bytes[k]);
+        }
+        for (; i + 16 <= len; i += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+            __m128i hit = _mm_cmpeq_epi8(block, needle[0]);
+            for (int k = 1; k < m->first_byte_count; k++) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, needle[k]));
+            }
+            unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+            while (mask) {
+                size_t p = i + (size_t)__builtin_ctz(mask);
+                if (matcher_candidate(m, data, p, len)) return p;
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+    // Scalar tail (and the whole buffer when names start with too many bytes)
+    for (; i < len; i++) {
+        if (m->root_next[data[i]] && matcher_candidate(m, data, i, len)) return i;
+    }
+    return len;
+}
+
+// Feed len bytes through the automaton starting in `state`, pushing every
+// newly seen name onto `found`. seen[idx] == stamp marks names already found.
+// Returns the state after the last byte, or -1 on allocation failure
+static int scan_bytes(const LinkMatcher *m, int state, const unsigned char *data, size_t len,
+                      IdVector *found, int *seen, int stamp) {
+    size_t i = 0;
+    while (i < len) {
+        if (state == 0) {
+            i = matcher_skip(m, data, i, len);
+            if (i >= len) break;
+        }
+        state = matcher_step(m, state, data[i++]);
+
+        // Report this state and every shorter name ending at this byte
+        int o = (m->output[state] >= 0) ? state : m->dict[state];
+        for (; o != 0; o = m->dict[o]) {
+            int idx = m->output[o];
+            if (seen[idx] == stamp) continue;   // Already reported
+            seen[idx] = stamp;
+            if (idvec_push(found, idx) != 0) return -1;
+        }
+    }
+    return state;
+}
+
+// Read a file once, feeding its bytes through `m` (if not NULL, newly found
+// names are appended to `scratch`; seen[] stamped with file_idx de-duplicates)
+// and through the content hash `hs` (if not NULL).
+// The file is memory-mapped and scanned in place; read() is only the fallback
+// for files that cannot be mapped (and the only path under --mem-mb).
+// Returns 0 on success, -1 if the file could not be read (or out of memory)
+static int scan_file_contents(const LinkMatcher *m, int file_idx, int *seen,
+                              IdVector *scratch, Xxh64State *hs) {
+    const FileLink *fl = file_link(file_idx);
+    int fd = open(fl->path, O_RDONLY);
+    if (fd == -1) {
+        perror("open");
+        return -1;
+    }
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) == -1) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    int state = 0;
+    size_t size = (size_t)statbuf.st_size;
+    void *map = (size > 0 && !MEMORY_BUDGET) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                                             : MAP_FAILED;
+
+    if (map != MAP_FAILED) {
+        // = Zero-copy path: scan the page cache directly =
+        madvise(map, size, MADV_SEQUENTIAL);
+        if (m) state = scan_bytes(m, 0, map, size, scratch, seen, file_idx);
+        if (hs) xxh64_update(hs, map, size);
+        munmap(map, size);
+    } else if (size > 0 || !S_ISREG(statbuf.st_mode)) {
+        // = Fallback: stream through a stack buffer =
+        unsigned char buf[SCAN_BUFFER_SIZE];
+        ssize_t got = 0;
+        while (state >= 0 && (got = read(fd, buf, sizeof(buf))) > 0) {
+            if (m) state = scan_bytes(m, state, buf, (size_t)got, scratch, seen, file_idx);
+            if (hs) xxh64_update(hs, buf, (size_t)got);
+        }
+        if (got == -1) {
+            perror("read");
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+
+    if (state < 0) {
+        fprintf(stderr, "ERROR: Out of memory scanning %s\n", fl->path);
+        return -1;
+    }
+    return 0;
+}
+
+// Sort the names collected in `scratch` and store them as file_idx's outlinks
+// (with no arena they stay in scratch and only the count is stored; see
+// record_outlinks)
+// Returns 0 on success, -1 on allocation failure (the file keeps no outlinks)
+static int commit_outlinks(int file_idx, IdVector *scratch, Arena *arena) {
+    FileLink *fl = file_link(file_idx);
+    if (scratch->count > 1) {
+        qsort(scratch->ids, scratch->count, sizeof(int32_t), compare_id);
+    }
+    if (!arena) {
+        fl->outlinks = NULL;
+        fl->outlink_count = scratch->count;
+        return 0;
+    }
+    if (idvec_commit(scratch, arena, &fl->outlinks, &fl->outlink_count) != 0) {
+        fprintf(stderr, "ERROR: Out of memory scanning %s\n", fl->path);
+        fl->outlinks = NULL;
+        fl->outlink_count = 0;
+        return -1;
+    }
+    return 0;
+}
+
+// Scan a file once and store the ascending, de-duplicated indices of every
+// other file whose name occurs in it as the file's outlinks (in `arena`).
+// `seen` is a per-thread array of file_link_count ints, stamped with file_idx
+// so it never needs clearing between files; `scratch` is per-thread too.
+// Returns 0 on success, -1 if the file could not be read
+static int scan_file_mentions(const LinkMatcher *m, int file_idx, int *seen,
+                              IdVector *scratch, Arena *arena) {
+    FileLink *fl = file_link(file_idx);
+    fl->outlinks = NULL;
+    fl->outlink_count = 0;
+    scratch->count = 0;
+    seen[file_idx] = file_idx;      // A file never links to itself
+
+    if (scan_file_contents(m, file_idx, seen, scratch, NULL) != 0) {
+        return -1;
+    }
+    return commit_outlinks(file_idx, scratch, arena);
+}
+
+// scan_file_mentions() for contents already in memory (read by the read ring)
+// Returns 0 on success, -1 on allocation failure
+static int scan_buffer_mentions(const LinkMatcher *m, int file_idx, const unsigned char *data,
+                                size_t len, int *seen, IdVector *scratch, Arena *arena) {
+    FileLink *fl = file_link(file_idx);
+    fl->outlinks = NULL;
+    fl->outlink_count = 0;
+    scratch->count = 0;
+    seen[file_idx] = file_idx;
+
+    if (scan_bytes(m, 0, data, len, scratch, seen, file_idx) < 0) {
+        fprintf(stderr, "ERROR: Out of memory scanning %s\n", fl->path);
+        return -1;
+    }
+    return commit_outlinks(file_idx, scratch, arena);
+}
+
+// ============================================================================
+// INCREMENTAL RECRAWL
+// ============================================================================
+// With --incremental, the previous crawl's manifest (one entry per file:
+// path, size, mtime, XXH64 of the contents, outlink names) is loaded first.
+// A file's outlinks only depend on its contents and on the set of names, so
+//   - same size and mtime            -> reuse the recorded outlinks
+//   - same size, new mtime, same hash -> reuse too (touched, not changed)
+//   - anything else or a new path    -> full scan
+// Reused outlinks drop names that disappeared, and pick up names that are new
+// since the last crawl by scanning with a small delta automaton over only the
+// new names. Inlinks are transposed from the outlinks as usual, and the link
+// file and manifest are rewritten.
+//
+// Manifest format (text):
+//   CRAWL-MANIFEST <version> <entry count>
+//   <size> <mtime ns> <hash hex> <outlink count> <path>     (per entry)
+//   <outlink name>                                          (x outlink count)
+
+// = Manifest I/O =
+
+// Find the manifest entry recorded for `path`, or NULL
+static const ManifestEntry *manifest_lookup(const Manifest *mf, const char *path) {
+    if (mf->count == 0) return NULL;
+    size_t len = strlen(path);
+    size_t i = (size_t)hash_name(path, len) & mf->slot_mask;
+    for (; mf->slots[i] != -1; i = (i + 1) & mf->slot_mask) {
+        const ManifestEntry *e = &mf->entries[mf->slots[i]];
+        if (strcmp(e->path, path) == 0) return e;
+    }
+    return NULL;
+}
+
+// Release a loaded manifest
+static void free_manifest(Manifest *mf) {
+    free(mf->data);
+    free(mf->entries);
+    free(mf->names);
+    free(mf->slots);
+    memset(mf, 0, sizeof(*mf));
+}
+
+// Load the manifest written by the previous incremental crawl
+// A missing manifest is not an error (everything is new). Strings point into
+// mf->data, which is kept for the lifetime of the manifest.
+// Returns 0 on success, -1 if the file exists but could not be parsed
+static int load_manifest(Manifest *mf, const char *filename) {
+    memset(mf, 0, sizeof(*mf));
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return 0;      // First incremental crawl
+
+    // = Slurp the whole file =
+    size_t cap = 1 << 16, len = 0;
+    char *data = malloc(cap + 1);
+    size_t got;
+    while (data && (got = fread(data + len, 1, cap - len, fp)) > 0) {
+        len += got;
+        if (len == cap) {
+            cap *= 2;
+            char *grown = realloc(data, cap + 1);
+            if (!grown) { free(data); data = NULL; }
+            else data = grown;
+        }
+    }
+    fclose(fp);
+    if (!data) {
+        fprintf(stderr, "ERROR: Out of memory loading manifest %s\n", filename);
+        return -1;
+    }
+    data[len] = '\0';
+    mf->data = data;
+
+    // = Parse =
+    char *line = data;
+    char *nl = strchr(line, '\n');
+    int version = 0;
+    long long count = 0;
+    if (!nl || sscanf(line, "CRAWL-MANIFEST %d %lld", &version, &count) != 2 ||
+        version != MANIFEST_VERSION || count < 0 || count > INT32_MAX) {
+        goto corrupt;
+    }
+    line = nl + 1;
+
+    mf->entries = malloc((count > 0 ? count : 1) * sizeof(ManifestEntry));
+    size_t name_cap = 1024;
+    mf->names = malloc(name_cap * sizeof(const char *));
+    if (!mf->entries || !mf->names) goto oom;
+
+    size_t name_count = 0;
+    for (long long k = 0; k < count; k++) {
+        ManifestEntry *e = &mf->entries[k];
+        long long size, mtime;
+        unsigned long long hash;
+        int out_count, path_off = 0;
+        if (!(nl = strchr(line, '\n'))) goto corrupt;
+        *nl = '\0';
+        if (sscanf(line, "%lld %lld %llx %d %n", &size, &mtime, &hash,
+                   &out_count, &path_off) != 4 || path_off == 0 || out_count < 0) {
+            goto corrupt;
+        }
+        e->path = line + path_off;
+        e->size = size;
+        e->mtime_ns = mtime;
+        e->hash = hash;
+        e->out_count = out_count;
+        e->out_first = name_count;
+        line = nl + 1;
+
+        for (int j = 0; j < out_count; j++) {
+            if (!(nl = strchr(line, '\n'))) goto corrupt;
+            *nl = '\0';
+            if (name_count == name_cap) {
+                name_cap *= 2;
+                const char **grown = realloc(mf->names, name_cap * sizeof(const char *));
+                if (!grown) goto oom;
+                mf->names = grown;
+            }
+            mf->names[name_count++] = line;
+            line = nl + 1;
+        }
+    }
+    mf->count = (int)count;
+
+    // = Path index (open addressing, <= 50% full) =
+    size_t slot_count = 16;
+    while (slot_count < 2 * (size_t)mf->count) slot_count *= 2;
+    mf->slots = malloc(slot_count * sizeof(int32_t));
+    if (!mf->slots) goto oom;
+    memset(mf->slots, 0xff, slot_count * sizeof(int32_t));
+    mf->slot_mask = slot_count - 1;
+    for (int k = 0; k < mf->count; k++) {
+        const char *path = mf->entries[k].path;
+        size_t i = (size_t)hash_name(path, strlen(path)) & mf->slot_mask;
+        while (mf->slots[i] != -1) i = (i + 1) & mf->slot_mask;
+        mf->slots[i] = k;
+    }
+    return 0;
+
+corrupt:
+    fprintf(stderr, "ERROR: Manifest %s is corrupt\n", filename);
+    free_manifest(mf);
+    return -1;
+oom:
+    fprintf(stderr, "ERROR: Out of memory loading manifest %s\n", filename);
+    free_manifest(mf);
+    return -1;
+}
+
+// Write the manifest for the crawl that just finished (via a temp file + rename)
+// Returns 0 on success, -1 on failure (the old manifest is left in place)
+static int write_manifest(const char *filename) {
+    char tmp_name[PATH_MAX];
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", filename);
+    FILE *fp = fopen(tmp_name, "w");
+    if (!fp) {
+        perror("fopen manifest");
+        return -1;
+    }
+
+    fprintf(fp, "CRAWL-MANIFEST %d %d\n", MANIFEST_VERSION, file_link_count);
+    for (int i = 0; i < file_link_count; i++) {
+        const FileLink *fl = file_link(i);
+        fprintf(fp, "%lld %lld %016llx %d %s\n", (long long)fl->size,
+                (long long)fl->mtime_ns, (unsigned long long)fl->hash,
+                fl->outlink_count, fl->path);
+        for (int j = 0; j < fl->outlink_count; j++) {
+            fputs(file_link(fl->outlinks[j])->name, fp);
+            fputc('\n', fp);
+        }
+    }
+
+    if (fclose(fp) != 0 || rename(tmp_name, filename) != 0) {
+        perror("write manifest");
+        unlink(tmp_name);
+        return -1;
+    }
+    return 0;
+}
+
+// = Recrawl =
+
+// After discovery: work out which names are new since the manifest was
+// written and build the delta automaton over just those names
+// Returns 0 on success, -1 on allocation failure
+static int prepare_incremental(void) {
+    char *known = calloc(file_link_count > 0 ? file_link_count : 1, 1);
+    if (!known) return -1;
+    for (int k = 0; k < manifest.count; k++) {
+        const char *slash = strrchr(manifest.entries[k].path, '/');
+        int idx = find_file(slash ? slash + 1 : manifest.entries[k].path);
+        if (idx >= 0) known[idx] = 1;
+    }
+
+    int *order = malloc((file_link_count > 0 ? file_link_count : 1) * sizeof(int));
+    if (!order) {
+        free(known);
+        return -1;
+    }
+    new_name_count = 0;
+    for (int i = 0; i < file_link_count; i++) {
+        if (!known[i]) order[new_name_count++] = i;
+    }
+    free(known);
+
+    if (new_name_count == 0) {
+        free(order);
+        return 0;   // Recorded outlinks are complete as they are
+    }
+    return build_matcher_over(&delta_matcher, order, new_name_count);
+}
+
+// Restore file_idx's outlinks from its manifest entry: names that no longer
+// exist are dropped, names added since are found by the delta scan (which
+// also feeds `hs` when the caller still has to check the content hash).
+// Returns 0 on success, -1 if the file could not be read
+static int reuse_outlinks(int file_idx, const ManifestEntry *e, int *seen,
+                          IdVector *scratch, Xxh64State *hs) {
+    scratch->count = 0;
+    seen[file_idx] = file_idx;
+    for (int j = 0; j < e->out_count; j++) {
+        int idx = find_file(manifest.names[e->out_first + j]);
+        if (idx < 0 || idx == file_idx) continue;
+        if (idvec_push(scratch, idx) != 0) {
+            fprintf(stderr, "ERROR: Out of memory restoring outlinks\n");
+            return -1;
+        }
+    }
+    if (new_name_count == 0 && !hs) return 0;     // Nothing to read
+    return scan_file_contents(new_name_count ? &delta_matcher : NULL,
+                              file_idx, seen, scratch, hs);
+}
+
+// Incremental counterpart of scan_file_mentions(): compares the size and
+// mtime recorded at discovery with the manifest, records the content hash,
+// and only runs the full automaton over new or changed files
+// Returns 0 on success, -1 if the file could not be read
+static int recrawl_file(int file_idx, int *seen, IdVector *scratch, Arena *arena) {
+    FileLink *fl = file_link(file_idx);
+    fl->outlinks = NULL;
+    fl->outlink_count = 0;
+
+    const ManifestEntry *e = manifest_lookup(&manifest, fl->path);
+    Xxh64State hs;
+    xxh64_init(&hs, 0);
+
+    if (e && e->size == fl->size) {
+        if (e->mtime_ns == fl->mtime_ns) {
+            // = Untouched: trust the recorded outlinks and hash =
+            fl->hash = e->hash;
+            if (reuse_outlinks(file_idx, e, seen, scratch, NULL) != 0) return -1;
+            __atomic_fetch_add(&files_reused, 1, __ATOMIC_RELAXED);
+            return commit_outlinks(file_idx, scratch, arena);
+        }
+
+        // = Touched: unchanged if the contents still hash the same =
+        if (reuse_outlinks(file_idx, e, seen, scratch, &hs) != 0) return -1;
+        fl->hash = xxh64_digest(&hs);
+        if (fl->hash == e->hash) {
+            __atomic_fetch_add(&files_touched, 1, __ATOMIC_RELAXED);
+            return commit_outlinks(file_idx, scratch, arena);
+        }
+        xxh64_init(&hs, 0);
+    }
+
+    // = New or changed: full scan, hashing along the way =
+    for (int j = 0; j < scratch->count; j++) {
+        seen[scratch->ids[j]] = -1;     // Forget names the delta scan stamped
+    }
+    scratch->count = 0;
+    seen[file_idx] = file_idx;
+    if (scan_file_contents(&link_matcher, file_idx, seen, scratch, &hs) != 0) {
+        return -1;
+    }
+    fl->hash = xxh64_digest(&hs);
+    __atomic_fetch_add(&files_rescanned, 1, __ATOMIC_RELAXED);
+    return commit_outlinks(file_idx, scratch, arena);
+}
+
+// ============================================================================
+// CONTENT DEDUPLICATION
+// ============================================================================
+// Trees often hold byte-identical copies (templates, mirrored directories).
+// A file's matches only depend on its bytes, so each distinct content is
+// scanned once and its match set copied to every copy. Only the self-link
+// differs: a file never links to itself, so the owner records whether the
+// content names the owner, and each copy takes the owner's outlinks plus
+// the owner (if named) minus itself.
+// Hashing is not free, so only files whose size occurs more than once (known
+// from discovery) are hashed at all. Copies are found by size plus 64-bit
+// XXH64 (the table is claimed lock-free with a CAS on the key) and confirmed
+// by comparing their bytes with the owner's file, so a hash collision (or an
+// owner changed since its scan) costs one extra read, never wrong links. A
+// copy that finds the owner still scanning simply scans as well.
+// --incremental already skips unchanged files and does not dedup.
+
+// Mark files that share their size with another file and size the table
+// Returns 0 on success, -1 on allocation failure
+static int prepare_dedup(void) {
+    size_t cap = 1;
+    while (cap < 2 * (size_t)file_link_count) cap <<= 1;
+    int64_t *sizes = malloc(cap * sizeof(int64_t));
+    int32_t *counts = calloc(cap, sizeof(int32_t));
+    int32_t *slot_of = malloc((file_link_count > 0 ? file_link_count : 1) * sizeof(int32_t));
+    dedup_twin = calloc(file_link_count > 0 ? file_link_count : 1, 1);
+    if (!sizes || !counts || !slot_of || !dedup_twin) {
+        free(sizes);
+        free(counts);
+        free(slot_of);
+        return -1;
+    }
+
+    // = Count files per size (empty files have no links to share) =
+    for (int i = 0; i < file_link_count; i++) {
+        int64_t size = file_link(i)->size;
+        slot_of[i] = -1;
+        if (size <= 0) continue;
+        size_t h = (size_t)hash_name((const char *)&size, sizeof(size)) & (cap - 1);
+        while (counts[h] != 0 && sizes[h] != size) h = (h + 1) & (cap - 1);
+        sizes[h] = size;
+        counts[h]++;
+        slot_of[i] = (int32_t)h;
+    }
+    int candidates = 0;
+    for (int i = 0; i < file_link_count; i++) {
+        if (slot_of[i] >= 0 && counts[slot_of[i]] > 1) {
+            dedup_twin[i] = 1;
+            candidates++;
+        }
+    }
+    free(sizes);
+    free(counts);
+    free(slot_of);
+
+    // = Table: at most one entry per candidate, kept <= 50% full =
+    size_t slots = 1;
+    while (slots < 2 * (size_t)candidates) slots <<= 1;
+    dedup_slots = calloc(slots, sizeof(DedupSlot));
+    if (!dedup_slots) return -1;
+    dedup_mask = slots - 1;
+    return 0;
+}
+
+// Release the dedup table
+static void free_dedup(void) {
+    free(dedup_slots);
+    free(dedup_twin);
+    dedup_slots = NULL;
+    dedup_twin = NULL;
+}
+
+// Does the file at path hold exactly these len bytes? (0 if unreadable)
+static int same_contents(const char *path, const unsigned char *data, size_t len) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return 0;
+    struct stat statbuf;
+    int same = 0;
+    if (fstat(fd, &statbuf) == 0 && (size_t)statbuf.st_size == len) {
+        void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            same = memcmp(map, data, len) == 0;
+            munmap(map, len);
+        }
+    }
+    close(fd);
+    return same;
+}
+
+// scan_buffer_mentions(), but byte-identical files are only scanned once
+// Returns 0 on success, -1 on allocation failure
+static int scan_buffer_dedup(const LinkMatcher *m, int file_idx, const unsigned char *data,
+                             size_t len, int *seen, IdVector *scratch, Arena *arena) {
+    if (!dedup_twin || !dedup_twin[file_idx] || len == 0) {
+        return scan_buffer_mentions(m, file_idx, data, len, seen, scratch, arena);
+    }
+
+    Xxh64State hs;
+    xxh64_init(&hs, len);
+    xxh64_update(&hs, data, len);
+    uint64_t key = xxh64_digest(&hs);
+    if (key == 0) key = 1;     // 0 marks an empty slot
+
+    // = Find or claim this content's slot =
+    size_t i = (size_t)key & dedup_mask;
+    DedupSlot *slot;
+    int claimed = 0;
+    for (;; i = (i + 1) & dedup_mask) {
+        slot = &dedup_slots[i];
+        uint64_t seen_key = __atomic_load_n(&slot->key, __ATOMIC_ACQUIRE);
+        if (seen_key == 0) {
+            if (__atomic_compare_exchange_n(&slot->key, &seen_key, key, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                claimed = 1;
+                break;
+            }
+        }
+        if (seen_key == key) break;
+    }
+
+    FileLink *fl = file_link(file_idx);
+    int state = claimed ? DEDUP_PENDING : __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+    const FileLink *ofl = state != DEDUP_PENDING ? file_link(slot->owner) : NULL;
+    if (ofl && same_contents(ofl->path, data, len)) {
+        // = Copy: the owner's matches, minus this file =
+        int owner = slot->owner;
+        fl->outlinks = NULL;
+        fl->outlink_count = 0;
+        scratch->count = 0;
+        if (state == DEDUP_DONE_SELF && idvec_push(scratch, owner) != 0) return -1;
+        for (int j = 0; j < ofl->outlink_count; j++) {
+            if (ofl->outlinks[j] != file_idx && idvec_push(scratch, ofl->outlinks[j]) != 0) {
+                return -1;
+            }
+        }
+        __atomic_fetch_add(&files_deduped, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&dedup_bytes_saved, (int64_t)len, __ATOMIC_RELAXED);
+        return commit_outlinks(file_idx, scratch, arena);
+    }
+    if (!claimed) {
+        return scan_buffer_mentions(m, file_idx, data, len, seen, scratch, arena);
+    }
+
+    // = Owner: scan with the self-link kept, then take it out =
+    fl->outlinks = NULL;
+    fl->outlink_count = 0;
+    scratch->count = 0;
+    if (scan_bytes(m, 0, data, len, scratch, seen, file_idx) < 0) {
+        fprintf(stderr, "ERROR: Out of memory scanning %s\n", fl->path);
+        return -1;      // Slot stays pending: copies scan for themselves
+    }
+    int names_self = 0;
+    for (int j = 0; j < scratch->count; j++) {
+        if (scratch->ids[j] == file_idx) {
+            scratch->ids[j] = scratch->ids[--scratch->count];
+            names_self = 1;
+            break;
+        }
+    }
+    if (commit_outlinks(file_idx, scratch, arena) != 0) return -1;
+    slot->owner = file_idx;
+    __atomic_store_n(&slot->state, names_self ? DEDUP_DONE_SELF : DEDUP_DONE, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// scan_file_mentions() with deduplication: maps the file so it can be
+// hashed before deciding whether to scan it
+// Returns 0 on success, -1 if the file could not be read
+static int scan_file_dedup(const LinkMatcher *m, int file_idx, int *seen,
+                           IdVector *scratch, Arena *arena) {
+    if (!dedup_twin || !dedup_twin[file_idx]) {
+        return scan_file_mentions(m, file_idx, seen, scratch, arena);
+    }
+    int fd = open(file_link(file_idx)->path, O_RDONLY);
+    struct stat statbuf;
+    void *map = MAP_FAILED;
+    if (fd != -1 && fstat(fd, &statbuf) == 0 && statbuf.st_size > 0) {
+        map = mmap(NULL, (size_t)statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        // Unmappable or unreadable: the plain path reads it or reports why not
+        if (fd != -1) close(fd);
+        return scan_file_mentions(m, file_idx, seen, scratch, arena);
+    }
+
+    madvise(map, (size_t)statbuf.st_size, MADV_SEQUENTIAL);
+    int ret = scan_buffer_dedup(m, file_idx, map, (size_t)statbuf.st_size,
+                                seen, scratch, arena);
+    munmap(map, (size_t)statbuf.st_size);
+    close(fd);
+    return ret;
+}
+
+// ============================================================================
+// SCAN SCHEDULING
+// ============================================================================
+// Phase 1 time is dominated by bytes read, so files are not handed out in
+// discovery order: a few huge files picked up last would leave one thread
+// scanning while the rest wait at the barrier. Instead
+//   - scan_order lists files largest first (by power-of-two cost class, so
+//     ordering is a linear counting sort and discovery order is kept within
+//     a class), and
+//   - each chunk takes files until it holds about remaining cost /
+//     (SCAN_GUIDE_FACTOR * threads), so huge files go out one at a time and
+//     the small tail in batches, and everyone runs dry at about the same time.
+
+// Estimated cost of scanning file idx (bytes, plus a fixed per-file cost)
+static inline int64_t scan_cost(int idx) {
+    int64_t size = file_link(idx)->size;
+    return (size > 0 ? size : 0) + SCAN_FILE_COST;
+}
+
+// Fill scan_order with files [first, end) (most expensive first) and the
+// total cost to hand out. Returns 0 on success, -1 on allocation failure
+static int build_scan_order(int first, int end) {
+    size_t class_start[SCAN_COST_CLASSES + 1] = {0};
+    int count = end - first;
+    unsigned char *cls = malloc(count > 0 ? count : 1);
+    scan_order = malloc((count > 0 ? count : 1) * sizeof(int32_t));
+    if (!cls || !scan_order) {
+        free(cls);
+        return -1;
+    }
+    scan_order_count = count;
+
+    // = Count files per class (class 0 = most expensive) =
+    work_queue.scan_cost_left = 0;
+    for (int i = 0; i < count; i++) {
+        int64_t cost = scan_cost(first + i);
+        work_queue.scan_cost_left += cost;
+        cls[i] = (unsigned char)__builtin_clzll((unsigned long long)cost);
+        class_start[cls[i] + 1]++;
+    }
+    for (int c = 0; c < SCAN_COST_CLASSES; c++) {
+        class_start[c + 1] += class_start[c];
+    }
+
+    // = Place each file after the earlier files of its class =
+    for (int i = 0; i < count; i++) {
+        scan_order[class_start[cls[i]]++] = first + i;
+    }
+    free(cls);
+    return 0;
+}
+
+// Get the next range [*start_pos, *end_pos) of scan_order for phase 1
+// Returns 0 if the thread got work, -1 when every file has been handed out
+static int get_next_scan_chunk(int *start_pos, int *end_pos) {
+    pthread_mutex_lock(&work_mutex);
+    // -------------------------------
+    int pos = work_queue.next_scan_idx;
+    if (pos >= scan_order_count) {
+        pthread_mutex_unlock(&work_mutex);
+        return -1;  // No more work available
+    }
+
+    // Always at least one file; stop at the guided target or the file cap
+    int64_t target = work_queue.scan_cost_left / (SCAN_GUIDE_FACTOR * NUM_THREADS);
+    int64_t taken = 0;
+    *start_pos = pos;
+    do {
+        taken += scan_cost(scan_order[pos++]);
+    } while (pos < scan_order_count && taken < target && pos - *start_pos < SCAN_CHUNK_MAX);
+
+    *end_pos = pos;
+    work_queue.next_scan_idx = pos;
+    work_queue.scan_cost_left -= taken;
+    // -------------------------------
+    pthread_mutex_unlock(&work_mutex);
+    return 0;
+}
+
+// ============================================================================
+// INLINK TRANSPOSE
+// ============================================================================
+// Inlinks are the outlink relation seen from the other end, so they are built
+// from the edge vectors instead of by scanning: a parallel counting sort.
+//   count   - each scanned file bumps inlink_count of every file it mentions
+//   reserve - each file gets an inlink vector of exactly that size
+//   scatter - each file appends itself to the vectors of the files it mentions
+//   sort    - each vector is sorted, since scatter order is nondeterministic
+// A barrier separates the steps; inlink_count doubles as the scatter cursor.
+
+// Count the edges out of src_idx towards their targets (after scanning it)
+static void count_inlinks(int src_idx) {
+    const FileLink *src = file_link(src_idx);
+    for (int i = 0; i < src->outlink_count; i++) {
+        __atomic_fetch_add(&file_link(src->outlinks[i])->inlink_count, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Allocate file_idx's inlink vector and reset its count to act as a cursor
+// Returns 0 on success, -1 on allocation failure
+static int reserve_inlinks(int file_idx, Arena *arena) {
+    FileLink *fl = file_link(file_idx);
+    if (fl->inlink_count > 0) {
+        fl->inlinks = arena_alloc(arena, (size_t)fl->inlink_count * sizeof(int32_t));
+        if (!fl->inlinks) return -1;
+    }
+    fl->inlink_count = 0;
+    return 0;
+}
+
+// Append src_idx to the inlink vector of every file it mentions
+static void scatter_inlinks(int src_idx) {
+    const FileLink *src = file_link(src_idx);
+    for (int i = 0; i < src->outlink_count; i++) {
+        FileLink *dst = file_link(src->outlinks[i]);
+        int32_t pos = __atomic_fetch_add(&dst->inlink_count, 1, __ATOMIC_RELAXED);
+        dst->inlinks[pos] = src_idx;
+    }
+}
+
+// ============================================================================
+// SPILLED ADJACENCY
+// ============================================================================
+// --mem-mb bounds what the crawl keeps resident. What the node table, the
+// matcher and the per-thread scan state need is measured (RSS) or estimated
+// when Task Queue 1 starts, and the rest of the budget becomes one edge
+// buffer per thread. Phase 1 then appends each file's outlinks to its
+// thread's buffer as (src << 32 | dst) keys instead of an arena. A full
+// buffer is sorted and written as a run twice: by source (outlinks) and,
+// with the halves of every key swapped, by target (inlinks). Each thread
+// appends its runs to two unlinked temporary files.
+//   - If no buffer ever filled, each thread unpacks its buffer in place into
+//     the usual outlink vectors and the crawl carries on in memory.
+//   - Otherwise the leftovers become runs too, and phases 2-4 become a k-way
+//     merge: threads take node ranges, seek every run to the range (binary
+//     search) and pull each node's inlinks and outlinks off the two merges,
+//     already ascending, exactly as the transpose would have produced them.
+// Pages of the file being scanned count towards RSS while it is mapped, but
+// they are page cache rather than crawl state and are not budgeted.
+
+// Sort keys by the bytes at `shift` and below, in place: qsort() may
+// allocate a copy as large as the buffer, which is the very memory the
+// budget holds back. MSD radix sort (American flag sort) on one byte per
+// level, insertion sort for short ranges
+static void sort_keys_from(uint64_t *keys, int64_t count, int shift) {
+    if (count < 32) {
+        for (int64_t i = 1; i < count; i++) {
+            uint64_t key = keys[i];
+            int64_t j = i;
+            for (; j > 0 && keys[j - 1] > key; j--) keys[j] = keys[j - 1];
+            keys[j] = key;
+        }
+        return;
+    }
+
+    // = Bucket boundaries for this byte =
+    int64_t next[256] = {0}, end[256];
+    for (int64_t i = 0; i < count; i++) {
+        next[(keys[i] >> shift) & 0xff]++;
+    }
+    int64_t pos = 0;
+    for (int b = 0; b < 256; b++) {
+        int64_t size = next[b];
+        next[b] = pos;
+        pos += size;
+        end[b] = pos;
+    }
+
+    // = Move every key into its bucket, following displacement cycles =
+    for (int b = 0; b < 256; b++) {
+        while (next[b] < end[b]) {
+            uint64_t key = keys[next[b]];
+            int kb = (int)((key >> shift) & 0xff);
+            while (kb != b) {
+                uint64_t displaced = keys[next[kb]];
+                keys[next[kb]++] = key;
+                key = displaced;
+                kb = (int)((key >> shift) & 0xff);
+            }
+            keys[next[b]++] = key;
+        }
+    }
+    if (shift == 0) return;
+
+    int64_t first = 0;
+    for (int b = 0; b < 256; b++) {
+        if (end[b] - first > 1) sort_keys_from(keys + first, end[b] - first, shift - 8);
+        first = end[b];
+    }
+}
+
+// Sort count keys ascending, in place
+static void sort_keys(uint64_t *keys, int64_t count) {
+    uint64_t bits = 0;
+    for (int64_t i = 0; i < count; i++) bits |= keys[i];
+    int shift = 56;
+    while (shift > 0 && (bits >> shift) == 0) shift -= 8;   // Skip all-zero top bytes
+    sort_keys_from(keys, count, shift);
+}
+
+// Bytes this process has resident right now (0 if /proc is unavailable)
+static int64_t resident_bytes(void) {
+    long long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (!fp) return 0;
+    if (fscanf(fp, "%lld %lld", &pages, &resident) != 2) resident = 0;
+    fclose(fp);
+    return (int64_t)resident * sysconf(_SC_PAGESIZE);
+}
+
+// Peak resident bytes of this program (VmHWM: unlike ru_maxrss, it starts
+// over at exec, so a large parent does not inflate it)
+static int64_t peak_resident_bytes(void) {
+    char line[128];
+    long long kib = -1;
+    FILE *fp = fopen("/proc/self/status", "r");
+    while (fp && kib < 0 && fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "VmHWM: %lld kB", &kib) != 1) kib = -1;
+    }
+    if (fp) fclose(fp);
+    if (kib < 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        kib = usage.ru_maxrss;
+    }
+    return (int64_t)kib << 10;
+}
+
+// Size and map the edge buffers from what the budget leaves after the
+// crawl's fixed state. When even the smallest buffers do not fit, the read
+// rings are shrunk first; a budget that still cannot be met is rejected.
+// Returns 0 on success, -1 on failure
+static int spill_start(void) {
+    int64_t per_thread = (int64_t)file_link_count * sizeof(int) +      // seen[]
+                         (int64_t)OUTPUT_POOL_BLOCKS * OUTPUT_BLOCK_SIZE + // output blocks
+                         (int64_t)SPILL_MIN_KEYS * sizeof(uint64_t) +  // smallest edge buffer
+                         SPILL_THREAD_OVERHEAD;
+    int64_t fixed = resident_bytes() + NUM_THREADS * per_thread +
+                    SPILL_THREAD_OVERHEAD;                             // writer thread
+    int64_t ring_room = (MEMORY_BUDGET - fixed) / NUM_THREADS;
+    if (ring_room < 0) {
+        fprintf(stderr, "Error: --mem-mb %lld is below the %lld MiB this crawl needs "
+                "(%d files, %d threads)\n", (long long)(MEMORY_BUDGET >> 20),
+                (long long)((fixed + (1 << 20) - 1) >> 20), file_link_count, NUM_THREADS);
+        return -1;
+    }
+    if ((int64_t)QUEUE_DEPTH * READ_RING_MAX_FILE > ring_room) {
+        int depth = (int)(ring_room / READ_RING_MAX_FILE);
+        fprintf(stderr, "Warning: --mem-mb leaves room for %d reads in flight per thread "
+                "(--queue-depth %d)\n", depth, QUEUE_DEPTH);
+        QUEUE_DEPTH = depth;
+    }
+    fixed += (int64_t)NUM_THREADS * QUEUE_DEPTH * READ_RING_MAX_FILE;
+    spill_cap = SPILL_MIN_KEYS + (MEMORY_BUDGET - fixed) / NUM_THREADS / (int64_t)sizeof(uint64_t);
+
+    spill_buffers = calloc(NUM_THREADS, sizeof(SpillBuffer));
+    if (!spill_buffers) return -1;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        SpillBuffer *sb = &spill_buffers[i];
+        sb->out_fd = sb->in_fd = -1;
+        // Mapped, not malloc'd: pages only become resident as the buffer
+        // fills, and an unpacked buffer can give its tail back (spill_finish)
+        sb->mapped = (size_t)spill_cap * sizeof(uint64_t);
+        sb->keys = mmap(NULL, sb->mapped, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (sb->keys == MAP_FAILED) {
+            perror("mmap edge buffer");
+            sb->keys = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Create an unlinked temporary file next to the output. Returns its fd or -1
+static int spill_open_file(void) {
+    char name[256];
+    snprintf(name, sizeof(name), "part-1-outputs/%s_spill_XXXXXX", DIR_STRUCTURE);
+    int fd = mkstemp(name);
+    if (fd == -1) {
+        perror("mkstemp spill file");
+        return -1;
+    }
+    unlink(name);   // Space comes back when fd is closed, even after a crash
+    return fd;
+}
+
+// Write count keys to fd. Returns 0 on success, -1 on a write error
+static int write_keys(int fd, const uint64_t *keys, int64_t count) {
+    const char *p = (const char *)keys;
+    size_t left = (size_t)count * sizeof(uint64_t);
+    while (left > 0) {
+        ssize_t wrote = write(fd, p, left);
+        if (wrote == -1) {
+            if (errno == EINTR) continue;
+            perror("write spill run");
+            return -1;
+        }
+        p += wrote;
+        left -= (size_t)wrote;
+    }
+    return 0;
+}
+
+// Sort tid's buffer and append it as a run to both of its files
+// Returns 0 on success, -1 on failure
+static int spill_flush(int tid) {
+    SpillBuffer *sb = &spill_buffers[tid];
+    if (sb->count == 0) return 0;
+    if (sb->out_fd == -1) {
+        if ((sb->out_fd = spill_open_file()) == -1 || (sb->in_fd = spill_open_file()) == -1) {
+            return -1;
+        }
+    }
+
+    sort_keys(sb->keys, sb->count);
+    if (write_keys(sb->out_fd, sb->keys, sb->count) != 0) return -1;
+    for (int64_t i = 0; i < sb->count; i++) {
+        sb->keys[i] = (sb->keys[i] << 32) | (sb->keys[i] >> 32);
+    }
+    sort_keys(sb->keys, sb->count);
+    if (write_keys(sb->in_fd, sb->keys, sb->count) != 0) return -1;
+
+    pthread_mutex_lock(&spill_mutex);
+    // -------------------------------
+    if (spill_run_count == spill_run_cap) {
+        int cap = spill_run_cap ? spill_run_cap * 2 : 64;
+        SpillRun *grown = realloc(spill_runs, (size_t)cap * sizeof(SpillRun));
+        if (!grown) {
+            pthread_mutex_unlock(&spill_mutex);
+            return -1;
+        }
+        spill_runs = grown;
+        spill_run_cap = cap;
+    }
+    spill_runs[spill_run_count++] = (SpillRun){sb->out_fd, sb->in_fd, sb->written, sb->count};
+    spilled_keys += sb->count;
+    __atomic_store_n(&spill_active, 1, __ATOMIC_RELAXED);
+    // -------------------------------
+    pthread_mutex_unlock(&spill_mutex);
+
+    sb->written += sb->count;
+    sb->count = 0;
+    return 0;
+}
+
+// Record the outlinks file_idx was just scanned for: count them towards
+// their targets' inlinks or, under --mem-mb, move them out of scratch (where
+// commit_outlinks left them) into tid's edge buffer
+// Returns 0 on success, -1 if a full buffer could not be spilled
+static int record_outlinks(int tid, int file_idx, const IdVector *scratch) {
+    if (!spill_buffers) {
+        count_inlinks(file_idx);
+        return 0;
+    }
+    SpillBuffer *sb = &spill_buffers[tid];
+    int32_t count = file_link(file_idx)->outlink_count;
+    for (int32_t i = 0; i < count; i++) {
+        if (sb->count == spill_cap && spill_flush(tid) != 0) return -1;
+        sb->keys[sb->count++] = ((uint64_t)file_idx << 32) | (uint32_t)scratch->ids[i];
+    }
+    return 0;
+}
+
+// End of phase 1 (spill_active is final). If anything was spilled, the rest
+// of the buffer becomes a run too; otherwise the buffer is turned into the
+// outlink vectors of its files in place, and their inlinks are counted.
+// Returns 0 on success, -1 on failure
+static int spill_finish(int tid) {
+    SpillBuffer *sb = &spill_buffers[tid];
+    if (__atomic_load_n(&spill_active, __ATOMIC_RELAXED)) {
+        int ret = spill_flush(tid);
+        munmap(sb->keys, sb->mapped);
+        sb->keys = NULL;
+        return ret;
+    }
+
+    // = Sort by (src, dst), then keep only dst: 4 bytes per key, written
+    //   behind the keys still to be read =
+    sort_keys(sb->keys, sb->count);
+    int32_t *ids = (int32_t *)sb->keys;
+    int prev = -1;
+    for (int64_t i = 0; i < sb->count; i++) {
+        uint64_t key = sb->keys[i];
+        int src = (int)(key >> 32);
+        int32_t dst = (int32_t)(uint32_t)key;
+        memcpy(&ids[i], &dst, sizeof(dst));
+        if (src != prev) {
+            if (prev != -1) count_inlinks(prev);
+            file_link(src)->outlinks = &ids[i];
+            prev = src;
+        }
+    }
+    if (prev != -1) count_inlinks(prev);
+
+    // = Give back the pages the unpacked vectors no longer reach =
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t keep = ((size_t)sb->count * sizeof(int32_t) + page - 1) & ~(page - 1);
+    if (keep < sb->mapped) {
+        munmap((char *)sb->keys + keep, sb->mapped - keep);
+        sb->mapped = keep;
+    }
+    if (sb->mapped == 0) sb->keys = NULL;
+    return 0;
+}
+
+// Release the edge buffers and run files
+static void free_spill(void) {
+    for (int i = 0; spill_buffers && i < NUM_THREADS; i++) {
+        SpillBuffer *sb = &spill_buffers[i];
+        if (sb->keys) munmap(sb->keys, sb->mapped);
+        if (sb->out_fd != -1) close(sb->out_fd);
+        if (sb->in_fd != -1) close(sb->in_fd);
+    }
+    free(spill_buffers);
+    free(spill_runs);
+    spill_buffers = NULL;
+    spill_runs = NULL;
+    spill_run_count = spill_run_cap = 0;
+}
+
+// Keys a merge cursor reads ahead: one thread's buffer share, split over
+// every run in both orders
+static int spill_read_keys(void) {
+    int64_t keys = spill_cap / (2 * (int64_t)(spill_run_count > 0 ? spill_run_count : 1));
+    if (keys < SPILL_READ_MIN) keys = SPILL_READ_MIN;
+    if (keys > SPILL_READ_MAX) keys = SPILL_READ_MAX;
+    return (int)keys;
+}
+
+// pread() exactly `bytes` bytes at `offset`. Returns 0 on success, -1 on failure
+static int pread_full(int fd, void *buf, size_t bytes, off_t offset) {
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t got = pread(fd, (char *)buf + done, bytes - done, offset + (off_t)done);
+        if (got == -1 && errno == EINTR) continue;
+        if (got <= 0) {
+            perror("read spill run");
+            return -1;
+        }
+        done += (size_t)got;
+    }
+    return 0;
+}
+
+// Read ahead the next keys of a cursor. Returns 0 on success, -1 on failure
+static int spill_cursor_fill(SpillCursor *c, int buf_keys) {
+    int64_t want = c->end - c->next;
+    if (want > buf_keys) want = buf_keys;
+    if (pread_full(c->fd, c->buf, (size_t)want * sizeof(uint64_t),
+                   (off_t)(c->next * (int64_t)sizeof(uint64_t))) != 0) {
+        return -1;
+    }
+    c->next += want;
+    c->pos = 0;
+    c->len = (int)want;
+    return 0;
+}
+
+// Restore the heap order below position i
+static void spill_sift_down(SpillMerge *m, int i) {
+    while (1) {
+        int least = i;
+        for (int child = 2 * i + 1; child <= 2 * i + 2 && child < m->heap_count; child++) {
+            const SpillCursor *c = &m->cursors[m->heap[child]];
+            const SpillCursor *l = &m->cursors[m->heap[least]];
+            if (c->buf[c->pos] < l->buf[l->pos]) least = child;
+        }
+        if (least == i) return;
+        int tmp = m->heap[i];
+        m->heap[i] = m->heap[least];
+        m->heap[least] = tmp;
+        i = least;
+    }
+}
+
+// Prepare a merge over every run, by source (by_target = 0) or by target
+// Returns 0 on success, -1 on allocation failure
+static int spill_merge_open(SpillMerge *m, int by_target) {
+    m->count = spill_run_count;
+    m->heap_count = 0;
+    m->buf_keys = spill_read_keys();
+    m->cursors = calloc(m->count > 0 ? m->count : 1, sizeof(SpillCursor));
+    m->heap = malloc((m->count > 0 ? m->count : 1) * sizeof(int));
+    if (!m->cursors || !m->heap) return -1;
+    for (int i = 0; i < m->count; i++) {
+        SpillCursor *c = &m->cursors[i];
+        c->fd = by_target ? spill_runs[i].in_fd : spill_runs[i].out_fd;
+        c->first = spill_runs[i].first;
+        c->end = c->first + spill_runs[i].count;
+        c->buf = malloc((size_t)m->buf_keys * sizeof(uint64_t));
+        if (!c->buf) return -1;
+    }
+    return 0;
+}
+
+// Position the merge at the first key of `node` (binary search in every run)
+// Returns 0 on success, -1 on a read error
+static int spill_merge_seek(SpillMerge *m, int node) {
+    uint64_t target = (uint64_t)node << 32;
+    m->heap_count = 0;
+    for (int i = 0; i < m->count; i++) {
+        SpillCursor *c = &m->cursors[i];
+        int64_t lo = c->first, hi = c->end;
+        while (lo < hi) {
+            int64_t mid = lo + (hi - lo) / 2;
+            uint64_t key;
+            if (pread_full(c->fd, &key, sizeof(key), (off_t)(mid * (int64_t)sizeof(key))) != 0) {
+                return -1;
+            }
+            if (key < target) lo = mid + 1; else hi = mid;
+        }
+        c->next = lo;
+        if (lo == c->end) continue;
+        if (spill_cursor_fill(c, m->buf_keys) != 0) return -1;
+        m->heap[m->heap_count++] = i;
+    }
+    for (int i = m->heap_count / 2 - 1; i >= 0; i--) {
+        spill_sift_down(m, i);
+    }
+    return 0;
+}
+
+// Take every key of `node` off the merge (it must be the next node with any)
+// and collect their other halves, ascending, in `out`
+// Returns 0 on success, -1 on failure
+static int spill_merge_collect(SpillMerge *m, int node, IdVector *out) {
+    out->count = 0;
+    while (m->heap_count > 0) {
+        SpillCursor *c = &m->cursors[m->heap[0]];
+        uint64_t key = c->buf[c->pos];
+        if ((int)(key >> 32) != node) break;
+        if (idvec_push(out, (int32_t)(uint32_t)key) != 0) return -1;
+
+        if (++c->pos == c->len) {
+            if (c->next == c->end) {
+                m->heap[0] = m->heap[--m->heap_count];  // Run exhausted
+            } else if (spill_cursor_fill(c, m->buf_keys) != 0) {
+                return -1;
+            }
+        }
+        spill_sift_down(m, 0);
+    }
+    return 0;
+}
+
+// Release a merge
+static void spill_merge_free(SpillMerge *m) {
+    for (int i = 0; m->cursors && i < m->count; i++) {
+        free(m->cursors[i].buf);
+    }
+    free(m->cursors);
+    free(m->heap);
+    m->cursors = NULL;
+    m->heap = NULL;
+}
+
+// ============================================================================
+// IO_URING READ ENGINE
+// ============================================================================
+// A blocking open/mmap/close per file keeps at most one read per thread in
+// front of the device, which starves cold storage. With --queue-depth Q > 0
+// each T-1 thread owns an io_uring (raw syscalls, no liburing) with Q slots:
+// a small file is queued as three linked SQEs
+//   OPENAT (into fixed file Q) -> READ (fixed file Q) -> CLOSE (fixed file Q)
+// and the thread keeps filling slots from its scan chunks, scanning whichever
+// files have finished, so up to Q reads are in flight while it scans.
+// The read asks for one byte more than the size seen at discovery, so a file
+// that grew since is noticed. Any failed, cancelled or grown read is redone
+// by the blocking path (scan_file_mentions), which also reports real errors.
+// Files over READ_RING_MAX_FILE are always mmap'd: the page cache mapping
+// beats copying them into a buffer. If io_uring is missing or disabled the
+// ring is simply never created.
+
+#ifdef HAVE_IO_URING
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+// Queue one SQE (the caller has checked there is room)
+static struct io_uring_sqe *read_ring_sqe(ReadRing *r) {
+    unsigned tail = *r->sq_tail + r->to_submit;
+    unsigned idx = tail & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[idx] = idx;
+    r->to_submit++;
+    return sqe;
+}
+
+// Hand the queued SQEs to the kernel, optionally waiting for min_complete CQEs
+static void read_ring_submit(ReadRing *r, unsigned min_complete) {
+    __atomic_store_n(r->sq_tail, *r->sq_tail + r->to_submit, __ATOMIC_RELEASE);
+    while (r->to_submit > 0 || min_complete > 0) {
+        int ret = uring_enter(r->ring_fd, r->to_submit, min_complete,
+                              min_complete ? IORING_ENTER_GETEVENTS : 0);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            perror("io_uring_enter");
+            exit(1);
+        }
+        r->to_submit -= (unsigned)ret <= r->to_submit ? (unsigned)ret : r->to_submit;
+        min_complete = 0;
+    }
+}
+#endif
+
+// Release a ring (waits for nothing: only call once it has been drained)
+static void free_read_ring(ReadRing *r) {
+    if (r->sqes) munmap(r->sqes, r->sqes_len);
+    if (r->cq_ring && r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_ring_len);
+    if (r->sq_ring) munmap(r->sq_ring, r->sq_ring_len);
+    if (r->ring_fd != -1) close(r->ring_fd);
+    if (r->slots) {
+        for (int i = 0; i < r->depth; i++) free(r->slots[i].buf);
+    }
+    free(r->slots);
+    free(r->ready);
+    memset(r, 0, sizeof(*r));
+    r->ring_fd = -1;
+}
+
+// Create a ring with `depth` slots; on failure r->ring_fd stays -1
+// Returns 0 if the ring is usable, -1 otherwise (use blocking reads)
+static int read_ring_init(ReadRing *r, int depth) {
+    memset(r, 0, sizeof(*r));
+    r->ring_fd = -1;
+#ifdef HAVE_IO_URING
+    if (depth <= 0) return -1;
+
+    // Every slot can have three SQEs queued at once
+    unsigned entries = 1;
+    while (entries < 3u * (unsigned)depth) entries <<= 1;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (fd == -1) return -1;     // ENOSYS, EPERM, io_uring_disabled, ...
+
+    r->sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_ring_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_ring_len > r->sq_ring_len) r->sq_ring_len = r->cq_ring_len;
+        r->cq_ring_len = r->sq_ring_len;
+    }
+    r->sq_ring = mmap(NULL, r->sq_ring_len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    r->cq_ring = (p.features & IORING_FEAT_SINGLE_MMAP) ? r->sq_ring
+               : mmap(NULL, r->cq_ring_len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    r->ring_fd = fd;
+    if (r->sq_ring == MAP_FAILED || r->cq_ring == MAP_FAILED || r->sqes == MAP_FAILED) {
+        if (r->sq_ring == MAP_FAILED) r->sq_ring = NULL;
+        if (r->cq_ring == MAP_FAILED) r->cq_ring = NULL;
+        if (r->sqes == MAP_FAILED) r->sqes = NULL;
+        free_read_ring(r);
+        return -1;
+    }
+    char *sq = r->sq_ring, *cq = r->cq_ring;
+    r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    // = Slots and their (initially empty) fixed files =
+    r->depth = depth;
+    r->slots = calloc(depth, sizeof(ReadSlot));
+    r->ready = malloc(depth * sizeof(int));
+    int *fds = malloc(depth * sizeof(int));
+    if (!r->slots || !r->ready || !fds) {
+        free(fds);
+        free_read_ring(r);
+        return -1;
+    }
+    for (int i = 0; i < depth; i++) {
+        r->slots[i].file_idx = -1;
+        fds[i] = -1;
+    }
+    int reg = (int)syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES, fds, depth);
+    free(fds);
+    if (reg == -1) {
+        free_read_ring(r);
+        return -1;
+    }
+    return 0;
+#else
+    (void)depth;
+    return -1;
+#endif
+}
+
+// Queue the open/read/close chain for file_idx (not submitted until the next
+// read_ring_reap). Returns 0 if queued, -1 if every slot is busy
+static int read_ring_queue(ReadRing *r, int file_idx) {
+#ifdef HAVE_IO_URING
+    if (r->in_flight == r->depth) return -1;
+    int slot = 0;
+    while (r->slots[slot].file_idx != -1) slot++;
+
+    ReadSlot *rs = &r->slots[slot];
+    const FileLink *fl = file_link(file_idx);
+    rs->want = (size_t)(fl->size > 0 ? fl->size : 0) + 1;
+    if (rs->cap < rs->want) {
+        unsigned char *grown = realloc(rs->buf, rs->want);
+        if (!grown) return -1;      // Caller falls back to a blocking read
+        rs->buf = grown;
+        rs->cap = rs->want;
+    }
+    rs->file_idx = file_idx;
+    rs->pending = 3;
+    rs->open_res = 0;
+    rs->read_res = 0;
+    r->in_flight++;
+
+    // user_data = slot * 4 + step (0 open, 1 read, 2 close)
+    struct io_uring_sqe *sqe = read_ring_sqe(r);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uint64_t)(uintptr_t)fl->path;
+    sqe->open_flags = O_RDONLY;
+    sqe->file_index = slot + 1;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = (uint64_t)slot * 4;
+
+    // Hard link: the close must run even if the read fails or comes up short
+    sqe = read_ring_sqe(r);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = slot;
+    sqe->addr = (uint64_t)(uintptr_t)rs->buf;
+    sqe->len = (uint32_t)rs->want;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = (uint64_t)slot * 4 + 1;
+
+    sqe = read_ring_sqe(r);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+    sqe->user_data = (uint64_t)slot * 4 + 2;
+    return 0;
+#else
+    (void)r;
+    (void)file_idx;
+    return -1;
+#endif
+}
+
+// Submit queued reads and wait until one file's chain has completed
+// Returns its slot (release it with read_ring_release), or -1 if the ring is empty
+static int read_ring_reap(ReadRing *r) {
+#ifdef HAVE_IO_URING
+    if (r->to_submit > 0) read_ring_submit(r, 0);
+    while (r->ready_count == 0) {
+        if (r->in_flight == 0) return -1;
+
+        unsigned head = *r->cq_head;
+        unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            read_ring_submit(r, 1);     // Sleep until something completes
+            continue;
+        }
+        for (; head != tail; head++) {
+            const struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+            ReadSlot *rs = &r->slots[cqe->user_data / 4];
+            if (cqe->user_data % 4 == 0) rs->open_res = cqe->res;
+            if (cqe->user_data % 4 == 1) rs->read_res = cqe->res;
+            if (--rs->pending == 0) {
+                r->ready[r->ready_count++] = (int)(cqe->user_data / 4);
+            }
+        }
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return r->ready[--r->ready_count];
+#else
+    (void)r;
+    return -1;
+#endif
+}
+
+// Contents of a completed slot: returns the bytes read, or -1 if the file
+// has to be read the blocking way (open/read failed, or it grew)
+static ssize_t read_ring_result(const ReadRing *r, int slot) {
+    const ReadSlot *rs = &r->slots[slot];
+    if (rs->open_res < 0 || rs->read_res < 0 || (size_t)rs->read_res >= rs->want) {
+        return -1;
+    }
+    return rs->read_res;
+}
+
+// Free a slot for the next file
+static void read_ring_release(ReadRing *r, int slot) {
+    r->slots[slot].file_idx = -1;
+    r->in_flight--;
+}
+
+// Scan the next file whose ring read completes (blocking read if the ring
+// read failed) and record its outlinks
+// Returns 0 if a file was scanned, -1 if the ring is empty
+static int scan_next_ring_read(ReadRing *r, int tid, int *seen,
+                               IdVector *scratch, Arena *arena) {
+    int slot = read_ring_reap(r);
+    if (slot == -1) return -1;
+
+    int file_idx = r->slots[slot].file_idx;
+    ssize_t len = read_ring_result(r, slot);
+    if (len >= 0) {
+        scan_buffer_dedup(&link_matcher, file_idx, r->slots[slot].buf, (size_t)len,
+                          seen, scratch, arena);
+    } else {
+        scan_file_dedup(&link_matcher, file_idx, seen, scratch, arena);
+    }
+    read_ring_release(r, slot);
+    if (record_outlinks(tid, file_idx, scratch) != 0) {
+        fprintf(stderr, "ERROR: Could not spill edges\n");
+        exit(1);
+    }
+    TRACE(tid, TRACE_SCAN_END, file_idx, file_link(file_idx)->outlink_count);
+    return 0;
+}
+
+// ============================================================================
+// BINARY EDGE LIST OUTPUT
+// ============================================================================
+// --binary writes STRUCT_N_file_links.bin instead of the text link file:
+// a string table of every node's path and name followed by packed
+// (src, dst) int32 pairs, which csr_build_from_edges() turns into a CSR
+// without parsing text or looking names up again (layout in CSR.h).
+// Inlinks are not stored; they are the same edges seen from the other end.
+
+// Write the whole node table and its outlinks to `filename`
+// Returns 0 on success, -1 on failure
+static int write_edge_list(const char *filename) {
+    FILE *fp = fopen(filename, "wb");
+    if (!fp) {
+        perror("fopen edge list");
+        return -1;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+
+    // = Header =
+    int64_t strtab_bytes = 0;
+    int64_t edge_count = 0;
+    for (int i = 0; i < file_link_count; i++) {
+        const FileLink *fl = file_link(i);
+        strtab_bytes += (int64_t)strlen(fl->path) + (int64_t)strlen(fl->name) + 2;
+        edge_count += fl->outlink_count;
+    }
+    uint32_t magic = CSR_EDGES_MAGIC;
+    uint32_t version = CSR_EDGES_VERSION;
+    int32_t n = file_link_count;
+    int32_t reserved = 0;
+    fwrite(&magic, sizeof(magic), 1, fp);
+    fwrite(&version, sizeof(version), 1, fp);
+    fwrite(&n, sizeof(n), 1, fp);
+    fwrite(&reserved, sizeof(reserved), 1, fp);
+    fwrite(&strtab_bytes, sizeof(strtab_bytes), 1, fp);
+    fwrite(&edge_count, sizeof(edge_count), 1, fp);
+
+    // = String table: "path\0name\0" per node =
+    for (int i = 0; i < file_link_count; i++) {
+        const FileLink *fl = file_link(i);
+        fwrite(fl->path, 1, strlen(fl->path) + 1, fp);
+        fwrite(fl->name, 1, strlen(fl->name) + 1, fp);
+    }
+
+    // = Edges, grouped by source in ascending order =
+    if (spill_active) {
+        // --mem-mb spilled: the outlinks only exist as runs, merged by source
+        SpillMerge outs = {0};
+        IdVector outlinks = {0};
+        int ok = spill_merge_open(&outs, 0) == 0 && spill_merge_seek(&outs, 0) == 0;
+        for (int i = 0; ok && i < file_link_count; i++) {
+            ok = spill_merge_collect(&outs, i, &outlinks) == 0;
+            for (int j = 0; ok && j < outlinks.count; j++) {
+                int32_t edge[2] = {i, outlinks.ids[j]};
+                fwrite(edge, sizeof(edge), 1, fp);
+            }
+        }
+        spill_merge_free(&outs);
+        free(outlinks.ids);
+        if (!ok) {
+            fprintf(stderr, "ERROR: Could not merge spilled edges\n");
+            fclose(fp);
+            return -1;
+        }
+    } else {
+        for (int i = 0; i < file_link_count; i++) {
+            const FileLink *fl = file_link(i);
+            for (int j = 0; j < fl->outlink_count; j++) {
+                int32_t edge[2] = {i, fl->outlinks[j]};
+                fwrite(edge, sizeof(edge), 1, fp);
+            }
+        }
+    }
+
+    if (ferror(fp) | fclose(fp)) {
+        perror("write edge list");
+        return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// ASYNC OUTPUT WRITER
+// ============================================================================
+// T-1 workers never touch the link file. Each fills an OutBlock with output
+// lines and, once it holds OUTPUT_BLOCK_SIZE bytes, pushes it onto
+// writer_queue (a lock-free stack) and carries on with a spare block. The
+// writer thread takes the whole stack at once, writes it with as few
+// writev() calls as possible through one O_APPEND descriptor, and pushes each
+// block back onto its owner's free stack. Each worker owns a fixed pool of
+// OUTPUT_POOL_BLOCKS blocks, allocated by writer_start: while the writer keeps
+// up the worker never waits for I/O, and when it falls behind the worker
+// waits for a block to come back (so output memory stays bounded).
+// Both stacks are only ever emptied as a whole (exchange with NULL), so
+// there is no ABA problem. Lines never straddle blocks.
+
+// Push a block onto a lock-free stack
+static void block_push(OutBlock **stack, OutBlock *b) {
+    OutBlock *head = __atomic_load_n(stack, __ATOMIC_RELAXED);
+    do {
+        b->next = head;
+    } while (!__atomic_compare_exchange_n(stack, &head, b, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// Release the output block pool and the per-worker stacks
+static void free_block_pool(void) {
+    if (block_pool) {
+        for (int i = 0; i < NUM_THREADS * OUTPUT_POOL_BLOCKS; i++) {
+            free(block_pool[i].buf.data);
+        }
+    }
+    if (blocks_returned) {
+        for (int i = 0; i < NUM_THREADS; i++) {
+            sem_destroy(&blocks_returned[i]);
+        }
+    }
+    free(block_pool);
+    free(blocks_returned);
+    free(free_blocks);
+    block_pool = NULL;
+    blocks_returned = NULL;
+    free_blocks = NULL;
+}
+
+// Allocate OUTPUT_POOL_BLOCKS blocks per worker onto its free stack
+// Returns 0 on success, -1 on allocation failure
+static int alloc_block_pool(void) {
+    int count = NUM_THREADS * OUTPUT_POOL_BLOCKS;
+    free_blocks = calloc(NUM_THREADS, sizeof(OutBlock *));
+    blocks_returned = calloc(NUM_THREADS, sizeof(sem_t));
+    block_pool = calloc(count, sizeof(OutBlock));
+    if (!free_blocks || !blocks_returned || !block_pool) {
+        free(free_blocks);
+        free(blocks_returned);
+        free(block_pool);
+        free_blocks = NULL;
+        blocks_returned = NULL;
+        block_pool = NULL;
+        return -1;
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        sem_init(&blocks_returned[i], 0, 0);
+    }
+    for (int i = 0; i < count; i++) {
+        OutBlock *b = &block_pool[i];
+        b->owner = i / OUTPUT_POOL_BLOCKS;
+        b->buf.data = malloc(OUTPUT_BLOCK_SIZE);
+        if (!b->buf.data) {
+            free_block_pool();
+            return -1;
+        }
+        b->buf.cap = OUTPUT_BLOCK_SIZE;
+        b->next = free_blocks[b->owner];
+        free_blocks[b->owner] = b;
+    }
+    return 0;
+}
+
+// Write every byte of blocks[0..count) with writev()
+// Returns 0 on success, -1 on a write error
+static int write_blocks(OutBlock **blocks, int count) {
+    struct iovec iov[WRITER_MAX_IOV];
+    int first = 0;
+    while (first < count) {
+        int n = 0;
+        for (; n < WRITER_MAX_IOV && first + n < count; n++) {
+            iov[n].iov_base = blocks[first + n]->buf.data;
+            iov[n].iov_len = blocks[first + n]->buf.len;
+        }
+        first += n;
+
+        struct iovec *v = iov;
+        while (n > 0) {
+            ssize_t wrote = writev(writer_fd, v, n);
+            if (wrote == -1) {
+                if (errno == EINTR) continue;
+                perror("writev");
+                return -1;
+            }
+            // Skip what was written (a short write can stop mid-block)
+            while (n > 0 && (size_t)wrote >= v->iov_len) {
+                wrote -= v->iov_len;
+                v++;
+                n--;
+            }
+            if (n > 0) {
+                v->iov_base = (char *)v->iov_base + wrote;
+                v->iov_len -= wrote;
+            }
+        }
+    }
+    return 0;
+}
+
+// Writer thread: drain writer_queue until writer_done
+static void *writer_worker(void *arg) {
+    (void)arg;
+    OutBlock *batch[WRITER_MAX_IOV];
+
+    while (1) {
+        while (sem_wait(&writer_sem) == -1 && errno == EINTR) {}
+        int done = __atomic_load_n(&writer_done, __ATOMIC_ACQUIRE);
+        OutBlock *list = __atomic_exchange_n(&writer_queue, NULL, __ATOMIC_ACQUIRE);
+        if (!list) {
+            if (done) break;
+            continue;   // Already drained by an earlier wakeup
+        }
+
+        // = Restore submission order (the stack is newest first) =
+        OutBlock *ordered = NULL;
+        while (list) {
+            OutBlock *next = list->next;
+            list->next = ordered;
+            ordered = list;
+            list = next;
+        }
+
+        // = Write in batches, then hand the blocks back =
+        while (ordered) {
+            int count = 0;
+            while (ordered && count < WRITER_MAX_IOV) {
+                batch[count++] = ordered;
+                ordered = ordered->next;
+            }
+            if (!writer_failed && write_blocks(batch, count) != 0) {
+                writer_failed = 1;     // Keep draining so workers get their blocks back
+            }
+            for (int i = 0; i < count; i++) {
+                int owner = batch[i]->owner;
+                batch[i]->buf.len = 0;
+                if (batch[i]->buf.cap > OUTPUT_BLOCK_SIZE) {
+                    // Grown by one oversized line: back to the pool's size
+                    char *shrunk = realloc(batch[i]->buf.data, OUTPUT_BLOCK_SIZE);
+                    if (shrunk) {
+                        batch[i]->buf.data = shrunk;
+                        batch[i]->buf.cap = OUTPUT_BLOCK_SIZE;
+                    }
+                }
+                block_push(&free_blocks[owner], batch[i]);
+                sem_post(&blocks_returned[owner]);
+            }
+        }
+    }
+    return NULL;
+}
+
+// Get an empty block for worker tid: a spare or one the writer returned,
+// waiting for the writer when the whole pool is queued
+static OutBlock *writer_get_block(int tid, OutBlock **spare) {
+    while (!*spare) {
+        *spare = __atomic_exchange_n(&free_blocks[tid], NULL, __ATOMIC_ACQUIRE);
+        if (!*spare) {
+            // (posts for blocks already taken only cause an extra pass)
+            while (sem_wait(&blocks_returned[tid]) == -1 && errno == EINTR) {}
+        }
+    }
+    OutBlock *b = *spare;
+    *spare = b->next;
+    return b;
+}
+
+// Queue a filled block for writing (never blocks)
+static void writer_submit(OutBlock *b) {
+    block_push(&writer_queue, b);
+    sem_post(&writer_sem);
+}
+
+// Open `filename` (appending, or truncated first) and start the writer
+// Returns 0 on success, -1 on failure
+static int writer_start(const char *filename, int truncate) {
+    writer_fd = open(filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC |
+                     (truncate ? O_TRUNC : 0), 0644);
+    if (writer_fd == -1) {
+        perror("open output file");
+        return -1;
+    }
+    if (alloc_block_pool() != 0) {
+        fprintf(stderr, "Error: Failed to allocate output blocks\n");
+        close(writer_fd);
+        return -1;
+    }
+    if (sem_init(&writer_sem, 0, 0) != 0) {
+        free_block_pool();
+        close(writer_fd);
+        return -1;
+    }
+    writer_queue = NULL;
+    writer_done = 0;
+    if (pthread_create(&writer_thread, NULL, writer_worker, NULL) != 0) {
+        perror("pthread_create");
+        sem_destroy(&writer_sem);
+        free_block_pool();
+        close(writer_fd);
+        return -1;
+    }
+    return 0;
+}
+
+// Write whatever is still queued, stop the writer and close the file
+// (call after every worker has submitted its last block)
+// Returns 0 if every byte was written, -1 otherwise
+static int writer_finish(void) {
+    __atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+    sem_post(&writer_sem);
+    pthread_join(writer_thread, NULL);
+
+    free_block_pool();
+    sem_destroy(&writer_sem);
+    if (close(writer_fd) == -1) writer_failed = 1;
+    writer_fd = -1;
+    return writer_failed ? -1 : 0;
+}
+
+// ============================================================================
+// PREFETCHER
+// ============================================================================
+// Task Queue 0 only walks metadata, and Task Queue 1 cannot start until the
+// filename dictionary is complete, so without help the device idles during
+// discovery and is then flooded. Each T-0 thread hands the files it finds to
+// a prefetcher thread (after every directory), which opens them and issues
+// posix_fadvise(WILLNEED): the kernel starts readahead and returns at once.
+// By the time T-1 scans, most contents are already in the page cache.
+//   - At most PREFETCH_BUDGET bytes are prefetched (more would only evict
+//     earlier prefetches before T-1 reaches them).
+//   - Discovery never waits: when the queue is full, files are not prefetched.
+//   - The prefetcher runs until T-1 starts (it also overlaps the matcher
+//     build); the io_uring read ring takes over from there.
+
+// Queue newly found files for prefetching (drops what does not fit)
+static void prefetch_push(const int32_t *ids, int count) {
+    pthread_mutex_lock(&prefetch_queue.lock);
+    // -------------------------------
+    for (int i = 0; i < count; i++) {
+        if (prefetch_queue.tail - prefetch_queue.head == PREFETCH_QUEUE_SIZE) break;
+        prefetch_queue.ids[prefetch_queue.tail++ % PREFETCH_QUEUE_SIZE] = ids[i];
+    }
+    pthread_cond_signal(&prefetch_queue.nonempty);
+    // -------------------------------
+    pthread_mutex_unlock(&prefetch_queue.lock);
+}
+
+// Prefetcher thread: readahead for queued files until stopped or out of budget
+static void *prefetch_worker(void *arg) {
+    (void)arg;
+    int32_t batch[PREFETCH_BATCH];
+    int64_t budget_left = PREFETCH_BUDGET;
+
+    while (budget_left > 0) {
+        // = Take a batch =
+        pthread_mutex_lock(&prefetch_queue.lock);
+        while (prefetch_queue.head == prefetch_queue.tail && !prefetch_queue.stop) {
+            pthread_cond_wait(&prefetch_queue.nonempty, &prefetch_queue.lock);
+        }
+        if (prefetch_queue.stop) {
+            pthread_mutex_unlock(&prefetch_queue.lock);
+            break;
+        }
+        int count = 0;
+        while (count < PREFETCH_BATCH && prefetch_queue.head != prefetch_queue.tail) {
+            batch[count++] = prefetch_queue.ids[prefetch_queue.head++ % PREFETCH_QUEUE_SIZE];
+        }
+        pthread_mutex_unlock(&prefetch_queue.lock);
+
+        // = Start readahead (no waiting for the data) =
+        for (int i = 0; i < count; i++) {
+            const FileLink *fl = file_link(batch[i]);
+            if (fl->size <= 0 || fl->size > budget_left) continue;
+            int fd = open(fl->path, O_RDONLY | O_CLOEXEC);
+            if (fd == -1) continue;     // T-1 reports unreadable files
+            posix_fadvise(fd, 0, fl->size, POSIX_FADV_WILLNEED);
+            close(fd);
+            budget_left -= fl->size;
+            prefetched_bytes += fl->size;
+            prefetched_files++;
+        }
+    }
+    return NULL;
+}
+
+// Start the prefetcher. Returns 0 on success, -1 on failure
+static int prefetch_start(void) {
+    prefetch_queue.head = prefetch_queue.tail = 0;
+    prefetch_queue.stop = 0;
+    if (pthread_create(&prefetch_thread, NULL, prefetch_worker, NULL) != 0) {
+        perror("pthread_create");
+        return -1;
+    }
+    prefetch_running = 1;
+    return 0;
+}
+
+// Stop the prefetcher (queued files are abandoned) and wait for it
+static void prefetch_finish(void) {
+    pthread_mutex_lock(&prefetch_queue.lock);
+    prefetch_queue.stop = 1;
+    pthread_cond_signal(&prefetch_queue.nonempty);
+    pthread_mutex_unlock(&prefetch_queue.lock);
+    pthread_join(prefetch_thread, NULL);
+    prefetch_running = 0;
+}
+
+// ============================================================================
+// TASK QUEUE 0 WORKER: DIRECTORY TRAVERSAL
+// ============================================================================
+// SPEC Section 3.1.5 - Find all files in directory tree
+// Each thread:
+//   1. Pops a directory from its own deque (or steals one when idle)
+//   2. Reads all entries in that directory
+//   3. Pushes subdirectories onto its own deque (others may steal them)
+//   4. Records regular files in the node table
+static void* task_queue_0_worker(void *arg) {
+    ThreadArgs *args = (ThreadArgs *)arg;   // Cast void* to ThreadArgs*
+    int tid = args->thread_id;              // This thread's ID
+    int idle_spins = 0;                     // Consecutive failed steal rounds
+
+    // Files found in the current directory, not yet handed to the prefetcher
+    int32_t prefetch_ids[PREFETCH_BATCH];
+    int prefetch_count = 0;
+
+    // Per-thread getdents64 batch buffer
+    char *dirent_buf = malloc(DIRENT_BUF_SIZE);
+    if (!dirent_buf) {
+        fprintf(stderr, "ERROR: Out of memory for directory buffer\n");
+        return NULL;
+    }
+
+    // ------ Main worker loop ------
+    while(1) {
+        // = Get a directory: own deque first, then steal =
+        char *dir_path = pop_dir(tid);
+        int stolen = 0;
+        if (!dir_path) {
+            dir_path = steal_dir(tid);
+            stolen = (dir_path != NULL);
+        }
+        if (!dir_path) {
+            // Nothing queued anywhere: done once nothing is being processed
+            if (__atomic_load_n(&pending_dirs, __ATOMIC_ACQUIRE) == 0) {
+                if (DEBUG) {
+                    printf("[%d] T-0 FINISHED (no pending directories)\n", tid);
+                }
+                break;  // Exit worker loop
+            }
+
+            // Another thread is still reading a directory - back off briefly
+            if (++idle_spins < 64) {
+                sched_yield();
+            } else {
+                struct timespec pause = {0, 50 * 1000};    // 50us
+                nanosleep(&pause, NULL);
+            }
+            continue;
+        }
+        idle_spins = 0;
+
+        // = Successfully got a directory - process it =
+        LOG(LOG_LEVEL_EVENT, "[%d] T-0 DIR %s\n", tid, dir_path);
+        TRACE(tid, TRACE_DIR_BEGIN, stolen, 0);
+        int dir_files = 0, dir_subdirs = 0;
+
+        // = Open the directory (entries are then stat'ed relative to dir_fd) =
+        int dir_fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd == -1) {
+            perror("open directory");  // Permission denied or doesn't exist
+            finish_dir(dir_path);
+            continue;           // Skip this directory
+        }
+
+        // Entry paths are built in place: "files/sub/" + name, no re-copying the prefix
+        size_t dir_len = strlen(dir_path);
+        if (dir_len >= PATH_MAX) {
+            fprintf(stderr, "ERROR: Path too long: %s\n", dir_path);
+            close(dir_fd);
+            finish_dir(dir_path);
+            continue;
+        }
+        char full_path[PATH_MAX];
+        memcpy(full_path, dir_path, dir_len);
+
+        // Sharded discovery: only the subtrees at SHARD_SPLIT_DEPTH that hash
+        // to this shard are walked; above them every shard walks every
+        // directory, but only records the files of those hashed to it
+        int depth = 0;
+        for (size_t i = strlen(CRAWL_ROOT); i < dir_len; i++) {
+            depth += (dir_path[i] == '/');
+        }
+        int own_files = (SHARD_ROLE != SHARD_DISCOVER) || depth >= SHARD_SPLIT_DEPTH ||
+                        (int)(hash_name(dir_path, dir_len) % SHARD_COUNT) == SHARD_INDEX;
+        int split_here = (SHARD_ROLE == SHARD_DISCOVER) && depth + 1 == SHARD_SPLIT_DEPTH;
+
+        // = Read entries in large getdents64 batches =
+        int failed = 0;
+        long nread;
+        while ((nread = syscall(SYS_getdents64, dir_fd, dirent_buf, DIRENT_BUF_SIZE)) > 0) {
+            for (long pos = 0; pos < nread; ) {
+                struct linux_dirent64 *entry = (struct linux_dirent64 *)(dirent_buf + pos);
+                pos += entry->d_reclen;
+
+                // Skip current and parent directory entries
+                const char *name = entry->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                    continue;
+                }
+                size_t name_len = strlen(name);
+
+                // = Check if entry is directory or file =
+                // Trust d_type; only stat when the filesystem doesn't report it
+                // (DT_UNKNOWN) or it is a symlink (stat() used to follow those)
+                unsigned char type = entry->d_type;
+                struct stat statbuf;
+                int have_stat = 0;
+                if (type == DT_UNKNOWN || type == DT_LNK) {
+                    if (fstatat(dir_fd, name, &statbuf, 0) == -1) {
+                        perror("fstatat");
+                        continue;  // Can't stat - skip
+                    }
+                    have_stat = 1;
+                    type = S_ISDIR(statbuf.st_mode) ? DT_DIR
+                         : S_ISREG(statbuf.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+
+                // = Handle subdirectories =
+                if (type == DT_DIR) {
+                    // Add trailing slash: "files/subdir" -> "files/subdir/"
+                    if (path_append(full_path, PATH_MAX, dir_len, name, name_len, 1) == -1) {
+                        continue;  // Path too long
+                    }
+                    if (split_here && (int)(hash_name(full_path, dir_len + name_len + 1) %
+                                            SHARD_COUNT) != SHARD_INDEX) {
+                        continue;  // Another shard's subtree
+                    }
+
+                    // Push for processing (this or a stealing thread will handle it)
+                    if (push_dir(tid, full_path) == 0) {
+                        LOG(LOG_LEVEL_EVENT, "[%d] T-0 ENQUEUE %s\n", tid, full_path);
+                        dir_subdirs++;
+                    }
+                }
+                // = Handle regular files =
+                else if (type == DT_REG && own_files) {
+                    // Build full path: "files/" + "A.txt" = "files/A.txt"
+                    if (path_append(full_path, PATH_MAX, dir_len, name, name_len, 0) == -1) {
+                        continue;  // Path too long - skip
+                    }
+                    LOG(LOG_LEVEL_EVENT, "[%d] T-0 FILE %s\n", tid, full_path);
+
+                    // Size is the scan cost estimate (see build_scan_order);
+                    // the inode is hot here, so this stat is cheap
+                    if (!have_stat && fstatat(dir_fd, name, &statbuf, AT_SYMLINK_NOFOLLOW) == -1) {
+                        perror("fstatat");
+                        continue;  // Can't stat - skip
+                    }
+
+                    // = Add to the node table (thread-safe, duplicates ignored) =
+                    int inserted;
+                    int idx = intern_file(full_path, name_len, &inserted);
+                    if (idx == -1) {
+                        failed = 1;
+                        break;
+                    }
+                    if (inserted) {
+                        FileLink *fl = file_link(idx);
+                        fl->size = statbuf.st_size;
+                        fl->mtime_ns = (int64_t)statbuf.st_mtim.tv_sec * 1000000000
+                                     + statbuf.st_mtim.tv_nsec;
+                        if (PREFETCH_BUDGET > 0) {
+                            prefetch_ids[prefetch_count++] = idx;
+                            if (prefetch_count == PREFETCH_BATCH) {
+                                prefetch_push(prefetch_ids, prefetch_count);
+                                prefetch_count = 0;
+                            }
+                        }
+                    }
+                    TRACE(tid, TRACE_FILE, idx, inserted);
+                    dir_files++;
+                }
+                // SPEC: Assume no special files (pipes, sockets, etc.)
+            }
+            if (failed) break;
+        }
+        if (nread == -1) {
+            perror("getdents64");
+        }
+        close(dir_fd);
+        if (prefetch_count > 0) {
+            prefetch_push(prefetch_ids, prefetch_count);
+            prefetch_count = 0;
+        }
+        finish_dir(dir_path);
+        TRACE(tid, TRACE_DIR_END, dir_files, dir_subdirs);
+        if (failed) {
+            free(dirent_buf);
+            return NULL;
+        }
+    }
+
+    if (DEBUG) {
+        printf("[%d] T-0 Thread exiting\n", tid);
+    }
+
+    if (trace_fd != -1) trace_flush(tid);
+    free(dirent_buf);
+    return NULL;
+}
+
+// ============================================================================
+// LINK FILE LINES
+// ============================================================================
+
+// Append fl's output line (path|name|[inlinks]|[outlinks]) to worker tid's
+// current block, handing the block to the writer thread once it is full
+static void emit_link_line(int tid, OutBlock **block, OutBlock **spare, const FileLink *fl,
+                           const int32_t *inlinks, int32_t inlink_count,
+                           const int32_t *outlinks, int32_t outlink_count) {
+    // A line that would overflow the block goes to the next one, so pool
+    // blocks never grow (only a line longer than a whole block does that)
+    size_t line_len = strlen(fl->path) + strlen(fl->name) + 9 +   // "|" "|[" "]|[" "]\n"
+                      names_length(inlinks, inlink_count) +
+                      names_length(outlinks, outlink_count);
+    if (*block && (*block)->buf.len > 0 && (*block)->buf.len + line_len > (*block)->buf.cap) {
+        TRACE(tid, TRACE_WRITE, (int32_t)(*block)->buf.len, 0);
+        writer_submit(*block);
+        *block = NULL;
+    }
+    if (!*block) {
+        *block = writer_get_block(tid, spare);
+    }
+
+    // Build output line: path|name|[inlinks]|[outlinks]
+    OutBuf *write_buffer = &(*block)->buf;
+    if (outbuf_append(write_buffer, fl->path, strlen(fl->path)) != 0 ||
+        outbuf_append(write_buffer, "|", 1) != 0 ||
+        outbuf_append(write_buffer, fl->name, strlen(fl->name)) != 0 ||
+        outbuf_append(write_buffer, "|[", 2) != 0 ||
+        outbuf_append_names(write_buffer, inlinks, inlink_count) != 0 ||
+        outbuf_append(write_buffer, "]|[", 3) != 0 ||
+        outbuf_append_names(write_buffer, outlinks, outlink_count) != 0 ||
+        outbuf_append(write_buffer, "]\n", 2) != 0) {
+        fprintf(stderr, "ERROR: Out of memory building output\n");
+        exit(1);
+    }
+
+    // ==================================================================
+    //  Hand a full block to the writer thread (no lock, no I/O here)
+    // ==================================================================
+    if (write_buffer->len >= OUTPUT_BLOCK_SIZE) {
+        TRACE(tid, TRACE_WRITE, (int32_t)write_buffer->len, 0);
+        writer_submit(*block);
+        *block = NULL;
+    }
+}
+
+// Submit worker tid's last partial block (spare blocks stay in the pool,
+// which writer_finish releases)
+static void finish_link_lines(int tid, OutBlock *block) {
+    if (block && block->buf.len > 0) {
+        TRACE(tid, TRACE_WRITE, (int32_t)block->buf.len, 0);
+        writer_submit(block);
+    }
+}
+
+// Phases 2-4 of a crawl that spilled: write the lines of node ranges taken
+// from the work queue, each node's links pulled off the merged runs
+static void write_spilled_links(int tid) {
+    SpillMerge outs = {0}, ins = {0};
+    IdVector outlinks = {0}, inlinks = {0};
+    OutBlock *out_block = NULL;
+    OutBlock *spare_blocks = NULL;
+    if (spill_merge_open(&outs, 0) != 0 || spill_merge_open(&ins, 1) != 0) {
+        fprintf(stderr, "ERROR: Out of memory merging spilled edges\n");
+        exit(1);
+    }
+
+    // Every range seeks every run, so ranges are few and large
+    int chunk = file_link_count / (NUM_THREADS * SPILL_CHUNKS_PER_THREAD);
+    if (chunk < CHUNK_SIZE) chunk = CHUNK_SIZE;
+    int start_idx;
+    while (get_next_work_chunk(&work_queue.next_file_idx, &start_idx, chunk) == 0) {
+        int end_idx = start_idx + chunk;
+        if (end_idx > file_link_count) {
+            end_idx = file_link_count;
+        }
+        if (spill_merge_seek(&outs, start_idx) != 0 || spill_merge_seek(&ins, start_idx) != 0) {
+            fprintf(stderr, "ERROR: Could not merge spilled edges\n");
+            exit(1);
+        }
+        for (int file_idx = start_idx; file_idx < end_idx; file_idx++) {
+            if (spill_merge_collect(&ins, file_idx, &inlinks) != 0 ||
+                spill_merge_collect(&outs, file_idx, &outlinks) != 0) {
+                fprintf(stderr, "ERROR: Could not merge spilled edges\n");
+                exit(1);
+            }
+            emit_link_line(tid, &out_block, &spare_blocks, file_link(file_idx),
+                           inlinks.ids, inlinks.count, outlinks.ids, outlinks.count);
+        }
+    }
+
+    finish_link_lines(tid, out_block);
+    spill_merge_free(&outs);
+    spill_merge_free(&ins);
+    free(outlinks.ids);
+    free(inlinks.ids);
+}
+
+// ============================================================================
+//  TASK QUEUE 1 WORKER: FIND INLINKS AND OUTLINKS
+// ============================================================================
+// SPEC Section 3.1.4 - Find inlinks/outlinks (grep -F semantics, in-process)
+//
+// OPTIMIZATIONS IMPLEMENTED:
+//   1. Dynamic work queue (better load balancing than file_idx % NUM_THREADS)
+//   2. Chunk-based processing (reduces context switching overhead)
+//   3. Output lines batched into 1 MiB blocks for the writer thread (no lock)
+//   4. Every file is scanned once by the shared LinkMatcher (which yields its
+//      outlinks); inlinks are derived by transposing those edge vectors
+//   5. Edge vectors live in this thread's arena; no per-file link limits
+static void* task_queue_1_worker(void *arg) {
+    ThreadArgs *args = (ThreadArgs *)arg;
+    int tid = args->thread_id;
+    Arena *arena = &edge_arenas[tid];   // This thread's edge vector arena
+    Arena *scan_arena = spill_buffers ? NULL : arena;  // --mem-mb: outlinks go to the edge buffer
+    IdVector scratch = {0};             // Reused for every file's edge list
+    
+    //  Blocks for batched writes (see ASYNC OUTPUT WRITER)
+    OutBlock *out_block = NULL;         // Block being filled
+    OutBlock *spare_blocks = NULL;      // Written blocks ready for reuse
+
+    // ======================================================================
+    // PHASE 1: Scan each file once for every known filename (outlinks)
+    // ======================================================================
+    int *seen = malloc((file_link_count > 0 ? file_link_count : 1) * sizeof(int));
+    if (!seen) {
+        fprintf(stderr, "ERROR: Out of memory for scan state\n");
+        exit(1);
+    }
+    memset(seen, 0xff, (file_link_count > 0 ? file_link_count : 1) * sizeof(int));  // -1 = never seen
+
+    // Small files go through this thread's read ring (see IO_URING READ ENGINE)
+    ReadRing ring;
+    // (--incremental mostly skips reading, so it keeps the blocking path)
+    if (read_ring_init(&ring, INCREMENTAL ? 0 : QUEUE_DEPTH) != 0 &&
+        !INCREMENTAL && QUEUE_DEPTH > 0 && tid == 0) {
+        fprintf(stderr, "Warning: io_uring unavailable, using blocking reads\n");
+    }
+
+    // Largest files first, in cost-sized chunks (see SCAN SCHEDULING)
+    int scan_pos, scan_end;
+    while (get_next_scan_chunk(&scan_pos, &scan_end) == 0) {
+        for (int k = scan_pos; k < scan_end; k++) {
+            int file_idx = scan_order[k];
+            TRACE(tid, TRACE_SCAN_BEGIN, file_idx, 0);
+
+            // = Small file: queue its read, scanning a finished one if the ring is full =
+            if (ring.ring_fd != -1 && file_link(file_idx)->size <= READ_RING_MAX_FILE) {
+                if (ring.in_flight == ring.depth) {
+                    scan_next_ring_read(&ring, tid, seen, &scratch, scan_arena);
+                }
+                if (read_ring_queue(&ring, file_idx) == 0) {
+                    continue;   // Scanned once its read completes
+                }
+            }
+
+            // On error the file simply has no outlinks
+            if (INCREMENTAL) {
+                recrawl_file(file_idx, seen, &scratch, arena);
+            } else {
+                scan_file_dedup(&link_matcher, file_idx, seen, &scratch, scan_arena);
+            }
+            if (record_outlinks(tid, file_idx, &scratch) != 0) {
+                fprintf(stderr, "ERROR: Could not spill edges\n");
+                exit(1);
+            }
+            TRACE(tid, TRACE_SCAN_END, file_idx, file_link(file_idx)->outlink_count);
+        }
+    }
+    while (scan_next_ring_read(&ring, tid, seen, &scratch, scan_arena) == 0) {}
+    free_read_ring(&ring);
+    free(seen);
+    TRACE(tid, TRACE_PHASE, 1, 0);
+
+    // A scan shard only contributes outlinks; the coordinator does the rest
+    if (SHARD_ROLE == SHARD_SCAN) {
+        free(scratch.ids);
+        return NULL;
+    }
+
+    // --mem-mb: unpack the edge buffers or, if any spilled, merge the runs
+    if (spill_buffers) {
+        pthread_barrier_wait(&phase_barrier);   // spill_active is final
+        if (spill_finish(tid) != 0) {
+            fprintf(stderr, "ERROR: Could not spill edges\n");
+            exit(1);
+        }
+        if (__atomic_load_n(&spill_active, __ATOMIC_RELAXED)) {
+            pthread_barrier_wait(&phase_barrier);   // Every run is written
+            // (--binary: main streams the merge into the edge list instead)
+            if (!BINARY_OUTPUT) write_spilled_links(tid);
+            free(scratch.ids);
+            TRACE(tid, TRACE_PHASE, 4, 0);
+            if (trace_fd != -1) trace_flush(tid);
+            return NULL;
+        }
+    }
+
+    // Every inlink count must be final before vectors are sized
+    pthread_barrier_wait(&phase_barrier);
+
+    // ======================================================================
+    // PHASE 2: Size each inlink vector
+    // ======================================================================
+    int reserve_idx;
+    while (get_next_work_chunk(&work_queue.next_reserve_idx, &reserve_idx,
+                               TRANSPOSE_CHUNK_SIZE) == 0) {
+        int reserve_end = reserve_idx + TRANSPOSE_CHUNK_SIZE;
+        if (reserve_end > file_link_count) {
+            reserve_end = file_link_count;
+        }
+        for (int file_idx = reserve_idx; file_idx < reserve_end; file_idx++) {
+            if (reserve_inlinks(file_idx, arena) != 0) {
+                fprintf(stderr, "ERROR: Out of memory storing inlinks\n");
+                exit(1);
+            }
+        }
+    }
+    TRACE(tid, TRACE_PHASE, 2, 0);
+    pthread_barrier_wait(&phase_barrier);
+
+    // ======================================================================
+    // PHASE 3: Transpose outlinks into the inlink vectors
+    // ======================================================================
+    int scatter_idx;
+    while (get_next_work_chunk(&work_queue.next_scatter_idx, &scatter_idx,
+                               TRANSPOSE_CHUNK_SIZE) == 0) {
+        int scatter_end = scatter_idx + TRANSPOSE_CHUNK_SIZE;
+        if (scatter_end > file_link_count) {
+            scatter_end = file_link_count;
+        }
+        for (int file_idx = scatter_idx; file_idx < scatter_end; file_idx++) {
+            scatter_inlinks(file_idx);
+        }
+    }
+    TRACE(tid, TRACE_PHASE, 3, 0);
+    pthread_barrier_wait(&phase_barrier);
+
+    // ======================================================================
+    // PHASE 4: Sort inlinks and write results
+    // ======================================================================
+    // Main worker loop - grab chunks dynamically
+    while (1) {
+        int start_idx;
+        
+        //  Get next chunk of work (dynamic load balancing)
+        // Better than static partitioning (file_idx % NUM_THREADS)
+        if (get_next_work_chunk(&work_queue.next_file_idx, &start_idx, CHUNK_SIZE) == -1) {
+            break;  // No more work available
+        }
+        
+        int end_idx = start_idx + CHUNK_SIZE;
+        if (end_idx > file_link_count) {
+            end_idx = file_link_count;
+        }
+        
+        // = Process this chunk of files =
+        for (int file_idx = start_idx; file_idx < end_idx; file_idx++) {
+            FileLink *current_file = file_link(file_idx);
+            LOG(LOG_LEVEL_EVENT, "[%d] T-1 START %s\n", tid, current_file->name);
+
+            // =================================================================
+            // INLINKS: Which files mention THIS file? (filled by phase 3)
+            // =================================================================
+            // Ascending order, same as the outlinks
+            if (current_file->inlink_count > 1) {
+                qsort(current_file->inlinks, current_file->inlink_count,
+                      sizeof(int32_t), compare_id);
+            }
+            for (int i = 0; i < current_file->inlink_count; i++) {
+                LOG(LOG_LEVEL_EVENT, "[%d] T-1 INLINK %s %s\n",
+                    tid, current_file->name, file_link(current_file->inlinks[i])->name);
+                TRACE(tid, TRACE_INLINK, file_idx, current_file->inlinks[i]);
+            }
+
+            // OUTLINKS: already collected by phase 1 (current_file->outlinks)
+            
+            // Output final outlink count
+            LOG(LOG_LEVEL_EVENT, "[%d] T-1 %s %d\n",
+                tid, current_file->name, current_file->outlink_count);
+
+            // ==================================================================
+            //  Add to write buffer (batched writes)
+            // ==================================================================
+            // --binary: main writes every edge at the end instead
+            if (BINARY_OUTPUT) continue;
+            emit_link_line(tid, &out_block, &spare_blocks, current_file,
+                           current_file->inlinks, current_file->inlink_count,
+                           current_file->outlinks, current_file->outlink_count);
+        }
+    }
+
+    // Last partial block
+    finish_link_lines(tid, out_block);
+    free(scratch.ids);
+    
+    if (DEBUG) {
+        printf("[%d] T-1 Thread exiting\n", tid);
+    }
+    
+    TRACE(tid, TRACE_PHASE, 4, 0);
+    if (trace_fd != -1) trace_flush(tid);
+    return NULL;
+}
+
+// ============================================================================
+// SHARDED CRAWL
+// ============================================================================
+// --shards K splits the crawl over K processes, so no single process needs
+// every thread and file descriptor (and, later, so shards can run on other
+// hosts). Every file still has to be matched against every name, so:
+//   1. Discover: the coordinator picks SHARD_SPLIT_DEPTH, the shallowest
+//      depth with SHARD_SPLIT_DIRS directories per shard. K children walk
+//      files/ down to it, and each continues only into the subtrees there
+//      that hash to it (files above the split go by directory hash too).
+//      Each writes its files (size, mtime, path) to
+//      STRUCT_shard<i>of<K>_files.txt.
+//   2. Scan: K children load all K file lists in shard order, so they
+//      number the nodes the same way (a name found by two shards belongs to
+//      the lower one). Other shards' files are interned by name only, and
+//      only their own files are scanned; the outlinks are written as int32
+//      (src, dst) pairs to STRUCT_shard<i>of<K>_edges.bin.
+//   3. Merge: the coordinator loads the lists the same way, reads every
+//      shard's edges, and transposes/writes them like a normal crawl.
+// Any file may mention any name, so a scan shard still holds a node entry
+// and automaton states for every name in the tree; only paths and file
+// state are limited to its own files.
+// Intermediate files are removed once the merge has succeeded.
+
+// Directories directly under `dir` (a path with a trailing slash), appended
+// to *list. Returns 0 on success, -1 on failure
+static int list_subdirs(const char *dir, char ***list, int *count, int *cap) {
+    DIR *dp = opendir(dir);
+    if (!dp) {
+        perror(dir);
+        return -1;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dp)) != NULL) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s%s/", dir, name) >= (int)sizeof(path)) continue;
+        if (entry->d_type != DT_DIR) {
+            struct stat st;
+            if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK) continue;
+            if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+        }
+        if (*count == *cap) {
+            int grown_cap = *cap ? 2 * *cap : 64;
+            char **grown = realloc(*list, (size_t)grown_cap * sizeof(char *));
+            if (!grown) {
+                closedir(dp);
+                return -1;
+            }
+            *list = grown;
+            *cap = grown_cap;
+        }
+        if (!((*list)[*count] = strdup(path))) {
+            closedir(dp);
+            return -1;
+        }
+        (*count)++;
+    }
+    closedir(dp);
+    return 0;
+}
+
+// Coordinator: choose SHARD_SPLIT_DEPTH (at least 1: the root is walked by
+// every shard) by listing directories level by level
+// Returns 0 on success, -1 on failure
+static int choose_shard_split(void) {
+    char **level = malloc(sizeof(char *));
+    int level_count = 1, depth = 0, failed = 0;
+    if (!level || !(level[0] = strdup(CRAWL_ROOT))) {
+        free(level);
+        return -1;
+    }
+    while (1) {
+        char **next = NULL;
+        int next_count = 0, next_cap = 0;
+        for (int i = 0; i < level_count && !failed &&
+                        next_count < SHARD_SPLIT_DIRS * SHARD_COUNT; i++) {
+            failed = list_subdirs(level[i], &next, &next_count, &next_cap) != 0;
+        }
+        for (int i = 0; i < level_count; i++) free(level[i]);
+        free(level);
+        level = next;
+        level_count = next_count;
+        depth++;
+        if (failed || next_count == 0 || next_count >= SHARD_SPLIT_DIRS * SHARD_COUNT) break;
+    }
+    for (int i = 0; i < level_count; i++) free(level[i]);
+    free(level);
+    if (failed) return -1;
+    SHARD_SPLIT_DEPTH = (level_count == 0 && depth > 1) ? depth - 1 : depth;
+    return 0;
+}
+
+// Name of shard `shard`'s intermediate file with the given suffix
+static void shard_file_name(char *dest, size_t size, int shard, const char *suffix) {
+    snprintf(dest, size, "part-1-outputs/%s_shard%dof%d_%s",
+             DIR_STRUCTURE, shard, SHARD_COUNT, suffix);
+}
+
+// Discover step: write this shard's files. Returns 0 on success, -1 on failure
+static int write_shard_files(void) {
+    char filename[256];
+    shard_file_name(filename, sizeof(filename), SHARD_INDEX, "files.txt");
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        perror("fopen shard file list");
+        return -1;
+    }
+    for (int i = 0; i < file_link_count; i++) {
+        const FileLink *fl = file_link(i);
+        fprintf(fp, "%lld %lld %s\n", (long long)fl->size, (long long)fl->mtime_ns, fl->path);
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+// Intern every shard's files in shard order; this process's own shard
+// becomes the node range [scan_first, scan_end)
+// Returns 0 on success, -1 on failure
+static int load_shard_files(void) {
+    char line[PATH_MAX + 64];
+    for (int shard = 0; shard < SHARD_COUNT; shard++) {
+        char filename[256];
+        shard_file_name(filename, sizeof(filename), shard, "files.txt");
+        FILE *fp = fopen(filename, "r");
+        if (!fp) {
+            perror(filename);
+            return -1;
+        }
+        if (shard == SHARD_INDEX) scan_first = file_link_count;
+
+        while (fgets(line, sizeof(line), fp)) {
+            long long size, mtime;
+            int path_at;
+            size_t len = strlen(line);
+            if (len > 0 && line[len - 1] == '\n') line[--len] = '\0';
+            if (sscanf(line, "%lld %lld %n", &size, &mtime, &path_at) != 2) {
+                fprintf(stderr, "ERROR: Malformed shard file list %s\n", filename);
+                fclose(fp);
+                return -1;
+            }
+            const char *path = line + path_at;
+            const char *slash = strrchr(path, '/');
+            const char *name = slash ? slash + 1 : path;
+            // A scan shard never opens other shards' files: their names suffice
+            int foreign = (SHARD_ROLE == SHARD_SCAN && shard != SHARD_INDEX);
+            int inserted;
+            int idx = intern_file(foreign ? name : path, strlen(name), &inserted);
+            if (idx == -1) {
+                fclose(fp);
+                return -1;
+            }
+            if (inserted && !foreign) {
+                file_link(idx)->size = size;
+                file_link(idx)->mtime_ns = mtime;
+            }
+        }
+        fclose(fp);
+        if (shard == SHARD_INDEX) scan_end = file_link_count;
+    }
+    return 0;
+}
+
+// Scan step: write the outlinks of [scan_first, scan_end)
+// Returns 0 on success, -1 on failure
+static int write_shard_edges(void) {
+    char filename[256];
+    shard_file_name(filename, sizeof(filename), SHARD_INDEX, "edges.bin");
+    FILE *fp = fopen(filename, "wb");
+    if (!fp) {
+        perror("fopen shard edges");
+        return -1;
+    }
+    int64_t edge_count = 0;
+    for (int i = scan_first; i < scan_end; i++) {
+        edge_count += file_link(i)->outlink_count;
+    }
+    uint32_t header[4] = {SHARD_EDGES_MAGIC, SHARD_EDGES_VERSION,
+                          (uint32_t)file_link_count, (uint32_t)SHARD_INDEX};
+    int ok = fwrite(header, sizeof(header), 1, fp) == 1 &&
+             fwrite(&edge_count, sizeof(edge_count), 1, fp) == 1;
+    for (int i = scan_first; ok && i < scan_end; i++) {
+        const FileLink *fl = file_link(i);
+        for (int j = 0; ok && j < fl->outlink_count; j++) {
+            int32_t pair[2] = {i, fl->outlinks[j]};
+            ok = fwrite(pair, sizeof(pair), 1, fp) == 1;
+        }
+    }
+    if (fclose(fp) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+// Merge step: give every file the outlinks its shard found (and count the
+// inlinks, as a scan would have). Returns 0 on success, -1 on failure
+static int load_shard_edges(Arena *arena) {
+    IdVector current = {0};
+    for (int shard = 0; shard < SHARD_COUNT; shard++) {
+        char filename[256];
+        shard_file_name(filename, sizeof(filename), shard, "edges.bin");
+        FILE *fp = fopen(filename, "rb");
+        if (!fp) {
+            perror(filename);
+            free(current.ids);
+            return -1;
+        }
+
+        uint32_t header[4];
+        int64_t edge_count;
+        if (fread(header, sizeof(header), 1, fp) != 1 ||
+            fread(&edge_count, sizeof(edge_count), 1, fp) != 1 ||
+            header[0] != SHARD_EDGES_MAGIC || header[1] != SHARD_EDGES_VERSION ||
+            header[2] != (uint32_t)file_link_count || header[3] != (uint32_t)shard) {
+            fprintf(stderr, "ERROR: %s does not match this crawl\n", filename);
+            fclose(fp);
+            free(current.ids);
+            return -1;
+        }
+
+        // Pairs are grouped by source: collect each run, then commit it
+        int src = -1;
+        for (int64_t e = 0; e <= edge_count; e++) {
+            int32_t pair[2] = {-1, -1};
+            if (e < edge_count && (fread(pair, sizeof(pair), 1, fp) != 1 ||
+                                   pair[0] < 0 || pair[0] >= file_link_count ||
+                                   pair[1] < 0 || pair[1] >= file_link_count)) {
+                fprintf(stderr, "ERROR: Corrupt shard edges in %s\n", filename);
+                fclose(fp);
+                free(current.ids);
+                return -1;
+            }
+            if (pair[0] != src && src != -1) {
+                FileLink *fl = file_link(src);
+                if (idvec_commit(&current, arena, &fl->outlinks, &fl->outlink_count) != 0) {
+                    fclose(fp);
+                    free(current.ids);
+                    return -1;
+                }
+                count_inlinks(src);
+                current.count = 0;
+            }
+            src = pair[0];
+            if (e < edge_count && idvec_push(&current, pair[1]) != 0) {
+                fclose(fp);
+                free(current.ids);
+                return -1;
+            }
+        }
+        fclose(fp);
+    }
+    free(current.ids);
+    return 0;
+}
+
+// Remove the intermediate files of every shard
+static void remove_shard_files(void) {
+    char filename[256];
+    for (int shard = 0; shard < SHARD_COUNT; shard++) {
+        shard_file_name(filename, sizeof(filename), shard, "files.txt");
+        unlink(filename);
+        shard_file_name(filename, sizeof(filename), shard, "edges.bin");
+        unlink(filename);
+    }
+}
+
+// ============================================================================
+// WATCH MODE
+// ============================================================================
+// --watch keeps the process running after the crawl and keeps the link
+// graph current from inotify events, so an edit shows up in seconds instead
+// of at the next crawl. Every directory under files/ is watched (new ones as
+// they appear). Events are collected until the tree has been quiet for
+// WATCH_SETTLE_MS (or WATCH_MAX_DELAY_MS has passed) and then applied as one
+// batch:
+//   - every path touched is looked at again. Vanished files go first: each
+//     removes its node and every edge into and out of it (the link file's
+//     node is kept as a tombstone). Then every regular file is (re)scanned
+//     with the full matcher, and a removed name found again comes back under
+//     its new path: a move is a removal plus a return. A removed name that no
+//     touched path has is looked for on disk (the crawl kept one copy of each
+//     name, and another may remain);
+//   - new names can be mentioned by files that did not change, so when a
+//     batch adds names, every other file is scanned for just those names
+//     (delta matcher), as an --incremental crawl does;
+//   - the scans run on NUM_THREADS threads; the differences against the
+//     stored outlinks are applied and reported in node order.
+// The link file stays the snapshot of the crawl; the changes since are
+// appended to STRUCT_N_events.txt, one tab-separated record per line:
+//   +N path / -N path       file added (or back) / removed
+//   +E src dst / -E src dst edge added / removed (filenames, as in the link file)
+//   C batch unix_ms         everything since the previous C is one update
+// Inlink vectors are not maintained after the crawl (they are the +E/-E
+// stream seen from the other end). If inotify's queue overflows, every known
+// and every present file is rechecked. fanotify would need CAP_SYS_ADMIN and
+// watches whole filesystems, so the per-directory inotify watches are used.
+
+// SIGINT/SIGTERM: leave the watch loop after the current batch
+static void watch_signal(int sig) {
+    (void)sig;
+    watch_stop = 1;
+}
+
+// CLOCK_MONOTONIC in milliseconds
+static int64_t monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Make room for per-node watch flags up to file_link_count
+// Returns 0 on success, -1 on allocation failure
+static int watch_grow_flags(void) {
+    if (file_link_count <= node_flag_cap) return 0;
+    int cap = node_flag_cap ? node_flag_cap : 1024;
+    while (cap < file_link_count) cap *= 2;
+    unsigned char *dead = realloc(node_dead, cap);
+    if (!dead) return -1;
+    node_dead = dead;
+    unsigned char *owned = realloc(node_owned, cap);
+    if (!owned) return -1;
+    node_owned = owned;
+    memset(node_dead + node_flag_cap, 0, cap - node_flag_cap);
+    memset(node_owned + node_flag_cap, 0, cap - node_flag_cap);
+    node_flag_cap = cap;
+    return 0;
+}
+
+// Add path (a copy) to a batch's change list. Returns 0 on success, -1 on failure
+static int watch_note(PathList *changes, const char *path) {
+    if (changes->count == changes->cap) {
+        int cap = changes->cap ? changes->cap * 2 : 256;
+        char **grown = realloc(changes->paths, (size_t)cap * sizeof(char *));
+        if (!grown) return -1;
+        changes->paths = grown;
+        changes->cap = cap;
+    }
+    if (!(changes->paths[changes->count] = strdup(path))) return -1;
+    changes->count++;
+    return 0;
+}
+
+// Note every live node whose path starts with `prefix` (a directory that
+// went away). Returns 0 on success, -1 on failure
+static int watch_note_under(PathList *changes, const char *prefix) {
+    size_t len = strlen(prefix);
+    for (int i = 0; i < file_link_count; i++) {
+        if (!node_dead[i] && strncmp(file_link(i)->path, prefix, len) == 0 &&
+            watch_note(changes, file_link(i)->path) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Watch the directory `dir` ("files/sub/") and everything below it, noting
+// the files found in `changes` (if not NULL): they may have been written
+// before their directory was watched
+// Returns 0 on success, -1 on allocation failure
+static int watch_add_tree(const char *dir, PathList *changes) {
+    int wd = inotify_add_watch(watch_fd, dir, IN_CREATE | IN_CLOSE_WRITE | IN_DELETE |
+                               IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+    if (wd == -1) {
+        if (errno != ENOENT && errno != ENOTDIR) perror("inotify_add_watch");
+        return 0;   // Gone again (or not watchable): nothing to follow
+    }
+    if (wd >= watch_dir_cap) {
+        int cap = watch_dir_cap ? watch_dir_cap : 256;
+        while (cap <= wd) cap *= 2;
+        char **grown = realloc(watch_dirs, (size_t)cap * sizeof(char *));
+        if (!grown) return -1;
+        memset(grown + watch_dir_cap, 0, (size_t)(cap - watch_dir_cap) * sizeof(char *));
+        watch_dirs = grown;
+        watch_dir_cap = cap;
+    }
+    free(watch_dirs[wd]);   // Same directory seen again, maybe under a new name
+    if (!(watch_dirs[wd] = strdup(dir))) return -1;
+
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+    char path[PATH_MAX];
+    size_t dir_len = strlen(dir);
+    memcpy(path, dir, dir_len);
+    struct dirent *entry;
+    int ret = 0;
+    while (ret == 0 && (entry = readdir(d))) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        unsigned char type = entry->d_type;
+        int is_dir = (type == DT_DIR);
+        if (path_append(path, PATH_MAX, dir_len, name, strlen(name), is_dir) == -1) continue;
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            // Symlinks are followed, as in Task Queue 0
+            struct stat statbuf;
+            if (stat(path, &statbuf) != 0) continue;
+            if (S_ISDIR(statbuf.st_mode)) {
+                path_append(path, PATH_MAX, dir_len, name, strlen(name), 1);
+                is_dir = 1;
+            }
+        }
+        if (is_dir) {
+            ret = watch_add_tree(path, changes);
+        } else if (changes) {
+            ret = watch_note(changes, path);
+        }
+    }
+    closedir(d);
+    return ret;
+}
+
+// Batch scan thread: run the watch jobs it takes off watch_next_job
+static void *watch_scan_worker(void *arg) {
+    (void)arg;
+    IdVector scratch = {0};
+    int *seen = malloc((file_link_count > 0 ? file_link_count : 1) * sizeof(int));
+    if (!seen) {
+        fprintf(stderr, "ERROR: Out of memory for scan state\n");
+        exit(1);
+    }
+    memset(seen, 0xff, (file_link_count > 0 ? file_link_count : 1) * sizeof(int));
+
+    int j;
+    while ((j = __atomic_fetch_add(&watch_next_job, 1, __ATOMIC_RELAXED)) < watch_job_count) {
+        WatchJob *job = &watch_jobs[j];
+        scratch.count = 0;
+        seen[job->idx] = job->idx;  // A file never links to itself
+        if (scan_file_contents(job->delta ? &delta_matcher : &link_matcher, job->idx,
+                               seen, &scratch, NULL) != 0) {
+            job->failed = 1;        // Gone again: the next batch removes it
+            continue;
+        }
+        if (scratch.count > 1) {
+            qsort(scratch.ids, scratch.count, sizeof(int32_t), compare_id);
+        }
+        job->found_count = scratch.count;
+        if (scratch.count > 0) {
+            job->found = malloc((size_t)scratch.count * sizeof(int32_t));
+            if (!job->found) {
+                fprintf(stderr, "ERROR: Out of memory scanning %s\n", file_link(job->idx)->path);
+                exit(1);
+            }
+            memcpy(job->found, scratch.ids, (size_t)scratch.count * sizeof(int32_t));
+        }
+    }
+    free(seen);
+    free(scratch.ids);
+    return NULL;
+}
+
+// Replace idx's outlinks with `ids` (malloc'd, owned from now on)
+static void watch_set_outlinks(int idx, int32_t *ids, int32_t count) {
+    FileLink *fl = file_link(idx);
+    if (node_owned[idx]) free(fl->outlinks);
+    fl->outlinks = ids;
+    fl->outlink_count = count;
+    node_owned[idx] = (ids != NULL);
+}
+
+// Build the matcher over the live nodes (or over `added` only, for the
+// delta matcher). Returns 0 on success, -1 on allocation failure
+static int watch_build_matcher(LinkMatcher *m, const IdVector *added) {
+    int *order = malloc((file_link_count > 0 ? file_link_count : 1) * sizeof(int));
+    if (!order) return -1;
+    int n = 0;
+    if (added) {
+        for (int i = 0; i < added->count; i++) order[n++] = added->ids[i];
+    } else {
+        for (int i = 0; i < file_link_count; i++) {
+            if (!node_dead[i]) order[n++] = i;
+        }
+    }
+    free_link_matcher(m);
+    return build_matcher_over(m, order, n);
+}
+
+// Take the regular file at path (filename `name`) into the graph: a new name
+// becomes a node, a removed one comes back under this path, and either (or
+// a changed file) is queued for a rescan. A name that is live under another
+// path stays with the file the crawl found first
+// Returns 0 on success, -1 on failure
+static int watch_take_file(const char *path, const char *name, const struct stat *st,
+                           IdVector *added, IdVector *rescan) {
+    int idx = find_file(name);
+    if (idx == -1) {
+        int inserted;
+        if ((idx = intern_file(path, strlen(name), &inserted)) == -1 ||
+            watch_grow_flags() != 0 || idvec_push(added, idx) != 0) {
+            return -1;
+        }
+    } else if (node_dead[idx]) {
+        FileLink *fl = file_link(idx);
+        if (strcmp(fl->path, path) != 0) {
+            char *copy = arena_strndup(&watch_paths, path, strlen(path));
+            if (!copy) return -1;
+            fl->path = copy;
+            fl->name = copy + (name - path);
+        }
+        node_dead[idx] = 0;
+        if (idvec_push(added, idx) != 0) return -1;
+    } else if (strcmp(file_link(idx)->path, path) != 0) {
+        return 0;
+    }
+    file_link(idx)->size = st->st_size;
+    file_link(idx)->mtime_ns = (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+    return idvec_push(rescan, idx);
+}
+
+// Note every file under `dir` whose name is a removed node's (the crawl kept
+// one copy of each name; another may still be there)
+// Returns 0 on success, -1 on allocation failure
+static int watch_find_removed(const char *dir, PathList *found) {
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+    char path[PATH_MAX];
+    size_t dir_len = strlen(dir);
+    memcpy(path, dir, dir_len);
+    struct dirent *entry;
+    int ret = 0;
+    while (ret == 0 && (entry = readdir(d))) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        unsigned char type = entry->d_type;
+        int is_dir = (type == DT_DIR);
+        if (path_append(path, PATH_MAX, dir_len, name, strlen(name), is_dir) == -1) continue;
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            struct stat statbuf;
+            if (stat(path, &statbuf) != 0) continue;
+            if (S_ISDIR(statbuf.st_mode)) {
+                path_append(path, PATH_MAX, dir_len, name, strlen(name), 1);
+                is_dir = 1;
+            }
+        }
+        if (is_dir) {
+            ret = watch_find_removed(path, found);
+        } else {
+            int idx = find_file(name);
+            if (idx != -1 && node_dead[idx]) ret = watch_note(found, path);
+        }
+    }
+    closedir(d);
+    return ret;
+}
+
+// qsort comparator: order change list paths
+static int compare_path(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Apply one batch of changed paths to the graph and report the differences
+// Returns 0 on success, -1 on failure
+static int watch_apply(PathList *changes, int batch) {
+    int64_t started = monotonic_ms();
+    IdVector rescan = {0}, added = {0}, removed = {0};
+    int64_t edges_added = 0, edges_removed = 0;
+    int ret = -1;
+
+    // = Removals first (each path once): a name that moved or still has
+    //   another copy comes back below, under its surviving path =
+    qsort(changes->paths, changes->count, sizeof(char *), compare_path);
+    for (int i = 0; i < changes->count; i++) {
+        const char *path = changes->paths[i];
+        if (i > 0 && strcmp(path, changes->paths[i - 1]) == 0) continue;
+        const char *slash = strrchr(path, '/');
+        int idx = find_file(slash ? slash + 1 : path);
+        struct stat statbuf;
+        if (idx != -1 && !node_dead[idx] && strcmp(file_link(idx)->path, path) == 0 &&
+            (stat(path, &statbuf) != 0 || !S_ISREG(statbuf.st_mode))) {
+            node_dead[idx] = 1;
+            if (idvec_push(&removed, idx) != 0) goto done;
+        }
+    }
+
+    // = Removed files: their outlinks, then every edge into them =
+    for (int i = 0; i < removed.count; i++) {
+        int x = removed.ids[i];
+        const FileLink *fl = file_link(x);
+        for (int j = 0; j < fl->outlink_count; j++) {
+            fprintf(watch_out, "-E\t%s\t%s\n", fl->name, file_link(fl->outlinks[j])->name);
+        }
+        edges_removed += fl->outlink_count;
+        watch_set_outlinks(x, NULL, 0);
+        fprintf(watch_out, "-N\t%s\n", fl->path);
+    }
+    for (int y = 0; removed.count > 0 && y < file_link_count; y++) {
+        FileLink *fl = file_link(y);
+        int32_t kept = 0;
+        for (int j = 0; j < fl->outlink_count; j++) {
+            int32_t target = fl->outlinks[j];
+            if (node_dead[target]) {
+                fprintf(watch_out, "-E\t%s\t%s\n", fl->name, file_link(target)->name);
+                edges_removed++;
+            } else {
+                fl->outlinks[kept++] = target;     // Compacted in place
+            }
+        }
+        fl->outlink_count = kept;
+    }
+
+    // = Files that are there: new, back (maybe moved) or changed =
+    for (int i = 0; i < changes->count; i++) {
+        const char *path = changes->paths[i];
+        if (i > 0 && strcmp(path, changes->paths[i - 1]) == 0) continue;
+        const char *slash = strrchr(path, '/');
+        struct stat statbuf;
+        if (stat(path, &statbuf) == 0 && S_ISREG(statbuf.st_mode) &&
+            watch_take_file(path, slash ? slash + 1 : path, &statbuf, &added, &rescan) != 0) {
+            goto done;
+        }
+    }
+
+    // = A removed name whose other copy did not change is still on disk =
+    int still_dead = 0;
+    for (int i = 0; i < removed.count; i++) {
+        still_dead += node_dead[removed.ids[i]];
+    }
+    if (still_dead > 0) {
+        PathList copies = {0};
+        int failed = watch_find_removed(CRAWL_ROOT, &copies) != 0;
+        for (int i = 0; !failed && i < copies.count; i++) {
+            const char *path = copies.paths[i];
+            struct stat statbuf;
+            failed = stat(path, &statbuf) == 0 && S_ISREG(statbuf.st_mode) &&
+                     watch_take_file(path, strrchr(path, '/') + 1, &statbuf, &added, &rescan) != 0;
+        }
+        for (int i = 0; i < copies.count; i++) free(copies.paths[i]);
+        free(copies.paths);
+        if (failed) goto done;
+    }
+    for (int i = 0; i < added.count; i++) {
+        fprintf(watch_out, "+N\t%s\n", file_link(added.ids[i])->path);
+    }
+
+    // = Matchers: every live name; just the new ones for unchanged files =
+    if ((added.count > 0 || removed.count > 0) && watch_build_matcher(&link_matcher, NULL) != 0) {
+        goto done;
+    }
+    if (added.count > 0 && watch_build_matcher(&delta_matcher, &added) != 0) {
+        goto done;
+    }
+
+    // = Jobs in node order: changed files, then (new names) everyone else =
+    unsigned char *changed = calloc(file_link_count > 0 ? file_link_count : 1, 1);
+    watch_jobs = calloc((size_t)(file_link_count > 0 ? file_link_count : 1), sizeof(WatchJob));
+    if (!changed || !watch_jobs) {
+        free(changed);
+        goto done;
+    }
+    for (int i = 0; i < rescan.count; i++) changed[rescan.ids[i]] = 1;
+    watch_job_count = 0;
+    for (int i = 0; i < file_link_count; i++) {
+        if (node_dead[i] || (!changed[i] && added.count == 0)) continue;
+        watch_jobs[watch_job_count].idx = i;
+        watch_jobs[watch_job_count].delta = !changed[i];
+        watch_job_count++;
+    }
+    free(changed);
+
+    // = Scan on NUM_THREADS threads =
+    watch_next_job = 0;
+    {
+        pthread_t threads[NUM_THREADS];
+        int started_threads = 0;
+        for (; started_threads < NUM_THREADS; started_threads++) {
+            if (pthread_create(&threads[started_threads], NULL, watch_scan_worker, NULL) != 0) {
+                perror("pthread_create");
+                break;
+            }
+        }
+        if (started_threads == 0) watch_scan_worker(NULL);
+        for (int i = 0; i < started_threads; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // = Apply and report the differences =
+    for (int j = 0; j < watch_job_count; j++) {
+        WatchJob *job = &watch_jobs[j];
+        if (job->failed) continue;
+        const FileLink *fl = file_link(job->idx);
+        const int32_t *old = fl->outlinks;
+        int32_t old_count = fl->outlink_count;
+
+        if (!job->delta) {
+            // Rescanned: the new matches replace the old outlinks
+            int32_t a = 0, b = 0;
+            while (a < old_count || b < job->found_count) {
+                if (b == job->found_count || (a < old_count && old[a] < job->found[b])) {
+                    fprintf(watch_out, "-E\t%s\t%s\n", fl->name, file_link(old[a++])->name);
+                    edges_removed++;
+                } else if (a == old_count || job->found[b] < old[a]) {
+                    fprintf(watch_out, "+E\t%s\t%s\n", fl->name, file_link(job->found[b++])->name);
+                    edges_added++;
+                } else {
+                    a++;
+                    b++;
+                }
+            }
+            watch_set_outlinks(job->idx, job->found, job->found_count);
+            job->found = NULL;
+        } else if (job->found_count > 0) {
+            // Unchanged: the new names it mentions join its outlinks
+            int32_t *merged = malloc((size_t)(old_count + job->found_count) * sizeof(int32_t));
+            if (!merged) goto done;
+            int32_t a = 0, b = 0, n = 0;
+            while (a < old_count || b < job->found_count) {
+                if (b == job->found_count || (a < old_count && old[a] < job->found[b])) {
+                    merged[n++] = old[a++];
+                } else {
+                    fprintf(watch_out, "+E\t%s\t%s\n", fl->name, file_link(job->found[b])->name);
+                    edges_added++;
+                    merged[n++] = job->found[b++];
+                }
+            }
+            watch_set_outlinks(job->idx, merged, n);
+        }
+    }
+
+    // = Commit the batch =
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    fprintf(watch_out, "C\t%d\t%lld\n", batch,
+            (long long)wall.tv_sec * 1000 + wall.tv_nsec / 1000000);
+    if (fflush(watch_out) != 0) {
+        perror("write events");
+        goto done;
+    }
+    printf("[watch] batch %d: %d rescanned, %d added, %d removed, +%lld/-%lld edges (%lld ms)\n",
+           batch, rescan.count, added.count, removed.count, (long long)edges_added,
+           (long long)edges_removed, (long long)(monotonic_ms() - started));
+    fflush(stdout);
+    ret = 0;
+
+done:
+    for (int j = 0; watch_jobs && j < watch_job_count; j++) {
+        free(watch_jobs[j].found);
+    }
+    free(watch_jobs);
+    watch_jobs = NULL;
+    watch_job_count = 0;
+    free(rescan.ids);
+    free(added.ids);
+    free(removed.ids);
+    if (ret != 0) fprintf(stderr, "ERROR: Failed to apply watch batch %d\n", batch);
+    return ret;
+}
+
+// Follow files/ until SIGINT/SIGTERM, appending every change to the
+// events file. Returns 0 on a clean stop, -1 on failure
+static int run_watch(void) {
+    char events_name[256];
+    snprintf(events_name, sizeof(events_name), "part-1-outputs/%s_%d_events.txt",
+             DIR_STRUCTURE, NUM_THREADS);
+    watch_out = fopen(events_name, "a");
+    watch_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (!watch_out || watch_fd == -1) {
+        perror(watch_out ? "inotify_init1" : events_name);
+        return -1;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_signal;   // No SA_RESTART: poll() must return
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    PathList changes = {0};
+    int ret = -1;
+    if (watch_grow_flags() != 0 || watch_build_matcher(&link_matcher, NULL) != 0 ||
+        watch_add_tree(CRAWL_ROOT, NULL) != 0) {
+        goto done;
+    }
+    printf("\n=== WATCH MODE: following files/ (Ctrl-C to stop), events in %s ===\n",
+           events_name);
+    fflush(stdout);
+
+    char *buf = malloc(WATCH_EVENT_BUF);
+    if (!buf) goto done;
+    int batch = 0;
+    int64_t first_event = 0, last_event = 0;
+    while (!watch_stop) {
+        // = Wait for events, or for the pending batch to settle =
+        int timeout = -1;
+        if (changes.count > 0) {
+            int64_t now = monotonic_ms();
+            int64_t due = last_event + WATCH_SETTLE_MS;
+            if (due > first_event + WATCH_MAX_DELAY_MS) due = first_event + WATCH_MAX_DELAY_MS;
+            timeout = (due > now) ? (int)(due - now) : 0;
+        }
+        struct pollfd pfd = {watch_fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, timeout);
+        if (ready == -1 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        // = Collect the changed paths =
+        ssize_t len;
+        while (ready > 0 && (len = read(watch_fd, buf, WATCH_EVENT_BUF)) > 0) {
+            for (char *p = buf; p < buf + len; ) {
+                const struct inotify_event *ev = (const struct inotify_event *)p;
+                p += sizeof(struct inotify_event) + ev->len;
+                const char *dir = (ev->wd >= 0 && ev->wd < watch_dir_cap) ? watch_dirs[ev->wd] : NULL;
+                char path[PATH_MAX];
+                int failed = 0;
+
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    // Events were lost: recheck every known and every present file
+                    failed = watch_note_under(&changes, CRAWL_ROOT) != 0 ||
+                             watch_add_tree(CRAWL_ROOT, &changes) != 0;
+                } else if (ev->mask & IN_IGNORED) {
+                    if (dir) {
+                        free(watch_dirs[ev->wd]);
+                        watch_dirs[ev->wd] = NULL;
+                    }
+                } else if (dir && ev->len > 0 &&
+                           path_append(strcpy(path, dir), PATH_MAX, strlen(dir), ev->name,
+                                       strlen(ev->name), (ev->mask & IN_ISDIR) != 0) != -1) {
+                    if (!(ev->mask & IN_ISDIR)) {
+                        failed = watch_note(&changes, path) != 0;
+                    } else if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        failed = watch_add_tree(path, &changes) != 0;
+                    } else {
+                        failed = watch_note_under(&changes, path) != 0;
+                    }
+                }
+                if (failed) {
+                    fprintf(stderr, "ERROR: Out of memory following changes\n");
+                    goto done_buf;
+                }
+            }
+            last_event = monotonic_ms();
+            if (first_event == 0) first_event = last_event;
+        }
+
+        // = Apply the batch once it has settled =
+        int64_t now = monotonic_ms();
+        if (changes.count > 0 && (watch_stop || now >= last_event + WATCH_SETTLE_MS ||
+                                  now >= first_event + WATCH_MAX_DELAY_MS)) {
+            if (watch_apply(&changes, ++batch) != 0) goto done_buf;
+            for (int i = 0; i < changes.count; i++) free(changes.paths[i]);
+            changes.count = 0;
+            first_event = 0;
+        }
+    }
+    printf("[watch] stopped after %d batches\n", batch);
+    ret = 0;
+
+done_buf:
+    free(buf);
+done:
+    for (int i = 0; i < changes.count; i++) free(changes.paths[i]);
+    free(changes.paths);
+    for (int i = 0; i < watch_dir_cap; i++) free(watch_dirs[i]);
+    free(watch_dirs);
+    watch_dirs = NULL;
+    watch_dir_cap = 0;
+    for (int i = 0; i < file_link_count && i < node_flag_cap; i++) {
+        if (node_owned[i]) watch_set_outlinks(i, NULL, 0);
+    }
+    free(node_dead);
+    free(node_owned);
+    node_dead = node_owned = NULL;
+    node_flag_cap = 0;
+    free_link_matcher(&link_matcher);
+    free_link_matcher(&delta_matcher);
+    arena_free(&watch_paths);
+    if (watch_fd != -1) close(watch_fd);
+    watch_fd = -1;
+    if (watch_out && fclose(watch_out) != 0) ret = -1;
+    watch_out = NULL;
+    return ret;
+}
+
+// ============================================================================
+// CRAWL STEPS
+// ============================================================================
+
+// Task Queue 0: find every file under CRAWL_ROOT (into the node table)
+// Returns 0 on success, -1 on failure
+static int run_task_queue_0(void) {
+    // ========================================================================
+    // TASK QUEUE 0: DIRECTORY TRAVERSAL
+    // ========================================================================
+    // SPEC Section 3.1.5 - Find all files in directory tree
+    if (!QUIET) printf("=== TASK QUEUE 0: Finding all files ===\n");
+    
+    // Initialize deques and filename index
+    dir_deques = malloc(NUM_THREADS * sizeof(WorkDeque));
+    if (!dir_deques) {
+        fprintf(stderr, "Error: Failed to allocate directory deques\n");
+        return -1;
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        init_deque(&dir_deques[i]);
+    }
+    init_name_index();
+    
+    // Readahead for files as they are found (see PREFETCHER)
+    if (PREFETCH_BUDGET > 0 && prefetch_start() != 0) {
+        PREFETCH_BUDGET = 0;
+    }
+
+    // Push root directory BEFORE spawning threads (thread 0 starts, others steal)
+    if (push_dir(0, CRAWL_ROOT) != 0) {
+        fprintf(stderr, "Error: Failed to enqueue %s directory\n", CRAWL_ROOT);
+        return -1;
+    }
+    
+    // Prepare thread arguments
+    pthread_t threads[NUM_THREADS];
+    ThreadArgs args[NUM_THREADS];
+    
+    // Create N threads for Task Queue 0
+    for (int i = 0; i < NUM_THREADS; i++) {
+        args[i].thread_id = i;
+        
+        if (pthread_create(&threads[i], NULL, task_queue_0_worker, &args[i]) != 0) {
+            perror("pthread_create");
+            return -1;
+        }
+    }
+    
+    // SPEC Section 3.1.5 - Main thread must block via pthread_join
+    // Wait for all Task Queue 0 threads to finish
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    for (int i = 0; i < NUM_THREADS; i++) {
+        free_deque(&dir_deques[i]);
+    }
+    free(dir_deques);
+    dir_deques = NULL;
+
+    if (!QUIET) {
+        printf("\n=== Task Queue 0 Complete ===\n");
+        printf("Found %d files\n\n", file_link_count);
+    }
+    
+    // Display all found files (if DEBUG mode)
+    if (DEBUG) {
+        printf("Files found:\n");
+        for (int i = 0; i < file_link_count; i++) {
+            printf("  [%d] %s (path: %s)\n", 
+                   i, file_link(i)->name, file_link(i)->path);
+        }
+    }
+
+    return 0;
+}
+
+// Task Queue 1: scan, transpose and write the links of the node table
+// Returns 0 on success, -1 on failure
+static int run_task_queue_1(void) {
+    // ========================================================================
+    // TASK QUEUE 1: INLINKS AND OUTLINKS
+    // ========================================================================
+    // SPEC Section 3.1.4 - Find inlinks/outlinks (in-process matcher)
+    if (!QUIET) printf("\n=== TASK QUEUE 1: Finding inlinks and outlinks ===\n");
+
+    // Build the filename automaton once; every thread shares it read-only
+    // (the merge step of a sharded crawl scans nothing)
+    if (SHARD_ROLE != SHARD_MERGE && build_link_matcher(&link_matcher) != 0) {
+        fprintf(stderr, "Error: Failed to build filename matcher\n");
+        return -1;
+    }
+
+    // Scanning takes over from the prefetcher
+    if (prefetch_running) {
+        prefetch_finish();
+        if (!QUIET) printf("Prefetched %d files (%lld KiB) during discovery\n",
+                           prefetched_files, (long long)(prefetched_bytes >> 10));
+    }
+
+    // Incremental mode: load the previous crawl and rewrite the link file
+    char manifest_name[256];
+    snprintf(manifest_name, sizeof(manifest_name), "part-1-outputs/%s_manifest.txt",
+             DIR_STRUCTURE);
+    if (INCREMENTAL) {
+        if (load_manifest(&manifest, manifest_name) != 0) {
+            fprintf(stderr, "Warning: Ignoring manifest, doing a full crawl\n");
+        }
+        if (prepare_incremental() != 0) {
+            fprintf(stderr, "Error: Failed to build delta matcher\n");
+            return -1;
+        }
+        printf("Manifest: %d files, %d new names\n", manifest.count, new_name_count);
+    }
+
+    // Text output: one writer thread owns the link file for the whole phase
+    // (incremental runs rewrite every line, so the file is truncated first)
+    if (!BINARY_OUTPUT && SHARD_ROLE != SHARD_SCAN) {
+        char output_name[256];
+        snprintf(output_name, sizeof(output_name), "part-1-outputs/%s_%d_file_links.txt",
+                 DIR_STRUCTURE, NUM_THREADS);
+        if (writer_start(output_name, INCREMENTAL) != 0) {
+            fprintf(stderr, "Error: Failed to start output writer for %s\n", output_name);
+            return -1;
+        }
+    }
+    
+    // Reset work queue for dynamic load balancing
+    // (a scan shard only scans its own files, the merge step none)
+    if (scan_end == -1) {
+        scan_end = (SHARD_ROLE == SHARD_MERGE) ? 0 : file_link_count;
+    }
+    if (build_scan_order(scan_first, scan_end) != 0) {
+        fprintf(stderr, "Error: Failed to allocate scan order\n");
+        return -1;
+    }
+    if (DEDUP && !INCREMENTAL && !MEMORY_BUDGET && scan_order_count > 0 && prepare_dedup() != 0) {
+        fprintf(stderr, "Error: Failed to allocate dedup table\n");
+        return -1;
+    }
+    work_queue.next_scan_idx = 0;
+    work_queue.next_reserve_idx = 0;
+    work_queue.next_scatter_idx = 0;
+    work_queue.next_file_idx = 0;
+    pthread_barrier_init(&phase_barrier, NULL, NUM_THREADS);
+
+    // One edge vector arena per thread (no locking on the hot path)
+    edge_arenas = calloc(NUM_THREADS, sizeof(Arena));
+    if (!edge_arenas) {
+        fprintf(stderr, "Error: Failed to allocate edge arenas\n");
+        return -1;
+    }
+
+    // Merge step: the shards' outlinks take the place of phase 1
+    if (SHARD_ROLE == SHARD_MERGE && load_shard_edges(&edge_arenas[0]) != 0) {
+        fprintf(stderr, "Error: Failed to merge shard edges\n");
+        return -1;
+    }
+
+    // --mem-mb: whatever the budget leaves becomes the edge buffers (sized
+    // last, so everything allocated above is already resident)
+    if (MEMORY_BUDGET > 0 && spill_start() != 0) {
+        fprintf(stderr, "Error: Failed to set up edge buffers\n");
+        return -1;
+    }
+    
+    // Create threads for Task Queue 1
+    pthread_t threads[NUM_THREADS];
+    ThreadArgs args[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        args[i].thread_id = i;
+        
+        if (pthread_create(&threads[i], NULL, task_queue_1_worker, &args[i]) != 0) {
+            perror("pthread_create");
+            return -1;
+        }
+    }
+    
+    // Wait for all Task Queue 1 threads to finish
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    pthread_barrier_destroy(&phase_barrier);
+    free_link_matcher(&link_matcher);
+    if (!BINARY_OUTPUT && SHARD_ROLE != SHARD_SCAN && writer_finish() != 0) {
+        fprintf(stderr, "Error: Failed to write the link file\n");
+        return -1;
+    }
+    free(scan_order);
+    scan_order = NULL;
+    if (dedup_twin) {
+        if (!QUIET) printf("Dedup: %d duplicate files copied, %lld KiB not rescanned\n",
+                           files_deduped, (long long)(dedup_bytes_saved >> 10));
+        free_dedup();
+    }
+    if (!QUIET) printf("\n=== Task Queue 1 Complete ===\n");
+
+    if (INCREMENTAL) {
+        printf("Incremental: %d reused, %d touched but unchanged, %d rescanned\n",
+               files_reused, files_touched, files_rescanned);
+        if (write_manifest(manifest_name) != 0) {
+            fprintf(stderr, "Warning: Could not write manifest %s\n", manifest_name);
+        }
+        free_link_matcher(&delta_matcher);
+        free_manifest(&manifest);
+    }
+    
+    return 0;
+}
+
+// Run one step in K child processes and wait for all of them
+// Returns 0 if every child succeeded, -1 otherwise
+static int run_shard_processes(int role) {
+    pid_t pids[MAX_SHARDS];
+    fflush(stdout);     // Children must not repeat buffered output
+    for (int shard = 0; shard < SHARD_COUNT; shard++) {
+        pids[shard] = fork();
+        if (pids[shard] == -1) {
+            perror("fork");
+            for (int i = 0; i < shard; i++) waitpid(pids[i], NULL, 0);
+            return -1;
+        }
+        if (pids[shard] == 0) {
+            // = Child: the usual crawl steps, restricted to this shard =
+            SHARD_INDEX = shard;
+            SHARD_ROLE = role;
+            if (!DEBUG && !freopen("/dev/null", "w", stdout)) _exit(1);
+            int failed;
+            if (role == SHARD_DISCOVER) {
+                failed = run_task_queue_0() != 0 || write_shard_files() != 0;
+                if (prefetch_running) prefetch_finish();
+            } else {
+                init_name_index();
+                failed = load_shard_files() != 0 || run_task_queue_1() != 0 ||
+                         write_shard_edges() != 0;
+            }
+            fflush(stdout);
+            _exit(failed ? 1 : 0);
+        }
+    }
+
+    int failed = 0;
+    for (int shard = 0; shard < SHARD_COUNT; shard++) {
+        int status;
+        if (waitpid(pids[shard], &status, 0) == -1 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "ERROR: Shard %d failed\n", shard);
+            failed = 1;
+        }
+    }
+    return failed ? -1 : 0;
+}
+
+// ============================================================================
+// CRAWLER LIBRARY
+// ============================================================================
+// crawl_dir() runs the same two task queues as the command line, minus the
+// link file: the node table and its outlinks are copied into a CrawlGraph
+// (one string table, CSR arrays) and released. Everything a crawl leaves
+// behind is reset first, so a process can crawl any number of times; calls
+// must not overlap (the crawler state is global).
+
+// Copy the node table and its outlinks into g
+// Returns 0 on success, -1 on failure
+static int copy_crawl_graph(CrawlGraph *g) {
+    int32_t n = file_link_count;
+    int64_t nnz = 0, strtab_bytes = 0;
+    for (int i = 0; i < n; i++) {
+        const FileLink *fl = file_link(i);
+        nnz += fl->outlink_count;
+        strtab_bytes += (int64_t)strlen(fl->path) + strlen(fl->name) + 2;
+    }
+    if (nnz > INT32_MAX) {
+        fprintf(stderr, "Error: %lld links do not fit a CSR\n", (long long)nnz);
+        return -1;
+    }
+
+    g->strtab = malloc((size_t)strtab_bytes + 1);
+    g->paths = malloc(((size_t)n + 1) * sizeof(char *));
+    g->names = malloc(((size_t)n + 1) * sizeof(char *));
+    g->row_ptr = malloc(((size_t)n + 1) * sizeof(int32_t));
+    g->col_idx = malloc(((size_t)nnz + 1) * sizeof(int32_t));
+    if (!g->strtab || !g->paths || !g->names || !g->row_ptr || !g->col_idx) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    g->n = n;
+    g->nnz = (int32_t)nnz;
+    g->strtab_bytes = strtab_bytes;
+
+    char *s = g->strtab;
+    g->row_ptr[0] = 0;
+    for (int i = 0; i < n; i++) {
+        const FileLink *fl = file_link(i);
+        size_t path_len = strlen(fl->path) + 1, name_len = strlen(fl->name) + 1;
+        g->paths[i] = memcpy(s, fl->path, path_len);
+        s += path_len;
+        g->names[i] = memcpy(s, fl->name, name_len);
+        s += name_len;
+        if (fl->outlink_count > 0) {
+            memcpy(g->col_idx + g->row_ptr[i], fl->outlinks,
+                   (size_t)fl->outlink_count * sizeof(int32_t));
+        }
+        g->row_ptr[i + 1] = g->row_ptr[i] + fl->outlink_count;
+    }
+    return 0;
+}
+
+// Release what a failed task queue left behind (a finished one has already
+// released all of it)
+static void release_crawl_state(void) {
+    if (writer_fd != -1) {
+        writer_finish();
+    }
+    free_link_matcher(&link_matcher);
+    free(scan_order);
+    scan_order = NULL;
+    free_dedup();
+    if (spill_buffers) {
+        free_spill();
+    }
+}
+
+// Crawl dir with num_threads threads into *g_out (see Crawler.h)
+int crawl_dir(const char *dir, int num_threads, CrawlGraph *g_out) {
+    memset(g_out, 0, sizeof(*g_out));
+    size_t dir_len = strlen(dir);
+    struct stat st;
+    if (num_threads < 1) {
+        fprintf(stderr, "Error: crawl_dir needs at least 1 thread\n");
+        return -1;
+    }
+    if (dir_len == 0 || dir_len + 2 > sizeof(CRAWL_ROOT) ||
+        stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "Error: '%s' is not a directory\n", dir);
+        return -1;
+    }
+    snprintf(CRAWL_ROOT, sizeof(CRAWL_ROOT), "%s%s", dir,
+             dir[dir_len - 1] == '/' ? "" : "/");
+
+    // Leftovers of a previous crawl (its tables were released at the end)
+    int binary_output = BINARY_OUTPUT, quiet = QUIET;   // Restored on return
+    NUM_THREADS = num_threads;
+    BINARY_OUTPUT = 1;          // No link file: the graph is returned instead
+    QUIET = 1;                  // Callers print their own progress
+    scan_first = 0;
+    scan_end = -1;
+    files_deduped = 0;
+    dedup_bytes_saved = 0;
+    prefetched_files = 0;
+    prefetched_bytes = 0;
+
+    int ret = -1;
+    if (run_task_queue_0() == 0 && run_task_queue_1() == 0) {
+        ret = copy_crawl_graph(g_out);
+    }
+    if (prefetch_running) {
+        prefetch_finish();      // Task Queue 0 failed before handing over
+    }
+    if (ret != 0) {
+        release_crawl_state();
+    }
+
+    // Release edge vectors and the node table
+    if (edge_arenas) {
+        for (int i = 0; i < NUM_THREADS; i++) {
+            arena_free(&edge_arenas[i]);
+        }
+        free(edge_arenas);
+        edge_arenas = NULL;
+    }
+    free_node_table();
+
+    if (ret != 0) {
+        crawl_graph_free(g_out);
+    }
+    BINARY_OUTPUT = binary_output;
+    QUIET = quiet;
+    return ret;
+}
+
+// Release a graph returned by crawl_dir()
+void crawl_graph_free(CrawlGraph *g) {
+    free(g->strtab);
+    free(g->paths);
+    free(g->names);
+    free(g->row_ptr);
+    free(g->col_idx);
+    memset(g, 0, sizeof(*g));
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+// Command line front end (multithreaded.c only forwards its arguments)
+int crawler_main(int argc, char *argv[]) {
+    // ========================================================================
+    // PARSE ARGUMENTS
+    // ========================================================================
+    // SPEC Section 3.1.1 - Command line arguments
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <NUM_THREADS> <DIR_STRUCTURE> [DEBUG] [--queue-depth Q] [--prefetch-mb MB] [--no-dedup] [--shards K] [--mem-mb MB] [--watch] [--incremental] [--binary] [--trace FILE]\n", argv[0]);
+        fprintf(stderr, "  NUM_THREADS: 1-10\n");
+        fprintf(stderr, "  DIR_STRUCTURE: connected, forest, full, random\n");
+        fprintf(stderr, "  DEBUG: TRUE or FALSE (optional, default FALSE)\n");
+        fprintf(stderr, "  --queue-depth Q: io_uring file reads in flight per thread (default %d, 0 = blocking reads)\n",
+                DEFAULT_QUEUE_DEPTH);
+        fprintf(stderr, "  --prefetch-mb MB: file contents prefetched during discovery (default %d, 0 = off)\n",
+                DEFAULT_PREFETCH_MB);
+        fprintf(stderr, "  --no-dedup: scan byte-identical files separately\n");
+        fprintf(stderr, "  --shards K: split the crawl over K processes (NUM_THREADS each) and merge\n");
+        fprintf(stderr, "  --mem-mb MB: stay within MB of memory, spilling edges to disk (no dedup)\n");
+        fprintf(stderr, "  --watch: keep running, streaming link changes to STRUCT_N_events.txt\n");
+        fprintf(stderr, "  --incremental: only rescan files changed since the last --incremental run\n");
+        fprintf(stderr, "  --binary: write STRUCT_N_file_links.bin (packed edge list) instead of .txt\n");
+        fprintf(stderr, "  --trace FILE: record per-thread binary events (decode with trace_decode.py)\n");
+        return 1;
+    }
+    
+    NUM_THREADS = atoi(argv[1]);
+    strcpy(DIR_STRUCTURE, argv[2]);
+    
+    const char *trace_path = NULL;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "TRUE") == 0) {
+            DEBUG = 1;
+        } else if (strcmp(argv[i], "FALSE") == 0) {
+            DEBUG = 0;
+        } else if (strcmp(argv[i], "--incremental") == 0) {
+            INCREMENTAL = 1;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            BINARY_OUTPUT = 1;
+        } else if (strcmp(argv[i], "--no-dedup") == 0) {
+            DEDUP = 0;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            WATCH = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--queue-depth") == 0 && i + 1 < argc) {
+            QUEUE_DEPTH = atoi(argv[++i]);
+            if (QUEUE_DEPTH < 0 || QUEUE_DEPTH > MAX_QUEUE_DEPTH) {
+                fprintf(stderr, "Error: --queue-depth must be 0-%d\n", MAX_QUEUE_DEPTH);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--prefetch-mb") == 0 && i + 1 < argc) {
+            int prefetch_mb = atoi(argv[++i]);
+            if (prefetch_mb < 0) {
+                fprintf(stderr, "Error: --prefetch-mb must not be negative\n");
+                return 1;
+            }
+            PREFETCH_BUDGET = (int64_t)prefetch_mb << 20;
+        } else if (strcmp(argv[i], "--mem-mb") == 0 && i + 1 < argc) {
+            int mem_mb = atoi(argv[++i]);
+            if (mem_mb < 1) {
+                fprintf(stderr, "Error: --mem-mb must be at least 1\n");
+                return 1;
+            }
+            MEMORY_BUDGET = (int64_t)mem_mb << 20;
+        } else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            SHARD_COUNT = atoi(argv[++i]);
+            if (SHARD_COUNT < 1 || SHARD_COUNT > MAX_SHARDS) {
+                fprintf(stderr, "Error: --shards must be 1-%d\n", MAX_SHARDS);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (SHARD_COUNT > 1 && (INCREMENTAL || trace_path)) {
+        fprintf(stderr, "Error: --shards cannot be combined with --incremental or --trace\n");
+        return 1;
+    }
+    if (MEMORY_BUDGET > 0 && (INCREMENTAL || SHARD_COUNT > 1)) {
+        fprintf(stderr, "Error: --mem-mb cannot be combined with --incremental or --shards\n");
+        return 1;
+    }
+    if (WATCH && (SHARD_COUNT > 1 || MEMORY_BUDGET > 0)) {
+        fprintf(stderr, "Error: --watch needs the whole graph in memory (no --shards or --mem-mb)\n");
+        return 1;
+    }
+    
+    printf("=== CS 140 Project 2 - Part 1 () ===\n");
+    printf("Threads: %d, Structure: %s, Debug: %s\n\n", 
+           NUM_THREADS, DIR_STRUCTURE, DEBUG ? "TRUE" : "FALSE");
+
+    // ========================================================================
+    // CREATE OUTPUT DIRECTORY
+    // ========================================================================
+    // SPEC Section 4.2 - Outputs must be in part-1-outputs/
+    struct stat st = {0};
+    if (stat("part-1-outputs", &st) == -1) {
+        if (mkdir("part-1-outputs", 0755) != 0) {
+            perror("mkdir part-1-outputs");
+            fprintf(stderr, "Warning: Could not create output directory\n");
+        }
+    }
+
+    // Optional binary event trace (see trace_event)
+    if (trace_path && trace_open(trace_path) != 0) {
+        fprintf(stderr, "Error: Could not open trace file %s\n", trace_path);
+        return 1;
+    }
+
+    // ========================================================================
+    // DISCOVERY AND LINKING
+    // ========================================================================
+    if (SHARD_COUNT > 1) {
+        // Children discover and scan; this process merges their results
+        printf("=== SHARDED CRAWL: %d processes ===\n", SHARD_COUNT);
+        if (choose_shard_split() != 0 ||
+            run_shard_processes(SHARD_DISCOVER) != 0 ||
+            run_shard_processes(SHARD_SCAN) != 0) {
+            return 1;
+        }
+        SHARD_ROLE = SHARD_MERGE;
+        init_name_index();
+        if (load_shard_files() != 0) {
+            return 1;
+        }
+        printf("Merged %d files from %d shards\n", file_link_count, SHARD_COUNT);
+    } else if (run_task_queue_0() != 0) {
+        return 1;
+    }
+    if (run_task_queue_1() != 0) {
+        return 1;
+    }
+    if (SHARD_COUNT > 1) {
+        remove_shard_files();
+    }
+
+    // Display results (if DEBUG mode; spilled links are only in the output)
+    if (DEBUG && !spill_active) {
+        printf("\nLink analysis results:\n");
+        for (int i = 0; i < file_link_count; i++) {
+            FileLink *fl = file_link(i);
+            printf("  %s:\n", fl->name);
+            
+            printf("    Inlinks (%d): [", fl->inlink_count);
+            for (int j = 0; j < fl->inlink_count; j++) {
+                printf("%s", file_link(fl->inlinks[j])->name);
+                if (j < fl->inlink_count - 1) printf(", ");
+            }
+            printf("]\n");
+
+            printf("    Outlinks (%d): [", fl->outlink_count);
+            for (int j = 0; j < fl->outlink_count; j++) {
+                printf("%s", file_link(fl->outlinks[j])->name);
+                if (j < fl->outlink_count - 1) printf(", ");
+            }
+            printf("]\n");
+        }
+    }
+    
+    // =========== OUTPUT FILE ============
+    char filename[256];
+    snprintf(filename, sizeof(filename), "part-1-outputs/%s_%d_file_links.%s", 
+             DIR_STRUCTURE, NUM_THREADS, BINARY_OUTPUT ? "bin" : "txt");
+    if (BINARY_OUTPUT && write_edge_list(filename) != 0) {
+        fprintf(stderr, "Error: Failed to write %s\n", filename);
+        return 1;
+    }
+    if (MEMORY_BUDGET > 0) {
+        printf("Memory: peak RSS %lld KiB (budget %lld MiB), %d runs spilled (%lld MiB)\n",
+               (long long)(peak_resident_bytes() >> 10), (long long)(MEMORY_BUDGET >> 20),
+               spill_run_count, (long long)((spilled_keys * 2 * (int64_t)sizeof(uint64_t)) >> 20));
+        free_spill();
+    }
+    printf("\n[SUCCESS] Output written to: %s\n", filename);
+    printf("\n=== Part 1 Complete ===\n");
+
+    // Keep the graph current until interrupted (see WATCH MODE)
+    if (WATCH && run_watch() != 0) {
+        return 1;
+    }
+
+    // Trace trailer needs the node table, so close it first
+    trace_close();
+
+    // Release edge vectors and the node table
+    for (int i = 0; i < NUM_THREADS; i++) {
+        arena_free(&edge_arenas[i]);
+    }
+    free(edge_arenas);
+    free_node_table();
+    
+    return 0;
+}
\ No newline at end of file
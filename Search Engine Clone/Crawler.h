@@ -0,0 +1,51 @@
+#ifndef CRAWLER_H
+#define CRAWLER_H
+
+#include <stdint.h>
+
+// Link graph found by a crawl, in CSR form (node i = row i)
+// paths[i] and names[i] point into strtab, which holds "path\0name\0" for
+// node 0, 1, ..., n-1 (the string table of the binary edge list).
+typedef struct CrawlGraph {
+    int32_t n;            // number of files (nodes)
+    int32_t nnz;          // number of links (edges)
+    char *strtab;         // paths and names of every node
+    int64_t strtab_bytes; // bytes used in strtab
+    const char **paths;   // length n, path of each node ("files/sub/A.txt")
+    const char **names;   // length n, filename of each node ("A.txt")
+    int32_t *row_ptr;     // length n+1, stores row start indices in col_idx
+    int32_t *col_idx;     // length nnz, files each node mentions (ascending per row)
+} CrawlGraph;
+
+/**
+ * Crawl a directory tree in this process and return its link graph.
+ * Same discovery and matching as `multithreaded`, but no link file is
+ * written: every file under dir is a node, and node i links to node j if
+ * file i mentions file j's name. May be called again for another crawl,
+ * also after a failure; crawler_main() output settings are left as they were.
+ *
+ * @param dir Directory to crawl (e.g., "files/"); the trailing slash is optional
+ * @param num_threads Worker threads for discovery and scanning (>= 1)
+ * @param g_out Pointer to graph structure to populate (will allocate memory)
+ * @return 0 on success, -1 on failure
+ */
+int crawl_dir(const char *dir, int num_threads, CrawlGraph *g_out);
+
+/**
+ * Free all dynamically allocated memory in a crawl graph.
+ *
+ * @param g Pointer to graph structure to free
+ */
+void crawl_graph_free(CrawlGraph *g);
+
+/**
+ * Command line front end of the crawler (`multithreaded <N> <STRUCT> ...`).
+ * Crawls files/ and writes part-1-outputs/STRUCT_N_file_links.txt (or .bin).
+ *
+ * @param argc Argument count, as passed to main()
+ * @param argv Argument vector, as passed to main()
+ * @return Process exit status (0 on success)
+ */
+int crawler_main(int argc, char *argv[]);
+
+#endif // CRAWLER_H
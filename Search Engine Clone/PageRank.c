@@ -28,19 +28,11 @@ static int file_exists(const char *path) {
 }
 
 static int32_t read_n_from_csr(const char *csr_path) {
-    FILE *fp = fopen(csr_path, "rb");
-    if (!fp) {
-        fprintf(stderr, "Failed to open CSR '%s': %s\n", csr_path, strerror(errno));
-        return -1;
-    }
-    int32_t n = -1, nnz = 0;
-    if (fread(&n, sizeof(int32_t), 1, fp) != 1 ||
-        fread(&nnz, sizeof(int32_t), 1, fp) != 1) {
+    int32_t n = -1;
+    if (csr_file_info(csr_path, &n, NULL) != 0) {
         fprintf(stderr, "Failed to read CSR header from '%s'\n", csr_path);
-        fclose(fp);
         return -1;
     }
-    fclose(fp);
     return n;
 }
 
@@ -316,6 +308,9 @@ int pagerank_run(const char *csr_path, int NPROC, int MAX_ITERS, double alpha) {
     int32_t n_total = read_n_from_csr(csr_path);
     if (n_total <= 0) return -1;
 
+    // Map workers only check the header of the file they map; check it all once
+    if (csr_verify(csr_path) != 0) return -1;
+
     if (!file_exists(rank_iter_path)) {
         if (write_uniform_rank(rank_iter_path, n_total) != 0) return -1;
     }
@@ -4,15 +4,24 @@
 #include <string.h>
 #include <stdint.h>
 #include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #include "CSR.h"
+#include "Crawler.h"
 #include "PageRank.h"
 
 #define LINE_LEN 4096
+#define BENCH_ITERS 5
 
 static const char *CSR_PATH   = "data/P_CSR.bin";
 static const char *NODES_PATH = "data/nodes.txt";
 static const char *RANK_PATH  = "data/pi/rank_iter.bin";
+static const char *PERM_PATH  = "data/perm.bin";
 
 static void trim_newline(char *s) {
     if (!s) return;
@@ -99,6 +108,129 @@ static int print_ranks(const char *nodes_path,
     return 0;
 }
 
+// CRAWL <dir> <threads>: crawl dir in this process and write the CSR + nodes
+// files straight from the in-memory graph (no link file, no Part 1 process)
+static int crawl_to_csr(char *args) {
+    char *space = strrchr(args, ' ');
+    int threads = space ? atoi(space + 1) : 0;
+    if (!space || space == args || threads <= 0) {
+        printf("Usage: CRAWL <dir> <threads>\n");
+        return -1;
+    }
+    *space = '\0';     // args is now the directory (it may contain spaces)
+
+    if (mkdir("data", 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "mkdir('data') failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    CrawlGraph graph;
+    if (crawl_dir(args, threads, &graph) != 0) {
+        fprintf(stderr, "Crawl of '%s' failed\n", args);
+        return -1;
+    }
+    int ret = csr_build_from_graph(&graph, CSR_PATH, NODES_PATH);
+    crawl_graph_free(&graph);
+    if (ret != 0) {
+        fprintf(stderr, "CSR build failed\n");
+    }
+    remove(PERM_PATH);     // a permutation of an earlier build
+    return ret;
+}
+
+// Hardware cache-miss counter for this process, or -1 (no PMU access, e.g.
+// perf_event_paranoid or a container)
+static int open_miss_counter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Time BENCH_ITERS full P * pi steps on the CSR at csr_path
+// *misses_out is cache misses per step, or -1 if there is no counter
+static int bench_ppi(const char *csr_path, double *ms_out, double *misses_out) {
+    CSR g;
+    if (load_full(csr_path, &g) != 0) return -1;
+
+    double *pi_in = (double *)malloc((size_t)g.n * sizeof(double));
+    double *pi_out = (double *)malloc((size_t)g.n * sizeof(double));
+    if (!pi_in || !pi_out) {
+        fprintf(stderr, "Out of memory for benchmark\n");
+        free(pi_in);
+        free(pi_out);
+        csr_free(&g);
+        return -1;
+    }
+    for (int32_t i = 0; i < g.n; i++) pi_in[i] = 1.0 / (double)g.n;
+
+    // One untimed step faults the mapping in
+    double dangling;
+    ppi_step_full(&g, pi_in, pi_out, &dangling);
+
+    int fd = open_miss_counter();
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int k = 0; k < BENCH_ITERS; k++) ppi_step_full(&g, pi_in, pi_out, &dangling);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    *misses_out = -1.0;
+    if (fd >= 0) {
+        long long misses;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &misses, sizeof(misses)) == (ssize_t)sizeof(misses)) {
+            *misses_out = (double)misses / BENCH_ITERS;
+        }
+        close(fd);
+    }
+    *ms_out = ((t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6) / BENCH_ITERS;
+
+    free(pi_in);
+    free(pi_out);
+    csr_free(&g);
+    return 0;
+}
+
+// PAGERANK REORDER DEGREE|RCM: renumber the CSR + nodes files for locality
+// and report the P * pi step before and after
+static int reorder_csr(const char *how) {
+    int order = strcmp(how, "DEGREE") == 0 ? CSR_ORDER_DEGREE
+              : strcmp(how, "RCM") == 0    ? CSR_ORDER_RCM
+              : 0;
+    if (!order) {
+        printf("Usage: PAGERANK REORDER DEGREE|RCM\n");
+        return -1;
+    }
+
+    double ms_before, ms_after, misses_before, misses_after;
+    if (bench_ppi(CSR_PATH, &ms_before, &misses_before) != 0) return -1;
+    if (csr_reorder(CSR_PATH, NODES_PATH, PERM_PATH, order) != 0) {
+        fprintf(stderr, "CSR reorder failed\n");
+        return -1;
+    }
+    // Ranks of earlier runs are in the old numbering
+    remove(RANK_PATH);
+    if (bench_ppi(CSR_PATH, &ms_after, &misses_after) != 0) return -1;
+
+    printf("P*pi step: %.3f ms -> %.3f ms\n", ms_before, ms_after);
+    if (misses_before >= 0 && misses_after >= 0) {
+        printf("Cache misses per step: %.0f -> %.0f\n", misses_before, misses_after);
+    } else {
+        printf("Cache misses per step: unavailable (no access to hardware counters)\n");
+    }
+    printf("Permutation (built id -> row): %s\n", PERM_PATH);
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     if (argc != 5 && argc != 6) {
         fprintf(stderr,
@@ -127,7 +259,7 @@ int main(int argc, char *argv[]) {
     char cmd[LINE_LEN];
 
     printf("SearchEngine ready\n");
-    printf("Commands: PAGERANK SETUP | PAGERANK RUN | QUIT\n");
+    printf("Commands: CRAWL <dir> <threads> | PAGERANK SETUP | PAGERANK REORDER DEGREE|RCM | PAGERANK COMPRESS | PAGERANK RUN | QUIT\n");
 
     while (1) {
         printf("> ");
@@ -138,6 +270,12 @@ int main(int argc, char *argv[]) {
             break;
         }
 
+        if (strncmp(cmd, "CRAWL ", 6) == 0) {
+            csr_ready = (crawl_to_csr(cmd + 6) == 0);
+            if (csr_ready) printf("CRAWL complete\n");
+            continue;
+        }
+
         if (strcmp(cmd, "PAGERANK SETUP") == 0) {
             printf("Path to STRUCT file (Enter = %s):\n", struct_path);
             printf("path> ");
@@ -162,14 +300,42 @@ int main(int argc, char *argv[]) {
                 continue;
             }
 
+            remove(PERM_PATH);     // a permutation of an earlier build
             csr_ready = 1;
             printf("SETUP complete\n");
             continue;
         }
 
+        if (strncmp(cmd, "PAGERANK REORDER", 16) == 0) {
+            if (!csr_ready) {
+                printf("Run PAGERANK SETUP or CRAWL first\n");
+                continue;
+            }
+
+            if (reorder_csr(cmd + 16 + strspn(cmd + 16, " ")) == 0) {
+                printf("REORDER complete\n");
+            }
+            continue;
+        }
+
+        if (strcmp(cmd, "PAGERANK COMPRESS") == 0) {
+            if (!csr_ready) {
+                printf("Run PAGERANK SETUP or CRAWL first\n");
+                continue;
+            }
+
+            if (csr_compress_file(CSR_PATH, CSR_PATH) != 0) {
+                fprintf(stderr, "CSR compression failed\n");
+                continue;
+            }
+
+            printf("COMPRESS complete\n");
+            continue;
+        }
+
         if (strcmp(cmd, "PAGERANK RUN") == 0) {
             if (!csr_ready) {
-                printf("Run PAGERANK SETUP first\n");
+                printf("Run PAGERANK SETUP or CRAWL first\n");
                 continue;
             }
 
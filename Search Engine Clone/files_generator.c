@@ -0,0 +1,616 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// CS 140 PROJECT 2 - NATIVE FILE GENERATOR
+// ============================================================================
+// Compiled counterpart of files_generator.sh for crawler / PageRank scaling
+// runs: same naming (file_XXX.EXT, dir_XXX) and the same four link structures
+// (forest, connected, full, random), but driven by target counts instead of
+// per-directory caps, and fast enough for millions of files.
+//
+// USAGE: ./files_generator <DIR_STRUCTURE> [options]
+//   --preset NAME     small | medium | large | huge (sets files/dirs/depth)
+//   --files N         Total number of files
+//   --dirs N          Total number of directories below files/
+//   --depth N         Maximum directory depth (files/ is depth 0)
+//   --outdegree D     Average number of links per file (not used by full)
+//   --size-dist DIST  fixed | uniform | exp | pareto (file size distribution)
+//   --mean-size B     Mean file size in bytes (links + filler text)
+//   --seed S          RNG seed; the same arguments always give the same tree
+//   --threads T       Writer threads (output does not depend on T)
+//
+// DETERMINISM:
+//   The tree shape comes from one seeded RNG; everything about file i (its
+//   extension, links and size) comes from an RNG seeded with (seed, i), so
+//   names can be recomputed instead of stored and threads can write files in
+//   any order without changing a single byte.
+//
+// Build: gcc -O2 -Wall -o files_generator files_generator.c -pthread -lm
+// ============================================================================
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+#define MAX_NAME 32                     // "file_XXXXXXXXX.ext" always fits
+#define MAX_GEN_THREADS 64              // Upper bound for --threads
+#define WRITE_BUFFER_SIZE (64 * 1024)   // Initial per-thread content buffer
+
+// ============================================================================
+// DATA STRUCTURES
+// ============================================================================
+
+typedef enum { STRUCT_FOREST, STRUCT_CONNECTED, STRUCT_FULL, STRUCT_RANDOM } Structure;
+typedef enum { SIZE_FIXED, SIZE_UNIFORM, SIZE_EXP, SIZE_PARETO } SizeDist;
+
+// GenConfig: Everything that determines the generated tree
+typedef struct {
+    Structure structure;
+    long files;             // Total files
+    long dirs;              // Directories below files/
+    int depth;              // Maximum directory depth
+    double outdegree;       // Average links per file
+    SizeDist size_dist;     // File size distribution
+    long mean_size;         // Mean file size in bytes
+    uint64_t seed;          // RNG seed
+    int threads;            // Writer threads
+} GenConfig;
+
+// Preset: Named scale for --preset
+typedef struct {
+    const char *name;
+    long files;
+    long dirs;
+    int depth;
+} Preset;
+
+// DirInfo: One generated directory; its files are [first_file, first_file + file_count)
+typedef struct {
+    char *path;             // "files/dir_000/dir_004"
+    int depth;              // files/ is 0
+    long first_file;        // Index of its first file
+    long file_count;        // Number of files it holds
+} DirInfo;
+
+// WorkerArgs: Arguments passed to each writer thread
+typedef struct {
+    int thread_id;          // Thread ID (0 to threads-1)
+} WorkerArgs;
+
+// ============================================================================
+// GLOBAL SHARED DATA
+// ============================================================================
+
+static const Preset PRESETS[] = {
+    {"small",      1000,    100,  4},
+    {"medium",   100000,   5000,  6},
+    {"large",   1000000,  20000,  8},
+    {"huge",   10000000, 100000, 10},
+};
+
+GenConfig config = {
+    STRUCT_RANDOM, 1000, 100, 4, 2.0, SIZE_FIXED, 0, 140, 4
+};
+
+DirInfo *dirs = NULL;       // dirs[0] is files/ itself
+long dir_count = 0;         // config.dirs + 1
+
+// Work distribution and totals (protected by work_mutex)
+pthread_mutex_t work_mutex = PTHREAD_MUTEX_INITIALIZER;
+long next_dir = 0;          // Next directory whose files are written
+long long total_links = 0;  // Link lines written
+long long total_bytes = 0;  // Bytes written
+int write_failed = 0;       // Set by any thread on I/O error
+
+// ============================================================================
+// RANDOM NUMBERS
+// ============================================================================
+// splitmix64: tiny, fast, and good enough to decorrelate per-file streams
+
+static inline uint64_t rng_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform integer in [0, bound)
+static inline uint64_t rng_below(uint64_t *state, uint64_t bound) {
+    return bound ? rng_next(state) % bound : 0;
+}
+
+// Uniform double in [0, 1)
+static inline double rng_unit(uint64_t *state) {
+    return (double)(rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// RNG stream of file i (independent of generation order)
+static inline uint64_t file_stream(long i) {
+    uint64_t state = config.seed ^ ((uint64_t)i * 0xD1B54A32D192ED03ULL);
+    rng_next(&state);
+    return state;
+}
+
+// ============================================================================
+// NAMING
+// ============================================================================
+// File i is always file_<i, zero-padded to 3>.<ext>, where ext is drawn from
+// the file's own stream, so any file's name can be rebuilt from its index.
+// Every name starts with "file_" and the filler text never contains '_', so
+// a name can only appear in a file where it was written as a link.
+
+// Write the name of file i into buf, returns its length
+static int file_name(long i, char *buf) {
+    uint64_t state = file_stream(i);
+    char ext[4];
+    for (int k = 0; k < 3; k++) {
+        ext[k] = (char)('a' + rng_below(&state, 26));
+    }
+    ext[3] = '\0';
+    return snprintf(buf, MAX_NAME, "file_%03ld.%s", i, ext);
+}
+
+// ============================================================================
+// TREE SHAPE
+// ============================================================================
+
+// Build the directory list and spread the files over it
+// Returns 0 on success, -1 on failure
+static int plan_tree(void) {
+    uint64_t state = config.seed;
+    dir_count = config.dirs + 1;
+    dirs = calloc((size_t)dir_count, sizeof(DirInfo));
+    if (!dirs) return -1;
+
+    dirs[0].path = strdup("files");
+    if (!dirs[0].path) return -1;
+
+    // = Directories: each picks a random parent that is not at max depth =
+    // Parents are drawn from the directories created so far, so the tree
+    // grows both wide and deep; dir_XXX numbers follow creation order.
+    long *open_dirs = malloc((size_t)dir_count * sizeof(long));
+    if (!open_dirs) return -1;
+    long open_count = 0;
+    if (config.depth > 0) open_dirs[open_count++] = 0;
+
+    for (long d = 1; d < dir_count; d++) {
+        if (open_count == 0) {
+            // Depth 0 asked for: everything lives directly in files/
+            dir_count = d;
+            break;
+        }
+        long parent = open_dirs[rng_below(&state, (uint64_t)open_count)];
+        size_t len = strlen(dirs[parent].path) + 16;
+        dirs[d].path = malloc(len);
+        if (!dirs[d].path) {
+            free(open_dirs);
+            return -1;
+        }
+        snprintf(dirs[d].path, len, "%s/dir_%03ld", dirs[parent].path, d - 1);
+        dirs[d].depth = dirs[parent].depth + 1;
+        if (dirs[d].depth < config.depth) {
+            open_dirs[open_count++] = d;
+        }
+    }
+    free(open_dirs);
+
+    // = Files: random directory per file, numbered consecutively per directory =
+    for (long i = 0; i < config.files; i++) {
+        dirs[rng_below(&state, (uint64_t)dir_count)].file_count++;
+    }
+    long first = 0;
+    for (long d = 0; d < dir_count; d++) {
+        dirs[d].first_file = first;
+        first += dirs[d].file_count;
+    }
+    return 0;
+}
+
+// ============================================================================
+// FILE CONTENTS
+// ============================================================================
+
+// ContentBuf: Growable per-thread buffer holding one file's contents
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} ContentBuf;
+
+static int buf_reserve(ContentBuf *b, size_t extra) {
+    if (b->len + extra <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : WRITE_BUFFER_SIZE;
+    while (cap < b->len + extra) cap *= 2;
+    char *grown = realloc(b->data, cap);
+    if (!grown) return -1;
+    b->data = grown;
+    b->cap = cap;
+    return 0;
+}
+
+// Append "name\n" of file j
+static int buf_add_link(ContentBuf *b, long j) {
+    if (buf_reserve(b, MAX_NAME + 1) != 0) return -1;
+    int len = file_name(j, b->data + b->len);
+    b->len += (size_t)len;
+    b->data[b->len++] = '\n';
+    return 0;
+}
+
+// Draw this file's target size from the configured distribution
+static long draw_size(uint64_t *state) {
+    double mean = (double)config.mean_size;
+    switch (config.size_dist) {
+        case SIZE_UNIFORM:
+            return (long)(rng_unit(state) * 2.0 * mean);
+        case SIZE_EXP:
+            return (long)(-mean * log(1.0 - rng_unit(state)));
+        case SIZE_PARETO: {
+            // alpha = 1.5: mean = xm * alpha / (alpha - 1) = 3 xm
+            double xm = mean / 3.0;
+            return (long)(xm / pow(1.0 - rng_unit(state), 1.0 / 1.5));
+        }
+        case SIZE_FIXED:
+        default:
+            return config.mean_size;
+    }
+}
+
+// Number of links for one file: mean outdegree, at least `min_links`
+static long draw_links(uint64_t *state, long min_links) {
+    // Uniform on [0, 2 * outdegree] keeps the mean while varying per file
+    long count = (long)floor(rng_unit(state) * (2.0 * config.outdegree + 1.0));
+    return count < min_links ? min_links : count;
+}
+
+// Build the contents of file i (in directory d) into b
+// SPEC Section 4.1.1 - Link patterns depend on DIR_STRUCTURE
+// Returns the number of link lines written, or -1 on allocation failure
+static long build_contents(long i, const DirInfo *d, ContentBuf *b) {
+    uint64_t state = file_stream(i);
+    for (int k = 0; k < 3; k++) rng_next(&state);   // Skip the extension draws
+    b->len = 0;
+    long links = 0;
+    long n = config.files;
+
+    switch (config.structure) {
+        // CONNECTED: file_i mentions file_(i+1) (circular), plus random extras
+        case STRUCT_CONNECTED: {
+            long next = (i + 1) % n;
+            if (next != i) {
+                if (buf_add_link(b, next) != 0) return -1;
+                links++;
+            }
+            long extra = draw_links(&state, 1) - 1;
+            for (long k = 0; k < extra && n > 2; k++) {
+                long j = (long)rng_below(&state, (uint64_t)n);
+                if (j == i || j == next) continue;
+                if (buf_add_link(b, j) != 0) return -1;
+                links++;
+            }
+            break;
+        }
+
+        // FOREST: links only within the same directory (circular + extras)
+        case STRUCT_FOREST: {
+            long base = d->first_file, count = d->file_count;
+            if (count < 2) break;
+            long next = base + (i - base + 1) % count;
+            if (buf_add_link(b, next) != 0) return -1;
+            links++;
+            long extra = draw_links(&state, 1) - 1;
+            for (long k = 0; k < extra; k++) {
+                long j = base + (long)rng_below(&state, (uint64_t)count);
+                if (j == i) continue;
+                if (buf_add_link(b, j) != 0) return -1;
+                links++;
+            }
+            break;
+        }
+
+        // FULL: every file mentions every other file
+        case STRUCT_FULL:
+            for (long j = 0; j < n; j++) {
+                if (j == i) continue;
+                if (buf_add_link(b, j) != 0) return -1;
+                links++;
+            }
+            break;
+
+        // RANDOM: random number of random targets (may be 0 = dangling)
+        case STRUCT_RANDOM:
+        default: {
+            long count = draw_links(&state, 0);
+            for (long k = 0; k < count; k++) {
+                long j = (long)rng_below(&state, (uint64_t)n);
+                if (j == i) continue;
+                if (buf_add_link(b, j) != 0) return -1;
+                links++;
+            }
+            break;
+        }
+    }
+
+    // = Filler text up to the drawn size (lowercase words, never '_') =
+    long target = draw_size(&state);
+    if (target > (long)b->len) {
+        size_t fill = (size_t)target - b->len;
+        if (buf_reserve(b, fill) != 0) return -1;
+        char *p = b->data + b->len;
+        for (size_t k = 0; k < fill; k++) {
+            uint64_t r = rng_next(&state);
+            p[k] = (r % 7 == 0) ? ((r >> 8) % 5 == 0 ? '\n' : ' ') : (char)('a' + (r >> 16) % 26);
+        }
+        b->len += fill;
+    }
+    return links;
+}
+
+// ============================================================================
+// WRITER THREADS
+// ============================================================================
+// Directories were all created up front (in order), so threads only create
+// files: each pulls the next directory, opens it once and creates every file
+// in it relative to that descriptor.
+
+void *writer_worker(void *arg) {
+    (void)arg;
+    ContentBuf b = {0};
+    char name[MAX_NAME];
+    long long links_written = 0, bytes_written = 0;
+
+    while (1) {
+        pthread_mutex_lock(&work_mutex);
+        // -------------------------------
+        long d = (next_dir < dir_count && !write_failed) ? next_dir++ : -1;
+        // -------------------------------
+        pthread_mutex_unlock(&work_mutex);
+        if (d == -1) break;
+
+        const DirInfo *dir = &dirs[d];
+        if (dir->file_count == 0) continue;
+        int dir_fd = open(dir->path, O_RDONLY | O_DIRECTORY);
+        if (dir_fd == -1) {
+            perror(dir->path);
+            goto fail;
+        }
+
+        for (long i = dir->first_file; i < dir->first_file + dir->file_count; i++) {
+            long links = build_contents(i, dir, &b);
+            if (links < 0) {
+                fprintf(stderr, "ERROR: Out of memory building file %ld\n", i);
+                close(dir_fd);
+                goto fail;
+            }
+            file_name(i, name);
+            int fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd == -1 || write(fd, b.data, b.len) != (ssize_t)b.len) {
+                perror(name);
+                if (fd != -1) close(fd);
+                close(dir_fd);
+                goto fail;
+            }
+            close(fd);
+            links_written += links;
+            bytes_written += (long long)b.len;
+        }
+        close(dir_fd);
+    }
+
+    pthread_mutex_lock(&work_mutex);
+    total_links += links_written;
+    total_bytes += bytes_written;
+    pthread_mutex_unlock(&work_mutex);
+    free(b.data);
+    return NULL;
+
+fail:
+    pthread_mutex_lock(&work_mutex);
+    write_failed = 1;
+    pthread_mutex_unlock(&work_mutex);
+    free(b.data);
+    return NULL;
+}
+
+// ============================================================================
+// HELPER FUNCTIONS
+// ============================================================================
+
+// nftw callback: delete everything below (and including) files/
+static int remove_entry(const char *path, const struct stat *sb, int type, struct FTW *ftw) {
+    (void)sb; (void)type; (void)ftw;
+    if (remove(path) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <DIR_STRUCTURE> [options]\n", prog);
+    fprintf(stderr, "  DIR_STRUCTURE:     forest, connected, full, random\n");
+    fprintf(stderr, "  --preset NAME      small (1K files), medium (100K), large (1M), huge (10M)\n");
+    fprintf(stderr, "  --files N          total files (default 1000)\n");
+    fprintf(stderr, "  --dirs N           directories below files/ (default 100)\n");
+    fprintf(stderr, "  --depth N          maximum directory depth (default 4)\n");
+    fprintf(stderr, "  --outdegree D      average links per file (default 2)\n");
+    fprintf(stderr, "  --size-dist DIST   fixed, uniform, exp, pareto (default fixed)\n");
+    fprintf(stderr, "  --mean-size B      mean file size in bytes (default 0 = links only)\n");
+    fprintf(stderr, "  --seed S           RNG seed (default 140)\n");
+    fprintf(stderr, "  --threads T        writer threads (default 4)\n");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char *argv[]) {
+    // ========================================================================
+    // PARSE ARGUMENTS
+    // ========================================================================
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *structure = argv[1];
+    if (strcmp(structure, "forest") == 0) config.structure = STRUCT_FOREST;
+    else if (strcmp(structure, "connected") == 0) config.structure = STRUCT_CONNECTED;
+    else if (strcmp(structure, "full") == 0) config.structure = STRUCT_FULL;
+    else if (strcmp(structure, "random") == 0) config.structure = STRUCT_RANDOM;
+    else {
+        fprintf(stderr, "Error: Unknown structure '%s'\n", structure);
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) {
+            fprintf(stderr, "Error: %s needs a value\n", opt);
+            return 1;
+        }
+        i++;
+
+        if (strcmp(opt, "--preset") == 0) {
+            const Preset *p = NULL;
+            for (size_t k = 0; k < sizeof(PRESETS) / sizeof(PRESETS[0]); k++) {
+                if (strcmp(PRESETS[k].name, val) == 0) p = &PRESETS[k];
+            }
+            if (!p) {
+                fprintf(stderr, "Error: Unknown preset '%s'\n", val);
+                return 1;
+            }
+            config.files = p->files;
+            config.dirs = p->dirs;
+            config.depth = p->depth;
+        } else if (strcmp(opt, "--files") == 0) {
+            config.files = atol(val);
+        } else if (strcmp(opt, "--dirs") == 0) {
+            config.dirs = atol(val);
+        } else if (strcmp(opt, "--depth") == 0) {
+            config.depth = atoi(val);
+        } else if (strcmp(opt, "--outdegree") == 0) {
+            config.outdegree = atof(val);
+        } else if (strcmp(opt, "--size-dist") == 0) {
+            if (strcmp(val, "fixed") == 0) config.size_dist = SIZE_FIXED;
+            else if (strcmp(val, "uniform") == 0) config.size_dist = SIZE_UNIFORM;
+            else if (strcmp(val, "exp") == 0) config.size_dist = SIZE_EXP;
+            else if (strcmp(val, "pareto") == 0) config.size_dist = SIZE_PARETO;
+            else {
+                fprintf(stderr, "Error: Unknown size distribution '%s'\n", val);
+                return 1;
+            }
+        } else if (strcmp(opt, "--mean-size") == 0) {
+            config.mean_size = atol(val);
+        } else if (strcmp(opt, "--seed") == 0) {
+            config.seed = strtoull(val, NULL, 0);
+        } else if (strcmp(opt, "--threads") == 0) {
+            config.threads = atoi(val);
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", opt);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.files < 1 || config.dirs < 0 || config.depth < 0 ||
+        config.outdegree < 0 || config.mean_size < 0 ||
+        config.threads < 1 || config.threads > MAX_GEN_THREADS) {
+        fprintf(stderr, "Error: Invalid arguments\n");
+        usage(argv[0]);
+        return 1;
+    }
+    if (config.structure == STRUCT_FULL && config.files > 20000) {
+        fprintf(stderr, "Warning: full structure with %ld files writes %.0f links\n",
+                config.files, (double)config.files * (double)(config.files - 1));
+    }
+
+    printf("=== CS 140 File Generator (native) ===\n");
+    printf("Structure: %s, files=%ld, dirs=%ld, depth=%d, outdegree=%.2f, "
+           "mean size=%ld, seed=%llu\n\n", structure, config.files, config.dirs,
+           config.depth, config.outdegree, config.mean_size,
+           (unsigned long long)config.seed);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // ========================================================================
+    // PHASE 1: CREATE DIRECTORY STRUCTURE
+    // ========================================================================
+    // Clean up old files directory for fresh start
+    struct stat st;
+    if (stat("files", &st) == 0 &&
+        nftw("files", remove_entry, 64, FTW_DEPTH | FTW_PHYS) != 0) {
+        fprintf(stderr, "Error: Could not remove old files/ directory\n");
+        return 1;
+    }
+
+    if (plan_tree() != 0) {
+        fprintf(stderr, "Error: Out of memory planning the tree\n");
+        return 1;
+    }
+    // Parents are always created before their children
+    for (long d = 0; d < dir_count; d++) {
+        if (mkdir(dirs[d].path, 0755) != 0) {
+            perror(dirs[d].path);
+            return 1;
+        }
+    }
+    printf("Phase 1: Created %ld directories\n", dir_count);
+
+    // ========================================================================
+    // PHASE 2: WRITE FILES WITH LINKS BASED ON DIR_STRUCTURE
+    // ========================================================================
+    pthread_t threads[MAX_GEN_THREADS];
+    WorkerArgs args[MAX_GEN_THREADS];
+    for (int t = 0; t < config.threads; t++) {
+        args[t].thread_id = t;
+        if (pthread_create(&threads[t], NULL, writer_worker, &args[t]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    for (int t = 0; t < config.threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    if (write_failed) {
+        fprintf(stderr, "Error: Failed to write files\n");
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) +
+                     (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // ========================================================================
+    // SUMMARY
+    // ========================================================================
+    printf("Phase 2: Wrote %ld files\n\n", config.files);
+    printf("=== Generation Complete ===\n");
+    printf("Output directory: ./files/\n");
+    printf("Total files: %ld\n", config.files);
+    printf("Total directories: %ld\n", dir_count);
+    printf("Total links: %lld (average outdegree %.2f)\n", total_links,
+           (double)total_links / (double)config.files);
+    printf("Total bytes: %lld\n", total_bytes);
+    printf("Time: %.2f s\n", elapsed);
+
+    for (long d = 0; d < dir_count; d++) {
+        free(dirs[d].path);
+    }
+    free(dirs);
+    return 0;
+}
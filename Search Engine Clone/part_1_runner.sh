@@ -30,8 +30,8 @@
 # mkdir -p performance-data
 
 # # Compile
-# echo "[1/2] Compiling multithreaded.c..."
-# gcc -o multithreaded multithreaded.c -pthread -Wall
+# echo "[1/2] Compiling multithreaded.c + Crawler.c..."
+# gcc -o multithreaded multithreaded.c Crawler.c -pthread -Wall
 # if [ $? -ne 0 ]; then
 #     echo "ERROR: Compilation failed"
 #     exit 1
@@ -138,8 +138,8 @@ mkdir -p part-1-outputs
 mkdir -p part-1-performance-data
 
 # Compile
-echo "[1/2] Compiling multithreaded.c..."
-gcc -o multithreaded multithreaded.c -pthread -Wall
+echo "[1/2] Compiling multithreaded.c + Crawler.c..."
+gcc -o multithreaded multithreaded.c Crawler.c -pthread -Wall
 if [ $? -ne 0 ]; then
     echo "ERROR: Compilation failed"
     exit 1
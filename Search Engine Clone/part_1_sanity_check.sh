@@ -42,7 +42,7 @@ echo ""
 # ============================================================================
 echo -e "${CYAN}[STEP 1/6] Compiling multithreaded.c...${NC}"
 
-gcc -o multithreaded multithreaded.c -pthread -Wall 2>&1 | tee "$LOG_DIR/compilation.log"
+gcc -o multithreaded multithreaded.c Crawler.c -pthread -Wall 2>&1 | tee "$LOG_DIR/compilation.log"
 
 if [ ${PIPESTATUS[0]} -ne 0 ]; then
     echo -e "${RED}[FAIL]${NC} Compilation failed. See $LOG_DIR/compilation.log"
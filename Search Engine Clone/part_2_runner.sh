@@ -127,7 +127,7 @@ int main(int argc, char **argv) {
 EOF
 
 CFLAGS="-O2 -Wall -Wextra -std=gnu11 -D_GNU_SOURCE -I."
-LDFLAGS="-lm"
+LDFLAGS="-lm -pthread"
 
 # Compile CSR builder
 gcc $CFLAGS \
@@ -4,6 +4,9 @@ import subprocess
 import collections
 import struct
 import shutil
+import re
+import signal
+import tempfile
 from pathlib import Path
 import time
 
@@ -168,7 +171,7 @@ def test_part1_compilation():
     print_test("Part 1: Compile multithreaded.c")
     
     ret, stdout, stderr = run_command(
-        "gcc -o multithreaded multithreaded.c -pthread -Wall",
+        "gcc -o multithreaded multithreaded.c Crawler.c -pthread -Wall",
         check=False
     )
     
@@ -384,6 +387,465 @@ def test_part1_stress():
     if backup_dir and os.path.exists(backup_dir):
         os.rename(backup_dir, "part-1-outputs")
 
+# ============================================================================
+# PART 1: MODE EQUIVALENCE CHECKS
+# ============================================================================
+# Every optional crawl mode must produce the same graph as a default run over
+# the same tree. Link lists are compared as sets (the order within a list
+# and of the lines follows the node numbering, which may differ).
+
+EQUIV_THREADS = 4
+EQUIV_STRUCT = "random"
+
+def canonical_links(output_file):
+    """Sorted 'path|name|[in]|[out]' lines with sorted lists, or None."""
+    try:
+        with open(output_file, 'r') as f:
+            lines = f.read().splitlines()
+    except FileNotFoundError:
+        return None
+    result = []
+    for line in lines:
+        parts = line.split('|')
+        if len(parts) != 4:
+            return None
+        path, name, in_str, out_str = parts
+        inlinks = ','.join(sorted(parse_links_string(in_str)))
+        outlinks = ','.join(sorted(parse_links_string(out_str)))
+        result.append(f"{path}|{name}|[{inlinks}]|[{outlinks}]")
+    return sorted(result)
+
+def links_output_file(threads=EQUIV_THREADS, ext="txt"):
+    return f"part-1-outputs/{EQUIV_STRUCT}_{threads}_file_links.{ext}"
+
+def crawl_links(extra="", threads=EQUIV_THREADS, timeout=60):
+    """Run the crawler on ./files from scratch; return (canonical links, output)."""
+    output_file = links_output_file(threads)
+    if os.path.exists(output_file):
+        os.remove(output_file)     # The crawler appends to an existing link file
+    ret, stdout, stderr = run_command(
+        f"./multithreaded {threads} {EQUIV_STRUCT} {extra}",
+        timeout=timeout,
+        check=False
+    )
+    if ret != 0:
+        print_fail(f"'multithreaded {threads} {EQUIV_STRUCT} {extra}' failed (exit code: {ret})")
+        if stderr:
+            print(f"Error: {stderr.strip()}")
+        return None, stdout + stderr
+    links = canonical_links(output_file)
+    if links is None:
+        print_fail(f"Missing or malformed output: {output_file}")
+    return links, stdout + stderr
+
+def compare_links(label, expected, actual):
+    """Pass if both runs produced the same graph."""
+    if expected is None or actual is None:
+        return False
+    if expected == actual:
+        print_pass(f"{label}: same links as the default run ({len(actual)} files)")
+        return True
+    missing = sorted(set(expected) - set(actual))
+    extra = sorted(set(actual) - set(expected))
+    print_fail(f"{label}: {len(missing)} lines missing, {len(extra)} unexpected")
+    for line in (missing[:2] + extra[:2]):
+        print(f"   {line}")
+    return False
+
+def list_tree_files(files_root="files"):
+    """Every file under files_root, sorted."""
+    found = []
+    for root, _, files in os.walk(files_root):
+        for filename in files:
+            found.append(os.path.join(root, filename))
+    return sorted(found)
+
+def test_part1_incremental():
+    """--incremental: a recrawl after edits matches a full crawl"""
+    print_test("--incremental matches a full crawl (first run and after edits)")
+    manifest = f"part-1-outputs/{EQUIV_STRUCT}_manifest.txt"
+    if os.path.exists(manifest):
+        os.remove(manifest)
+
+    baseline, _ = crawl_links()
+    first, _ = crawl_links("--incremental")
+    compare_links("--incremental (no manifest)", baseline, first)
+
+    # Edit one file, touch another without changing it, add and remove one
+    files = list_tree_files()
+    if len(files) < 4:
+        print_skip("Tree too small to edit")
+        return
+    with open(files[0], 'a') as f:
+        f.write(os.path.basename(files[1]) + "\n")
+    os.utime(files[2])
+    os.remove(files[3])
+    with open(os.path.join(os.path.dirname(files[0]), "sanity_added.txt"), 'w') as f:
+        f.write(os.path.basename(files[0]) + "\n")
+    with open(files[1], 'a') as f:
+        f.write("sanity_added.txt\n")
+
+    second, stdout = crawl_links("--incremental")
+    baseline, _ = crawl_links()
+    compare_links("--incremental (after edits)", baseline, second)
+    match = re.search(r"Incremental: (\d+) reused", stdout)
+    if match and int(match.group(1)) > 0:
+        print_pass(f"--incremental reused {match.group(1)} unchanged files")
+    else:
+        print_fail("--incremental rescanned everything (no files reused)")
+
+def binary_links(bin_file):
+    """Decode a --binary edge list (LNKB) into canonical link lines, or None."""
+    try:
+        with open(bin_file, 'rb') as f:
+            data = f.read()
+    except FileNotFoundError:
+        return None
+    header = struct.Struct('<IIiiqq')
+    if len(data) < header.size:
+        return None
+    magic, version, n, _, strtab_bytes, edge_count = header.unpack_from(data, 0)
+    if magic != 0x424B4E4C or version != 1:
+        return None
+    strings = data[header.size:header.size + strtab_bytes].split(b'\0')
+    paths = [strings[2 * i].decode() for i in range(n)]
+    names = [strings[2 * i + 1].decode() for i in range(n)]
+    edges_at = header.size + strtab_bytes
+    if len(data) != edges_at + 8 * edge_count:
+        return None
+    inlinks = [[] for _ in range(n)]
+    outlinks = [[] for _ in range(n)]
+    for src, dst in struct.iter_unpack('<ii', data[edges_at:]):
+        outlinks[src].append(names[dst])
+        inlinks[dst].append(names[src])
+    return sorted(f"{paths[i]}|{names[i]}|[{','.join(sorted(inlinks[i]))}]|"
+                  f"[{','.join(sorted(outlinks[i]))}]" for i in range(n))
+
+def test_part1_binary():
+    """--binary: the LNKB edge list holds the same graph as the text file"""
+    print_test("--binary edge list matches the text link file")
+    baseline, _ = crawl_links()
+    bin_file = links_output_file(ext="bin")
+    if os.path.exists(bin_file):
+        os.remove(bin_file)
+    ret, _, stderr = run_command(
+        f"./multithreaded {EQUIV_THREADS} {EQUIV_STRUCT} --binary",
+        timeout=60,
+        check=False
+    )
+    if ret != 0:
+        print_fail(f"--binary run failed (exit code: {ret})")
+        if stderr:
+            print(f"Error: {stderr.strip()}")
+        return
+    links = binary_links(bin_file)
+    if links is None:
+        print_fail(f"Missing or malformed edge list: {bin_file}")
+        return
+    compare_links("--binary", baseline, links)
+
+def test_part1_queue_depth():
+    """--queue-depth: io_uring batches of any depth read the same bytes"""
+    print_test("--queue-depth 0 / 1 / 64 match the default run")
+    baseline, _ = crawl_links()
+    for depth in (0, 1, 64):
+        links, output = crawl_links(f"--queue-depth {depth}")
+        compare_links(f"--queue-depth {depth}", baseline, links)
+        if depth > 0 and "io_uring unavailable" in output:
+            print_warn("io_uring is unavailable here; only blocking reads were compared")
+            break
+
+def test_part1_dedup():
+    """Dedup: copied outlinks equal scanned ones (and the ground truth)"""
+    print_test("Dedup (default) matches --no-dedup and the ground truth")
+    # Byte-identical copies under new names, in other directories
+    files = list_tree_files()
+    for i, src in enumerate(files[:8]):
+        dst_dir = os.path.dirname(files[-1 - i])
+        shutil.copyfile(src, os.path.join(dst_dir, f"sanity_dup{i}_{os.path.basename(src)}"))
+
+    scanned, _ = crawl_links("--no-dedup")
+    deduped, output = crawl_links()     # Left in place for the ground truth check
+    compare_links("--no-dedup", deduped, scanned)
+    match = re.search(r"Dedup: (\d+) duplicate files copied", output)
+    if match and int(match.group(1)) > 0:
+        print_pass(f"Dedup copied the links of {match.group(1)} files")
+    else:
+        print_fail("Dedup found no duplicates among the copied files")
+    if verify_multithreaded_output(links_output_file(), get_ground_truth("files")):
+        print_pass("Deduplicated crawl matches the ground truth")
+    else:
+        print_fail("Deduplicated crawl does not match the ground truth")
+
+def test_part1_shards():
+    """--shards K: the merged crawl equals a single-process crawl"""
+    print_test("--shards 1 / 2 / 3 / 5 match the default run")
+    baseline, _ = crawl_links()
+    for shards in (1, 2, 3, 5):
+        links, _ = crawl_links(f"--shards {shards}")
+        compare_links(f"--shards {shards}", baseline, links)
+    leftovers = list(Path("part-1-outputs").glob("*_shard*"))
+    if leftovers:
+        print_fail(f"Shard intermediate files left behind: {leftovers[0]}")
+    else:
+        print_pass("Shard intermediate files removed")
+
+def read_vm_hwm(pid):
+    """VmHWM (peak RSS since exec) of a running process in KiB, or 0."""
+    try:
+        with open(f"/proc/{pid}/status") as f:
+            for line in f:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1])
+    except (OSError, ValueError):
+        pass
+    return 0
+
+def run_with_peak_rss(cmd, timeout=60):
+    """Run cmd; return (returncode, output, peak RSS in KiB).
+
+    ru_maxrss would include this Python process (it survives fork + exec),
+    so the peak is VmHWM, sampled while the program runs and taken from
+    its own 'peak RSS ... KiB' report at exit, whichever is larger."""
+    with tempfile.TemporaryFile() as out:
+        proc = subprocess.Popen(cmd, shell=False, stdout=out, stderr=subprocess.STDOUT)
+        peak_kib = 0
+        deadline = time.time() + timeout
+        while proc.poll() is None:
+            peak_kib = max(peak_kib, read_vm_hwm(proc.pid))
+            if time.time() > deadline:
+                proc.kill()
+                proc.wait()
+                break
+            time.sleep(0.01)
+        out.seek(0)
+        output = out.read().decode(errors='replace')
+    reported = re.search(r"peak RSS (\d+) KiB", output)
+    if reported:
+        peak_kib = max(peak_kib, int(reported.group(1)))
+    return proc.returncode, output, peak_kib
+
+def test_part1_mem_budget():
+    """--mem-mb: spilled crawls match, and peak RSS stays within the budget"""
+    print_test("--mem-mb matches the default run within its peak RSS budget")
+    # A tree with more edges than the smallest edge buffer, so runs spill
+    ret, _, stderr = run_command(
+        "gcc -O2 -Wall -o files_generator files_generator.c -pthread -lm && "
+        f"./files_generator {EQUIV_STRUCT} --files 20000 --dirs 200 --depth 3 "
+        "--outdegree 32 --seed 140 > /dev/null",
+        timeout=120,
+        check=False
+    )
+    if ret != 0:
+        print_fail("Could not build the --mem-mb tree with files_generator")
+        print(stderr)
+        return
+
+    baseline, _ = crawl_links(threads=1)
+    for threads in (1, EQUIV_THREADS):
+        for extra in ("", " --binary"):
+            check_mem_budget(threads, extra, baseline)
+
+def check_mem_budget(threads, extra, baseline):
+    """Crawl with the smallest budget the crawler accepts (which must
+    spill) and with room to spare; both must match and stay within it"""
+    cmd = ["./multithreaded", str(threads), EQUIV_STRUCT] + extra.split()
+    ret, output, _ = run_with_peak_rss(cmd + ["--mem-mb", "1"])
+    match = re.search(r"below the (\d+) MiB", output)
+    if ret == 0 or not match:
+        print_fail(f"--mem-mb 1{extra} ({threads} threads) was not rejected "
+                   "with the budget the crawl needs")
+        return
+    need_mb = int(match.group(1))
+
+    # +1: what is resident when the budget is checked varies a little
+    # between runs; the extra MiB must not stop runs from spilling
+    budgets = (need_mb + 1,) if extra else (need_mb + 1, need_mb + 64)
+    for budget_mb in budgets:
+        label = f"--mem-mb {budget_mb}{extra} ({threads} threads, needs {need_mb})"
+        output_file = links_output_file(threads, "bin" if extra else "txt")
+        if os.path.exists(output_file):
+            os.remove(output_file)
+        ret, output, peak_kib = run_with_peak_rss(cmd + ["--mem-mb", str(budget_mb)])
+        if ret != 0:
+            print_fail(f"{label} failed (exit code: {ret})")
+            print(output.strip())
+            continue
+        links = binary_links(output_file) if extra else canonical_links(output_file)
+        compare_links(label, baseline, links)
+        if peak_kib <= budget_mb * 1024:
+            print_pass(f"{label}: peak RSS {peak_kib} KiB within {budget_mb} MiB")
+        else:
+            print_fail(f"{label}: peak RSS {peak_kib} KiB over {budget_mb} MiB")
+        spilled = re.search(r"(\d+) runs spilled", output)
+        if budget_mb == need_mb + 1 and not (spilled and int(spilled.group(1)) > 0):
+            print_fail(f"{label}: nothing was spilled")
+
+def watched_links(snapshot_file, events_file):
+    """Apply a --watch event stream to the link file it started from;
+    return the resulting canonical link lines, or None."""
+    paths = {}      # name -> path of every live node
+    edges = set()   # (src name, dst name)
+    try:
+        with open(snapshot_file, 'r') as f:
+            for line in f.read().splitlines():
+                parts = line.split('|')
+                if len(parts) != 4:
+                    return None
+                paths[parts[1]] = parts[0]
+                edges.update((parts[1], dst) for dst in parse_links_string(parts[3]))
+        with open(events_file, 'r') as f:
+            for line in f.read().splitlines():
+                fields = line.split('\t')
+                if fields[0] == "+N":
+                    paths[os.path.basename(fields[1])] = fields[1]
+                elif fields[0] == "-N":
+                    paths.pop(os.path.basename(fields[1]), None)
+                elif fields[0] == "+E":
+                    edges.add((fields[1], fields[2]))
+                elif fields[0] == "-E":
+                    edges.discard((fields[1], fields[2]))
+    except FileNotFoundError:
+        return None
+    inlinks = collections.defaultdict(list)
+    outlinks = collections.defaultdict(list)
+    for src, dst in edges:
+        outlinks[src].append(dst)
+        inlinks[dst].append(src)
+    return sorted(f"{path}|{name}|[{','.join(sorted(inlinks[name]))}]|"
+                  f"[{','.join(sorted(outlinks[name]))}]" for name, path in paths.items())
+
+def wait_until(condition, timeout):
+    """Poll condition() until it holds; return whether it did in time."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        if condition():
+            return True
+        time.sleep(0.05)
+    return False
+
+def read_text(path):
+    try:
+        with open(path, 'r', errors='replace') as f:
+            return f.read()
+    except FileNotFoundError:
+        return ""
+
+def test_part1_watch():
+    """--watch: the snapshot plus its event stream matches a fresh crawl"""
+    print_test("--watch snapshot + events match a crawl after the edits")
+    snapshot = links_output_file()
+    events = f"part-1-outputs/{EQUIV_STRUCT}_{EQUIV_THREADS}_events.txt"
+    watch_log = f"part-1-outputs/{EQUIV_STRUCT}_{EQUIV_THREADS}_watch.log"
+    for path in (snapshot, events):
+        if os.path.exists(path):
+            os.remove(path)
+    files = list_tree_files()
+    first_dir, last_dir = os.path.dirname(files[0]), os.path.dirname(files[-1])
+    if len(files) < 6 or first_dir == last_dir:
+        print_skip("Tree too small to edit")
+        return
+
+    # A second file with the name of files[4]: the crawl keeps one copy
+    dup_name = os.path.basename(files[4])
+    dup_dir = last_dir if os.path.dirname(files[4]) != last_dir else first_dir
+    shutil.copy(files[4], os.path.join(dup_dir, dup_name))
+
+    with open(watch_log, 'w') as log:
+        proc = subprocess.Popen(
+            ["./multithreaded", str(EQUIV_THREADS), EQUIV_STRUCT, "--watch"],
+            stdout=log, stderr=subprocess.STDOUT
+        )
+    try:
+        if not wait_until(lambda: "=== WATCH MODE" in read_text(watch_log), 60):
+            print_fail("--watch never started following files/")
+            print(read_text(watch_log).strip())
+            return
+
+        # Same edits as the --incremental check, while the crawler watches
+        with open(files[0], 'a') as f:
+            f.write(os.path.basename(files[1]) + "\n")
+        os.remove(files[3])
+        with open(os.path.join(first_dir, "sanity_added.txt"), 'w') as f:
+            f.write(os.path.basename(files[0]) + "\n")
+        with open(files[1], 'a') as f:
+            f.write("sanity_added.txt\n")
+        # Move a file into an (alphabetically) earlier directory, and delete
+        # the copy of the duplicate name the crawl kept: both names remain
+        os.rename(files[-1], os.path.join(first_dir, os.path.basename(files[-1])))
+        kept = [line.split('|')[0] for line in read_text(snapshot).splitlines()
+                if line.split('|')[1:2] == [dup_name]]
+        if len(kept) != 1:
+            print_fail(f"Crawl kept {len(kept)} copies of {dup_name}")
+            return
+        os.remove(kept[0])
+
+        # The edits are all applied once no batch (C record) has come for 2 s
+        state = {"batches": 0, "since": time.time()}
+        def settled():
+            batches = read_text(events).count("C\t")
+            if batches != state["batches"]:
+                state["batches"], state["since"] = batches, time.time()
+            return batches > 0 and time.time() - state["since"] > 2.0
+        if not wait_until(settled, 30):
+            print_fail("--watch wrote no batch for the edits")
+            return
+
+        proc.send_signal(signal.SIGINT)
+        proc.wait(timeout=30)
+        if proc.returncode != 0:
+            print_fail(f"--watch did not stop cleanly on SIGINT (exit code: {proc.returncode})")
+            print(read_text(watch_log).strip())
+            return
+        print_pass(f"--watch applied the edits in {state['batches']} batch(es) and stopped on SIGINT")
+    finally:
+        if proc.poll() is None:
+            proc.kill()
+            proc.wait()
+
+    records = [line.split('\t')[0] for line in read_text(events).splitlines()]
+    for kind in ("+N", "-N", "+E", "-E"):
+        if kind not in records:
+            print_fail(f"--watch events have no {kind} record")
+    watched = watched_links(snapshot, events)
+    if watched is None:
+        print_fail(f"Missing or malformed output: {snapshot} / {events}")
+        return
+    baseline, _ = crawl_links()
+    compare_links("--watch (snapshot + events)", baseline, watched)
+
+def test_part1_equivalence():
+    """Run every mode on one tree and compare it with the default run"""
+    print_header("PART 1: MODE EQUIVALENCE CHECKS")
+
+    if not os.path.exists("multithreaded"):
+        print_skip("multithreaded binary not found")
+        return
+
+    backup_dir = None
+    if os.path.exists("part-1-outputs"):
+        backup_dir = f"part-1-outputs.equiv.backup.{int(time.time())}"
+        os.rename("part-1-outputs", backup_dir)
+    os.makedirs("part-1-outputs", exist_ok=True)
+
+    for check in (test_part1_incremental, test_part1_binary, test_part1_queue_depth,
+                  test_part1_dedup, test_part1_shards, test_part1_mem_budget,
+                  test_part1_watch):
+        ret, _, _ = run_command(
+            f"./files_generator.sh 5 3 3 {EQUIV_STRUCT} > /dev/null 2>&1",
+            check=False
+        )
+        if ret != 0:
+            print_fail(f"File generator failed for {EQUIV_STRUCT}")
+            break
+        check()
+
+    # Clean up and restore original
+    if os.path.exists("part-1-outputs"):
+        shutil.rmtree("part-1-outputs")
+    if backup_dir and os.path.exists(backup_dir):
+        os.rename(backup_dir, "part-1-outputs")
+
 # ============================================================================
 # PART 2: CSR.C TESTS
 # ============================================================================
@@ -395,7 +857,7 @@ def test_part2_csr_compilation():
     print_test("Compiling test_csr2.c")
     
     ret, stdout, stderr = run_command(
-        "gcc -o test_csr2 test_csr2.c CSR.c -lm -Wall",
+        "gcc -o test_csr2 test_csr2.c CSR.c -pthread -lm -Wall",
         check=False
     )
     
@@ -470,7 +932,7 @@ int main() {
     
     # Compile
     ret, _, stderr = run_command(
-        "gcc -o test_csr_build_tmp test_csr_build_tmp.c CSR.c -lm",
+        "gcc -o test_csr_build_tmp test_csr_build_tmp.c CSR.c -pthread -lm",
         check=False
     )
     
@@ -518,7 +980,7 @@ int main(int argc, char **argv) {
         f.write(wrapper_code)
     
     ret, stdout, stderr = run_command(
-        "gcc -o PageRank pagerank_wrapper.c PageRank.c CSR.c -lm -Wall",
+        "gcc -o PageRank pagerank_wrapper.c PageRank.c CSR.c -pthread -lm -Wall",
         check=False
     )
     
@@ -574,7 +1036,7 @@ int main(int argc, char **argv) {
         f.write(csr_wrapper)
     
     ret, _, stderr = run_command(
-        "gcc -o csr_builder_tmp csr_builder_tmp.c CSR.c -lm",
+        "gcc -o csr_builder_tmp csr_builder_tmp.c CSR.c -pthread -lm",
         check=False
     )
     
@@ -738,7 +1200,7 @@ def test_part4_searchengine_compilation():
     print_test("Compiling SearchEngine.c")
     
     ret, stdout, stderr = run_command(
-        "gcc -o SearchEngine SearchEngine.c CSR.c PageRank.c -lm -Wall",
+        "gcc -o SearchEngine SearchEngine.c CSR.c PageRank.c Crawler.c -pthread -lm -Wall",
         check=False
     )
     
@@ -971,6 +1433,7 @@ def main():
         test_part1_functional()
         test_part1_formatting()
         test_part1_stress()
+        test_part1_equivalence()
     
     # PART 2: CSR.C
     if test_part2_csr_compilation():
@@ -33,15 +33,8 @@ static int ensure_dir(const char *dir) {
 }
 
 static int32_t read_n_from_csr(const char *csr_path) {
-    FILE *fp = fopen(csr_path, "rb");
-    if (!fp) return -1;
-    int32_t n = -1, nnz = 0;
-    if (fread(&n, sizeof(int32_t), 1, fp) != 1 ||
-        fread(&nnz, sizeof(int32_t), 1, fp) != 1) {
-        fclose(fp);
-        return -1;
-    }
-    fclose(fp);
+    int32_t n = -1;
+    if (csr_file_info(csr_path, &n, NULL) != 0) return -1;
     return n;
 }
 
@@ -53,17 +53,12 @@ void test_csr_build() {
         return;
     }
     
-    FILE *fp = fopen(csr_file, "rb");
-    if (!fp) {
+    int32_t n, nnz;
+    if (csr_file_info(csr_file, &n, &nnz) != 0) {
         print_fail("CSR file not created");
         return;
     }
     
-    int32_t n, nnz;
-    fread(&n, sizeof(int32_t), 1, fp);
-    fread(&nnz, sizeof(int32_t), 1, fp);
-    fclose(fp);
-    
     printf("n = %d (expected: 5)\n", n);
     printf("nnz = %d (expected: 10)\n", nnz);
     
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
 #include <sys/stat.h>
 #include "CSR.h"
 
@@ -60,17 +61,12 @@ void test_1_basic_csr_build() {
         return;
     }
     
-    FILE *fp = fopen(csr_file, "rb");
-    if (!fp) {
+    int32_t n, nnz;
+    if (csr_file_info(csr_file, &n, &nnz) != 0) {
         print_fail("Basic CSR Build", "CSR file not created");
         return;
     }
     
-    int32_t n, nnz;
-    fread(&n, sizeof(int32_t), 1, fp);
-    fread(&nnz, sizeof(int32_t), 1, fp);
-    fclose(fp);
-    
     printf("n = %d (expected: 5)\n", n);
     printf("nnz = %d (expected: 10)\n", nnz);
     
@@ -498,6 +494,10 @@ void test_10_csr_free_no_crash() {
     g.row_ptr = NULL;
     g.col_idx = NULL;
     g.outdeg = NULL;
+    g.map = NULL;
+    g.map_bytes = 0;
+    g.adj = NULL;
+    g.adj_skip = 0;
     
     printf("Calling csr_free on empty CSR...\n");
     csr_free(&g);
@@ -591,6 +591,490 @@ void test_12_normalized_vector() {
     csr_free(&g);
 }
 
+int create_test_edge_list(const char *filename) {
+    FILE *fp = fopen(filename, "wb");
+    if (!fp) return -1;
+    
+    // Same graph as create_test_file_links(), as a binary edge list
+    const char *names[5] = {"0.txt", "1.txt", "2.txt", "3.txt", "4.txt"};
+    int32_t edges[10][2] = {
+        {0, 2}, {0, 3}, {1, 2}, {2, 0}, {2, 1},
+        {2, 3}, {3, 0}, {3, 4}, {4, 0}, {4, 1}
+    };
+    
+    int64_t strtab_bytes = 0;
+    for (int i = 0; i < 5; i++) {
+        strtab_bytes += strlen("files/") + 2 * strlen(names[i]) + 2;
+    }
+    uint32_t magic = CSR_EDGES_MAGIC, version = CSR_EDGES_VERSION;
+    int32_t n = 5, reserved = 0;
+    int64_t edge_count = 10;
+    fwrite(&magic, sizeof(magic), 1, fp);
+    fwrite(&version, sizeof(version), 1, fp);
+    fwrite(&n, sizeof(n), 1, fp);
+    fwrite(&reserved, sizeof(reserved), 1, fp);
+    fwrite(&strtab_bytes, sizeof(strtab_bytes), 1, fp);
+    fwrite(&edge_count, sizeof(edge_count), 1, fp);
+    for (int i = 0; i < 5; i++) {
+        fprintf(fp, "files/%s", names[i]);
+        fputc('\0', fp);
+        fputs(names[i], fp);
+        fputc('\0', fp);
+    }
+    fwrite(edges, sizeof(edges), 1, fp);
+    
+    fclose(fp);
+    return 0;
+}
+
+void test_13_binary_edge_list() {
+    print_test_header("13. CSR Build from Binary Edge List");
+    
+    const char *edges_file = "test_file_links.bin";
+    const char *csr_file = "test_edges_CSR.bin";
+    const char *nodes_file = "test_edges_nodes.txt";
+    
+    if (create_test_edge_list(edges_file) != 0) {
+        print_fail("Binary Edge List", "Could not create test file");
+        return;
+    }
+    
+    // csr_build_from_struct() must recognize the binary format by itself
+    if (csr_build_from_struct(edges_file, csr_file, nodes_file) != 0) {
+        print_fail("Binary Edge List", "csr_build_from_struct returned error");
+        return;
+    }
+    
+    CSR g_text, g_bin;
+    if (load_full("test_P_CSR.bin", &g_text) != 0) {
+        print_fail("Binary Edge List", "Could not load text-built CSR");
+        return;
+    }
+    if (load_full(csr_file, &g_bin) != 0) {
+        print_fail("Binary Edge List", "Could not load edge-list-built CSR");
+        csr_free(&g_text);
+        return;
+    }
+    
+    printf("n = %d, nnz = %d (text build: n = %d, nnz = %d)\n",
+           g_bin.n, g_bin.nnz, g_text.n, g_text.nnz);
+    
+    int same = (g_bin.n == g_text.n && g_bin.nnz == g_text.nnz);
+    for (int i = 0; same && i <= g_bin.n; i++) {
+        same = (g_bin.row_ptr[i] == g_text.row_ptr[i]);
+    }
+    for (int i = 0; same && i < g_bin.nnz; i++) {
+        same = (g_bin.col_idx[i] == g_text.col_idx[i]);
+    }
+    for (int i = 0; same && i < g_bin.n; i++) {
+        same = (g_bin.outdeg[i] == g_text.outdeg[i]);
+    }
+    
+    // Nodes file must match the text build line for line
+    char line_text[512], line_bin[512];
+    FILE *ft = fopen("test_nodes.txt", "r");
+    FILE *fb = fopen(nodes_file, "r");
+    if (!ft || !fb) {
+        same = 0;
+    } else {
+        while (same && fgets(line_text, sizeof(line_text), ft)) {
+            same = fgets(line_bin, sizeof(line_bin), fb) &&
+                   strcmp(line_text, line_bin) == 0;
+        }
+        if (same && fgets(line_bin, sizeof(line_bin), fb)) same = 0;
+    }
+    if (ft) fclose(ft);
+    if (fb) fclose(fb);
+    
+    if (same) {
+        print_pass("Binary Edge List");
+    } else {
+        print_fail("Binary Edge List", "CSR differs from the text-built CSR");
+    }
+    
+    csr_free(&g_text);
+    csr_free(&g_bin);
+}
+
+void test_14_long_lines() {
+    print_test_header("14. Long Lines and Many Outlinks");
+    
+    const char *links_file = "test_long_links.txt";
+    const char *csr_file = "test_long_CSR.bin";
+    const char *nodes_file = "test_long_nodes.txt";
+    const int n = 1500;
+    
+    // Node 0 links to every node (a line far over 8 KB), named before the
+    // lines that define them; "missing.txt" is not a node and is dropped
+    FILE *fp = fopen(links_file, "w");
+    if (!fp) {
+        print_fail("Long Lines", "Could not create test file");
+        return;
+    }
+    fprintf(fp, "files/node_0.txt|node_0.txt|[]|[missing.txt");
+    for (int i = n - 1; i >= 0; i--) {
+        fprintf(fp, ",node_%d.txt", i);
+    }
+    fprintf(fp, "]\n");
+    for (int i = 1; i < n; i++) {
+        fprintf(fp, "files/node_%d.txt|node_%d.txt|[node_0.txt]|[]\n", i, i);
+    }
+    fclose(fp);
+    
+    if (csr_build_from_struct(links_file, csr_file, nodes_file) != 0) {
+        print_fail("Long Lines", "csr_build_from_struct returned error");
+        return;
+    }
+    
+    CSR g;
+    if (load_full(csr_file, &g) != 0) {
+        print_fail("Long Lines", "Could not load CSR");
+        return;
+    }
+    
+    printf("n = %d, nnz = %d, outdeg[0] = %d (expected %d, %d, %d)\n",
+           g.n, g.nnz, g.outdeg[0], n, n, n);
+    
+    int ok = (g.n == n && g.nnz == n && g.outdeg[0] == n && g.row_ptr[1] == n);
+    for (int i = 0; ok && i < n; i++) {
+        ok = (g.col_idx[i] == n - 1 - i);   // Listed order is kept
+    }
+    for (int i = 1; ok && i < n; i++) {
+        ok = (g.outdeg[i] == 0);
+    }
+    
+    if (ok) {
+        print_pass("Long Lines");
+    } else {
+        print_fail("Long Lines", "Outlinks were truncated or misresolved");
+    }
+    
+    csr_free(&g);
+}
+
+// Are two files byte-identical?
+int same_file_bytes(const char *path_a, const char *path_b) {
+    FILE *fa = fopen(path_a, "rb");
+    FILE *fb = fopen(path_b, "rb");
+    int same = (fa && fb);
+    while (same) {
+        int ca = fgetc(fa), cb = fgetc(fb);
+        same = (ca == cb);
+        if (ca == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+void test_15_parallel_build() {
+    print_test_header("15. Parallel CSR Build Matches Sequential");
+    
+    const char *links_file = "test_parallel_links.txt";
+    
+    // Repeated names (the first row keeps a name), unknown outlinks, blank
+    // lines and a malformed line, spread over every chunk
+    FILE *fp = fopen(links_file, "w");
+    if (!fp) {
+        print_fail("Parallel Build", "Could not create test file");
+        return;
+    }
+    unsigned seed = 12345;
+    for (int i = 0; i < 3000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int name = (int)(seed >> 8) % 1000;
+        fprintf(fp, "files/%d/n%d.txt|n%d.txt|[]|[", i, name, name);
+        int links = (int)(seed >> 20) % 8;
+        for (int j = 0; j < links; j++) {
+            seed = seed * 1103515245u + 12345u;
+            fprintf(fp, "%sn%d.txt", j ? "," : "", (int)(seed >> 8) % 1200);
+        }
+        fprintf(fp, "]\n");
+        if (i % 700 == 0) fprintf(fp, "\n");
+        if (i == 1500) fprintf(fp, "files/bad.txt|bad.txt|[]|[n1.txt\n");
+    }
+    fclose(fp);
+    
+    int ok = (csr_build_from_struct_threads(links_file, "test_seq_CSR.bin",
+                                            "test_seq_nodes.txt", 1) == 0);
+    int threads[3] = {2, 5, 16};
+    for (int k = 0; ok && k < 3; k++) {
+        ok = (csr_build_from_struct_threads(links_file, "test_par_CSR.bin",
+                                            "test_par_nodes.txt", threads[k]) == 0) &&
+             same_file_bytes("test_seq_CSR.bin", "test_par_CSR.bin") &&
+             same_file_bytes("test_seq_nodes.txt", "test_par_nodes.txt");
+        printf("%d threads: %s\n", threads[k], ok ? "identical" : "different");
+    }
+    
+    if (ok) {
+        print_pass("Parallel Build");
+    } else {
+        print_fail("Parallel Build", "Parallel output differs from the sequential build");
+    }
+}
+
+// Copy src to dst, flipping byte flip_at (-1: none) and keeping keep_bytes
+// (-1: all)
+static int copy_file_bytes(const char *src, const char *dst, long flip_at, long keep_bytes) {
+    FILE *fa = fopen(src, "rb");
+    FILE *fb = fopen(dst, "wb");
+    int ok = (fa && fb);
+    int c;
+    for (long i = 0; ok && (keep_bytes < 0 || i < keep_bytes) && (c = fgetc(fa)) != EOF; i++) {
+        fputc(i == flip_at ? c ^ 0x40 : c, fb);
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return ok;
+}
+
+void test_16_mapped_file_format() {
+    print_test_header("16. Versioned Mapped CSR File");
+    
+    // test_P_CSR.bin is the 5-node graph of test 1
+    int32_t expected_row_ptr[] = {0, 2, 3, 6, 8, 10};
+    int32_t expected_col_idx[] = {2, 3, 2, 0, 1, 3, 0, 4, 0, 1};
+    int32_t expected_outdeg[] = {2, 1, 3, 2, 2};
+    
+    CSRFileHeader h;
+    FILE *fp = fopen("test_P_CSR.bin", "rb");
+    int ok = fp && fread(&h, sizeof(h), 1, fp) == 1;
+    if (fp) fclose(fp);
+    ok = ok && h.magic == CSR_FILE_MAGIC && h.version == CSR_FILE_VERSION &&
+         h.endian_tag == CSR_FILE_ENDIAN_TAG && h.index_bytes == 4 &&
+         h.n == 5 && h.nnz == 10 && h.row_ptr_off % CSR_FILE_ALIGN == 0 &&
+         h.col_idx_off % CSR_FILE_ALIGN == 0 && h.outdeg_off % CSR_FILE_ALIGN == 0;
+    printf("Header: %s\n", ok ? "magic, version and aligned sections" : "bad");
+    
+    // Full and partial loads point into the mapping
+    CSR g, g_partial;
+    ok = ok && load_full("test_P_CSR.bin", &g) == 0;
+    if (ok) {
+        ok = (g.map != NULL && g.n == 5 && g.nnz == 10 &&
+              memcmp(g.row_ptr, expected_row_ptr, sizeof(expected_row_ptr)) == 0 &&
+              memcmp(g.col_idx, expected_col_idx, sizeof(expected_col_idx)) == 0 &&
+              memcmp(g.outdeg, expected_outdeg, sizeof(expected_outdeg)) == 0);
+        csr_free(&g);
+    }
+    ok = ok && load_rows("test_P_CSR.bin", 2, 4, &g_partial) == 0;
+    if (ok) {
+        ok = (g_partial.map != NULL && g_partial.n == 2 && g_partial.nnz == 5 &&
+              g_partial.row_ptr[0] == 0 && g_partial.row_ptr[1] == 3 &&
+              g_partial.row_ptr[2] == 5 && g_partial.col_idx[0] == 0 &&
+              g_partial.col_idx[4] == 4 && g_partial.outdeg[1] == 2);
+        csr_free(&g_partial);
+    }
+    printf("Mapped loads: %s\n", ok ? "correct" : "wrong");
+    
+    // A version 1 file (bare n, nnz, row_ptr, col_idx, outdeg) still loads
+    int32_t header_v1[2] = {5, 10};
+    fp = fopen("test_v1_CSR.bin", "wb");
+    if (fp) {
+        fwrite(header_v1, sizeof(int32_t), 2, fp);
+        fwrite(expected_row_ptr, sizeof(int32_t), 6, fp);
+        fwrite(expected_col_idx, sizeof(int32_t), 10, fp);
+        fwrite(expected_outdeg, sizeof(int32_t), 5, fp);
+        fclose(fp);
+    }
+    int32_t n = 0, nnz = 0;
+    ok = ok && csr_file_info("test_v1_CSR.bin", &n, &nnz) == 0 && n == 5 && nnz == 10 &&
+         csr_verify("test_v1_CSR.bin") == 0 && load_full("test_v1_CSR.bin", &g) == 0;
+    if (ok) {
+        ok = (g.map == NULL &&
+              memcmp(g.col_idx, expected_col_idx, sizeof(expected_col_idx)) == 0);
+        csr_free(&g);
+    }
+    ok = ok && load_rows("test_v1_CSR.bin", 2, 4, &g_partial) == 0;
+    if (ok) {
+        ok = (g_partial.map == NULL && g_partial.nnz == 5 && g_partial.col_idx[0] == 0);
+        csr_free(&g_partial);
+    }
+    printf("Version 1 file: %s\n", ok ? "still readable" : "not readable");
+    
+    // A flipped data byte fails verification; a truncated file fails to load
+    ok = ok && csr_verify("test_P_CSR.bin") == 0 &&
+         copy_file_bytes("test_P_CSR.bin", "test_bad_CSR.bin", (long)h.col_idx_off + 5, -1) &&
+         csr_verify("test_bad_CSR.bin") != 0 &&
+         copy_file_bytes("test_P_CSR.bin", "test_bad_CSR.bin", -1, (long)h.outdeg_off) &&
+         load_full("test_bad_CSR.bin", &g) != 0;
+    printf("Corruption: %s\n", ok ? "detected" : "missed");
+    
+    if (ok) {
+        print_pass("Mapped CSR File");
+    } else {
+        print_fail("Mapped CSR File", "Version 2 file or loaders misbehave");
+    }
+}
+
+void test_17_compressed_file() {
+    print_test_header("17. Compressed CSR File");
+    
+    // Test 1's graph and test 15's (repeated targets, dangling rows, several
+    // blocks); the kernels must give bit-identical results from both files
+    const char *plain[2] = {"test_P_CSR.bin", "test_seq_CSR.bin"};
+    int ok = 1;
+    
+    for (int f = 0; ok && f < 2; f++) {
+        CSR g, gz;
+        ok = csr_compress_file(plain[f], "test_Z_CSR.bin") == 0 &&
+             csr_verify("test_Z_CSR.bin") == 0 &&
+             load_full(plain[f], &g) == 0;
+        if (!ok) break;
+        ok = load_full("test_Z_CSR.bin", &gz) == 0;
+        if (!ok) {
+            csr_free(&g);
+            break;
+        }
+        ok = (gz.adj != NULL && gz.col_idx == NULL && gz.n == g.n && gz.nnz == g.nnz);
+        
+        struct stat st_plain, st_z;
+        stat(plain[f], &st_plain);
+        stat("test_Z_CSR.bin", &st_z);
+        printf("%s: n = %d, nnz = %d, %ld -> %ld bytes\n", plain[f], g.n, g.nnz,
+               (long)st_plain.st_size, (long)st_z.st_size);
+        
+        int32_t n = g.n;
+        double *pi = malloc(n * sizeof(double));
+        double *out = calloc(n, sizeof(double));
+        double *out_z = calloc(n, sizeof(double));
+        for (int32_t i = 0; i < n; i++) pi[i] = (double)(i % 7 + 1) / (4.0 * n);
+        
+        double dangling = 0.0, dangling_z = 0.0;
+        if (ok) {
+            ppi_step_full(&g, pi, out, &dangling);
+            ppi_step_full(&gz, pi, out_z, &dangling_z);
+            ok = (memcmp(out, out_z, n * sizeof(double)) == 0 && dangling == dangling_z);
+        }
+        
+        // Row ranges that start and end inside blocks
+        int32_t cuts[4] = {0, n / 3 + 5, n - 2, n};
+        if (n < 8) cuts[1] = 1, cuts[2] = 3;
+        for (int c = 0; ok && c < 3; c++) {
+            CSR part, part_z;
+            memset(out, 0, n * sizeof(double));
+            memset(out_z, 0, n * sizeof(double));
+            ok = load_rows(plain[f], cuts[c], cuts[c + 1], &part) == 0;
+            if (!ok) break;
+            ok = load_rows("test_Z_CSR.bin", cuts[c], cuts[c + 1], &part_z) == 0;
+            if (ok) {
+                ppi_step_partial(&part, pi, cuts[c], cuts[c + 1], out, &dangling);
+                ppi_step_partial(&part_z, pi, cuts[c], cuts[c + 1], out_z, &dangling_z);
+                ok = (part_z.nnz == part.nnz && dangling == dangling_z &&
+                      memcmp(out, out_z, n * sizeof(double)) == 0);
+                csr_free(&part_z);
+            }
+            csr_free(&part);
+        }
+        printf("Kernels: %s\n", ok ? "bit-identical" : "different");
+        
+        free(pi);
+        free(out);
+        free(out_z);
+        csr_free(&g);
+        csr_free(&gz);
+        ok = ok && gz.adj == NULL && gz.adj_skip == 0 && gz.map == NULL;
+        csr_free(&gz);      // a freed struct may be freed again
+    }
+    
+    // Compressing twice is refused
+    ok = ok && csr_compress_file("test_Z_CSR.bin", "test_Z2_CSR.bin") != 0;
+    
+    if (ok) {
+        print_pass("Compressed CSR File");
+    } else {
+        print_fail("Compressed CSR File", "Compressed file differs from the plain one");
+    }
+}
+
+// Lines of a text file (at most max_lines, each under 512 bytes)
+static int read_lines(const char *path, char lines[][512], int max_lines) {
+    FILE *fp = fopen(path, "r");
+    int count = 0;
+    while (fp && count < max_lines && fgets(lines[count], 512, fp)) count++;
+    if (fp) fclose(fp);
+    return count;
+}
+
+void test_18_vertex_reordering() {
+    print_test_header("18. Vertex Reordering");
+    
+    // Test 15's graph: same edges and nodes lines after each reorder (seen
+    // through perm), and P * pi equal up to rounding
+    static char before[3100][512], after[3100][512];
+    int ok = copy_file_bytes("test_seq_CSR.bin", "test_ord_CSR.bin", -1, -1) &&
+             copy_file_bytes("test_seq_nodes.txt", "test_ord_nodes.txt", -1, -1);
+    remove("test_ord_perm.bin");
+    int lines = read_lines("test_seq_nodes.txt", before, 3100);
+    
+    CSR g;
+    ok = ok && load_full("test_seq_CSR.bin", &g) == 0;
+    if (!ok) {
+        print_fail("Vertex Reordering", "Could not set up the test graph");
+        return;
+    }
+    int32_t n = g.n;
+    double *pi = malloc(n * sizeof(double)), *pi_r = malloc(n * sizeof(double));
+    double *out = malloc(n * sizeof(double)), *out_r = malloc(n * sizeof(double));
+    for (int32_t i = 0; i < n; i++) pi[i] = (double)(i % 11 + 1) / (6.0 * n);
+    double dangling, dangling_r;
+    ppi_step_full(&g, pi, out, &dangling);
+    
+    int orders[2] = {CSR_ORDER_DEGREE, CSR_ORDER_RCM};
+    for (int o = 0; ok && o < 2; o++) {
+        int32_t perm_n = 0, *perm = NULL;
+        CSR gr;
+        ok = csr_reorder("test_ord_CSR.bin", "test_ord_nodes.txt", "test_ord_perm.bin",
+                         orders[o]) == 0 &&
+             csr_verify("test_ord_CSR.bin") == 0 &&
+             csr_load_perm("test_ord_perm.bin", &perm_n, &perm) == 0 && perm_n == n &&
+             read_lines("test_ord_nodes.txt", after, 3100) == lines &&
+             load_full("test_ord_CSR.bin", &gr) == 0;
+        if (!ok) {
+            free(perm);
+            break;
+        }
+        
+        // Row i of the built graph is row perm[i] now, with its targets renumbered
+        int32_t edges = 0;
+        for (int32_t i = 0; ok && i < n; i++) {
+            int32_t r = perm[i];
+            ok = (strcmp(before[i], after[r]) == 0 && gr.outdeg[r] == g.outdeg[i]);
+            for (int32_t k = g.row_ptr[i]; ok && k < g.row_ptr[i + 1]; k++) {
+                int found = 0;
+                for (int32_t m = gr.row_ptr[r]; !found && m < gr.row_ptr[r + 1]; m++) {
+                    found = (gr.col_idx[m] == perm[g.col_idx[k]]);
+                }
+                ok = found;
+                edges++;
+            }
+        }
+        ok = ok && edges == gr.nnz;
+        
+        for (int32_t i = 0; ok && i < n; i++) pi_r[perm[i]] = pi[i];
+        if (ok) ppi_step_full(&gr, pi_r, out_r, &dangling_r);
+        for (int32_t i = 0; ok && i < n; i++) {
+            ok = fabs(out_r[perm[i]] - out[i]) <= 1e-12 * fabs(out[i]);
+        }
+        ok = ok && fabs(dangling_r - dangling) <= 1e-12;
+        printf("%s order: %s\n", o == 0 ? "Degree" : "RCM", ok ? "consistent" : "inconsistent");
+        
+        free(perm);
+        csr_free(&gr);
+    }
+    
+    free(pi);
+    free(pi_r);
+    free(out);
+    free(out_r);
+    csr_free(&g);
+    
+    if (ok) {
+        print_pass("Vertex Reordering");
+    } else {
+        print_fail("Vertex Reordering", "Reordered graph does not match the original");
+    }
+}
+
 int main() {
     printf("========================================\n");
     printf("CSR Implementation Comprehensive Tests\n");
@@ -615,6 +1099,12 @@ int main() {
     test_10_csr_free_no_crash();
     test_11_zero_vector();
     test_12_normalized_vector();
+    test_13_binary_edge_list();
+    test_14_long_lines();
+    test_15_parallel_build();
+    test_16_mapped_file_format();
+    test_17_compressed_file();
+    test_18_vertex_reordering();
     
     printf("\n========================================\n");
     printf("TEST SUMMARY\n");
@@ -640,6 +1130,23 @@ int main() {
     remove("test_multi_dangling.txt");
     remove("test_multi_dangling_CSR.bin");
     remove("test_multi_dangling_nodes.txt");
+    remove("test_file_links.bin");
+    remove("test_edges_CSR.bin");
+    remove("test_edges_nodes.txt");
+    remove("test_long_links.txt");
+    remove("test_long_CSR.bin");
+    remove("test_long_nodes.txt");
+    remove("test_parallel_links.txt");
+    remove("test_seq_CSR.bin");
+    remove("test_seq_nodes.txt");
+    remove("test_par_CSR.bin");
+    remove("test_par_nodes.txt");
+    remove("test_v1_CSR.bin");
+    remove("test_bad_CSR.bin");
+    remove("test_Z_CSR.bin");
+    remove("test_ord_CSR.bin");
+    remove("test_ord_nodes.txt");
+    remove("test_ord_perm.bin");
     
     return tests_failed > 0 ? 1 : 0;
 }
\ No newline at end of file
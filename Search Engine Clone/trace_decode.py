@@ -0,0 +1,112 @@
+import sys
+import struct
+import collections
+
+# Decoder for the binary event trace written by `multithreaded ... --trace FILE`
+# Layout (see LOGGING AND TRACING in Crawler.c):
+#   header:  uint32 magic "CTRC", uint32 version, uint32 record_size, uint32 reserved
+#   blocks:  int32 tid, uint32 count, then count records of
+#            uint64 ns, uint32 type, int32 a, int32 b, int32 reserved
+#   trailer: int32 -1, uint32 n, then n null-terminated node paths
+
+TRACE_MAGIC = 0x43525443
+HEADER = struct.Struct("<IIII")
+BLOCK = struct.Struct("<iI")
+RECORD = struct.Struct("<QIiii")
+
+EVENTS = {
+    1: "T-0 DIR-BEGIN",
+    2: "T-0 DIR-END",
+    3: "T-0 FILE",
+    4: "T-1 SCAN-BEGIN",
+    5: "T-1 SCAN-END",
+    6: "T-1 PHASE-DONE",
+    7: "T-1 INLINK",
+    8: "T-1 WRITE",
+}
+
+def read_trace(path):
+    """
+    Parses a trace file.
+    Returns: (list of (ns, tid, type, a, b) sorted by time, list of node paths)
+    """
+    with open(path, "rb") as f:
+        data = f.read()
+
+    magic, version, record_size, _ = HEADER.unpack_from(data, 0)
+    if magic != TRACE_MAGIC or version != 1 or record_size != RECORD.size:
+        raise ValueError(f"{path} is not a version 1 crawler trace")
+
+    events, paths = [], []
+    pos = HEADER.size
+    while pos + BLOCK.size <= len(data):
+        tid, count = BLOCK.unpack_from(data, pos)
+        pos += BLOCK.size
+        if tid == -1:
+            # Trailer: node paths in index order
+            for _ in range(count):
+                end = data.index(b"\0", pos)
+                paths.append(data[pos:end].decode("utf-8", "replace"))
+                pos = end + 1
+            break
+        for _ in range(count):
+            ns, etype, a, b, _ = RECORD.unpack_from(data, pos)
+            events.append((ns, tid, etype, a, b))
+            pos += RECORD.size
+
+    events.sort()
+    return events, paths
+
+def describe(etype, a, b, paths):
+    """Human-readable arguments of one event."""
+    name = lambda idx: paths[idx] if 0 <= idx < len(paths) else f"#{idx}"
+    if etype == 1:
+        return "stolen" if a else ""
+    if etype == 2:
+        return f"files={a} subdirs={b}"
+    if etype == 3:
+        return f"{name(a)}" + ("" if b else " (duplicate name)")
+    if etype == 4:
+        return name(a)
+    if etype == 5:
+        return f"{name(a)} outlinks={b}"
+    if etype == 6:
+        return f"phase {a}"
+    if etype == 7:
+        return f"{name(a)} <- {name(b)}"
+    if etype == 8:
+        return f"{a} bytes"
+    return f"a={a} b={b}"
+
+def print_summary(events, paths):
+    """Per-thread event counts and the slowest file scans."""
+    counts = collections.Counter((tid, etype) for _, tid, etype, _, _ in events)
+    threads = sorted({tid for _, tid, _, _, _ in events})
+    print("\n=== Events per thread ===")
+    for tid in threads:
+        parts = [f"{EVENTS.get(t, t)}={counts[(tid, t)]}" for t in sorted(EVENTS) if counts[(tid, t)]]
+        print(f"[{tid}] " + ", ".join(parts))
+
+    scan_start, scans = {}, []
+    for ns, tid, etype, a, _ in events:
+        if etype == 4:
+            scan_start[(tid, a)] = ns
+        elif etype == 5 and (tid, a) in scan_start:
+            scans.append((ns - scan_start.pop((tid, a)), a))
+    if scans:
+        print("\n=== Slowest scans ===")
+        for ns, idx in sorted(scans, reverse=True)[:10]:
+            print(f"{ns / 1000.0:10.1f} us  {paths[idx] if idx < len(paths) else idx}")
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Usage: python3 trace_decode.py <trace_file> [--summary]")
+        sys.exit(1)
+
+    events, paths = read_trace(sys.argv[1])
+    if "--summary" not in sys.argv[2:]:
+        base = events[0][0] if events else 0
+        for ns, tid, etype, a, b in events:
+            print(f"{(ns - base) / 1000.0:12.1f} us  [{tid}] {EVENTS.get(etype, etype):16} "
+                  f"{describe(etype, a, b, paths)}")
+    print_summary(events, paths)
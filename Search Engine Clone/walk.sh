@@ -7,7 +7,7 @@ mkdir -p files/subdir part-1-outputs
 echo "file_B.txt" > files/file_A.txt
 echo "file_C.txt" > files/file_B.txt
 echo "file_A.txt" > files/subdir/file_C.txt
-gcc -o multithreaded multithreaded.c -pthread -Wall 2>/dev/null
+gcc -o multithreaded multithreaded.c Crawler.c -pthread -Wall 2>/dev/null
 
 echo "╔═══════════════════════════════════════════════════════════════╗"
 echo "║            Execution Log & Timing Comparison                  ║"